@@ -13,6 +13,10 @@
 #include <sharp/Try/Try.hpp>
 #include <sharp/Concurrent/Concurrent.hpp>
 #include <sharp/Portability/cpp17.hpp>
+#include <sharp/Traits/Traits.hpp>
+#include <sharp/Functional/Functional.hpp>
+#include <sharp/Future/Future.hpp>
+#include <sharp/Utility/Utility.hpp>
 
 #include <mutex>
 #include <condition_variable>
@@ -23,9 +27,71 @@
 #include <initializer_list>
 #include <vector>
 #include <queue>
+#include <cstddef>
+#include <stdexcept>
 
 namespace sharp {
 
+/**
+ * Forward declarations for the select() machinery
+ */
+namespace channel_detail {
+    template <typename Channel, bool IsRead>
+    class ChannelCase;
+
+    /**
+     * Enable if the type is a channel, used to tell channel cases apart from
+     * the default case
+     */
+    template <typename Channel>
+    using EnableIfChannel = sharp::void_t<typename Channel::value_type>;
+
+    /**
+     * The waiter a blocked select registers with every channel it selects
+     * on.  It is flagged ready whenever one of those channels changes state.
+     * claimed is the channel the select has committed to, a select commits
+     * before it executes a case and a sender that goes through against one
+     * of its read cases commits it to that read
+     */
+    struct SelectState {
+        bool ready{false};
+        const void* claimed{nullptr};
+    };
+    using SelectWaiter = sharp::Concurrent<SelectState>;
+
+    /**
+     * Asynchronous operations that completed while the channel was locked,
+     * these fulfill promises and are run after the channel is unlocked
+     */
+    using Completions = std::vector<sharp::UniqueFunction<void()>>;
+    template <typename ConcurrentState>
+    class StateLock;
+} // namespace channel_detail
+
+/**
+ * Policies that can be passed in place of the mutex type to select a
+ * specialized implementation of the channel
+ *
+ * Spsc selects a lock free ring buffer for the case where there is exactly
+ * one sending thread and exactly one reading thread, see
+ * sharp/Channel/detail/SpscChannel.hpp
+ *
+ * Mpmc selects a lock free bounded ring buffer with per slot sequence numbers
+ * that any number of threads can send to and read from, see
+ * sharp/Channel/detail/MpmcChannel.hpp
+ */
+class Spsc {};
+class Mpmc {};
+
+/**
+ * The exception that is thrown on reading from a channel that has been
+ * closed and has no elements left, or on sending to a closed channel
+ */
+class ChannelClosedError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
 /**
  * A synchronous channel that can be used for synchronization across multiple
  * threads.  This is an implementation of channels as found in the Go
@@ -124,6 +190,11 @@ template <typename Type,
 class Channel {
 public:
 
+    /**
+     * The type of values sent across the channel
+     */
+    using value_type = Type;
+
     /**
      * The constructor of the channel sets the size of the internal buffer
      * that the channel will have.  And then this will affect the semantics of
@@ -239,6 +310,72 @@ public:
      */
     sharp::Try<Type> try_read_try();
 
+    /**
+     * Batch versions of send and read, these move as many elements as they
+     * can in one synchronization step on the channel and wake up waiting
+     * threads once per step rather than once per element
+     *
+     * send_batch() sends every element in the range, blocking when the
+     * channel is full.  Each element is constructed from *iterator so pass
+     * in move iterators to move elements into the channel.  The range
+     * overload accepts anything that works with std::begin() and std::end()
+     *
+     *      auto records = std::vector<Record>{...};
+     *      channel.send_batch(std::make_move_iterator(records.begin()),
+     *                         std::make_move_iterator(records.end()));
+     *
+     * read_batch() blocks until there is at least one element in the
+     * channel, and then writes up to max elements to the output iterator,
+     * returning the number of elements written.  try_read_batch() does the
+     * same but returns 0 instead of blocking when the channel is empty
+     *
+     *      auto records = std::vector<Record>{};
+     *      channel.read_batch(std::back_inserter(records), 1024);
+     *
+     * As with the single element versions, reads on a closed channel that
+     * has nothing left throw a ChannelClosedError, as do sends on a closed
+     * channel.  A batch read stops at the first element that holds an
+     * exception, the elements before it are written to the output iterator
+     * and their count is returned, and the element is left in the channel.
+     * When that element is the first one to be read the exception is thrown
+     */
+    template <typename InputIterator>
+    void send_batch(InputIterator first, InputIterator last);
+    template <typename Range>
+    void send_batch(Range&& range);
+    template <typename OutputIterator>
+    std::size_t read_batch(OutputIterator out, std::size_t max);
+    template <typename OutputIterator>
+    std::size_t try_read_batch(OutputIterator out, std::size_t max);
+
+    /**
+     * Asynchronous versions of read and send, these never block the calling
+     * thread.  Instead of parking a thread, an operation that cannot finish
+     * right away is queued in the channel as a promise and the returned
+     * future is fulfilled when the operation goes through, so any number of
+     * logical readers and senders can wait on a channel without taking up a
+     * thread each
+     *
+     *      channel.async_read().via(&executor).then([](auto future) {
+     *          auto value = future.get();
+     *      });
+     *
+     * The future returned by async_send() holds a sharp::Unit once the value
+     * is in the channel, which is the same point at which send() returns.
+     * Operations that cannot complete because the channel is closed fail
+     * with a ChannelClosedError in the future, this includes operations that
+     * were queued before the close
+     *
+     * Queued operations are served in order and before blocked threads are
+     * woken up.  Continuations attached to the futures run on the thread
+     * that completed the operation, always after it releases the channel's
+     * lock, so they are free to use the channel.  Pass the futures through
+     * via() to run continuations on an executor instead
+     */
+    sharp::Future<Type> async_read();
+    sharp::Future<sharp::Unit> async_send(const Type& value);
+    sharp::Future<sharp::Unit> async_send(Type&& value);
+
     /**
      * Iterator class for the channel
      *
@@ -259,6 +396,12 @@ public:
      * Close the channel and mark the channel as a completed range, after this
      * point any read will throw an exception and any iteration will stop
      * after reading in all the elements that are currently in the channel
+     *
+     * More precisely, reads still return the elements that were sent before
+     * the close and after that they throw a ChannelClosedError (or return a
+     * Try containing one for the Try returning variants).  Sends after a
+     * close throw a ChannelClosedError, including sends that were blocked at
+     * the time of the close.  Closing a channel more than once is fine
      */
     void close();
 
@@ -270,12 +413,12 @@ public:
     bool is_closed();
 
     /**
-     * Make friends with the select function, each select operation waits on a
-     * monitor for the channel to either have a ready value or to be ready for
-     * writing
+     * Make friends with the cases of the select function, each select
+     * operation registers a waiter with every channel it selects on and
+     * sleeps till one of the channels changes state
      */
-    template <typename... Cases>
-    friend void select(Cases&&...);
+    template <typename Ch, bool IsRead>
+    friend class channel_detail::ChannelCase;
 
 private:
 
@@ -283,6 +426,18 @@ private:
     void send_impl(EnqueueFunc enqueue);
     template <typename EnqueueFunc>
     bool try_send_impl(EnqueueFunc enqueue);
+    template <typename Value>
+    sharp::Future<sharp::Unit> async_send_impl(Value&& value);
+
+    /**
+     * All access to the state goes through these, they lock the state like
+     * the methods on Concurrent do and additionally complete any queued
+     * asynchronous operations that can go through before the lock is
+     * released.  The promises for those are fulfilled after unlocking
+     */
+    auto lock();
+    template <typename Func>
+    decltype(auto) synchronized(Func&& func);
 
     /**
      * The number of objects the internal queue can hold without blocking,
@@ -295,14 +450,24 @@ private:
          * Helper methods to execute operations on the state
          */
         bool can_read_succeed() const noexcept;
-        bool can_write_succeed() const noexcept;
+        bool can_write_succeed() const;
+        template <typename EnqueueFunc>
+        bool write(EnqueueFunc enqueue,
+                   channel_detail::SelectWaiter* self = nullptr);
         auto read();
+        void notify_selects();
+        void check_closed() const;
+        template <typename OutputIterator>
+        std::size_t read_batch(OutputIterator& out, std::size_t max);
+        void settle(channel_detail::Completions& completions);
 
         explicit State(int buffer_length) : open_slots{buffer_length} {}
 
         /**
          * The number of open slots in the current buffer corresponds to the
-         * number of readers waiting + the buffer length
+         * number of readers waiting + the buffer length - the number of
+         * elements in the queue.  A select waiting on a read is not counted
+         * till a sender commits it to the read, see write()
          *
          * The queue of objects or exceptions, represented conveniently using
          * sharp::Try, see sharp/Try/README.md for documentation and usage
@@ -314,13 +479,41 @@ private:
         std::queue<sharp::Try<Type>> elements;
 
         /**
-         * A list of select statements that depend on this channel
+         * A list of select statements that are waiting on this channel, each
+         * is flagged and woken up when the state of the channel changes.
+         * The ones waiting to read are also kept separately for senders that
+         * find no open slot.  These live on the stack of the selecting thread
+         * and remove themselves before select() returns
          */
-        std::vector<std::shared_ptr<sharp::Concurrent<bool, Mutex, Cv>>> selects;
+        std::vector<channel_detail::SelectWaiter*> selects;
+        std::vector<channel_detail::SelectWaiter*> read_selects;
+
+        /**
+         * Asynchronous reads and sends that are waiting for the channel, in
+         * the order they were made.  A queued read is advertised in the open
+         * slots just like a blocked read.  The values for queued sends are
+         * held here until there is room for them in the channel
+         */
+        struct AsyncSend {
+            sharp::Try<Type> value;
+            sharp::Promise<sharp::Unit> promise;
+        };
+        std::deque<sharp::Promise<Type>> async_reads;
+        std::deque<AsyncSend> async_sends;
+
+        /**
+         * Set when the channel is closed, see close()
+         */
+        bool closed{false};
     };
     sharp::Concurrent<State> state;
 };
 
+/**
+ * Tag used to make the default case for a select statement
+ */
+class default_case : public GeneralizedTag<default_case> {};
+
 /**
  * The select() and the case functions to allow multiplexing on I/O through a
  * channel.
@@ -328,12 +521,38 @@ private:
  * Based on the type of the function passed in to the function call the
  * select method implicitly decides whether the channel is being used to
  * wait on a read or a write operation, and multiplexes I/O based on that
+ *
+ * Exactly one case is executed.  The cases are tried in a random order each
+ * time so that no channel is starved when more than one is ready.  If none
+ * of them is ready then the calling thread registers a single waiter with
+ * all the channels and goes to sleep until one of them changes state, there
+ * is no polling involved.  A write callable is invoked with the channel
+ * locked, so it should not touch the same channel, a read callable is
+ * invoked after the channel has been unlocked
+ *
+ * A sender on an unbuffered channel can go through against a select waiting
+ * to read from it, doing so commits the select to that read, so the value is
+ * never left behind by a select that picks another case
+ *
+ * A default case makes the select non blocking, if no other case is ready
+ * right away then the default case is executed and select returns, just
+ * like in Go
+ *
+ *      sharp::select(
+ *          sharp::make_case(channel, [](auto value) { ... }),
+ *          sharp::make_case(sharp::default_case::tag, []() { ... })
+ *      );
  */
 template <typename... Cases>
 void select(Cases&&... cases);
-template <typename ChannelType, typename Func>
+template <typename ChannelType, typename Func,
+          channel_detail::EnableIfChannel<ChannelType>* = nullptr>
 auto make_case(ChannelType&, Func&& func);
+template <typename Func>
+auto make_case(default_case::tag_t, Func&& func);
 
 } // namespace sharp
 
 #include <sharp/Channel/Channel.ipp>
+#include <sharp/Channel/detail/SpscChannel.hpp>
+#include <sharp/Channel/detail/MpmcChannel.hpp>
@@ -4,16 +4,118 @@
 #include <sharp/Traits/Traits.hpp>
 #include <sharp/ForEach/ForEach.hpp>
 
+#include <algorithm>
+#include <array>
 #include <condition_variable>
+#include <deque>
 #include <initializer_list>
 #include <mutex>
 #include <exception>
+#include <random>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 namespace sharp {
 
 namespace channel_detail {
 
+    /**
+     * The exception stored in Try objects read from a closed channel
+     */
+    inline std::exception_ptr make_closed_exception() {
+        return std::make_exception_ptr(ChannelClosedError{
+            "sharp::Channel read from a closed channel"});
+    }
+
+    /**
+     * The lock returned by Channel::lock(), this acts like the lock proxy
+     * returned by Concurrent::lock() except that before the lock is released
+     * (either on unlock or before going to sleep in wait()) the queued
+     * asynchronous operations on the channel are completed, and the promises
+     * for those are fulfilled after the lock has been released
+     *
+     * Fulfilling a promise runs the continuations attached to its future, so
+     * doing that with the lock held would deadlock any continuation that
+     * goes back to the channel
+     */
+    template <typename ConcurrentState>
+    class StateLock {
+    public:
+        explicit StateLock(ConcurrentState& concurrent_in)
+                : concurrent{concurrent_in} {
+            this->proxy.emplace(this->concurrent.lock());
+        }
+        StateLock(StateLock&& other)
+                : concurrent{other.concurrent},
+                  proxy{std::move(other.proxy)} {
+            other.proxy.reset();
+        }
+        ~StateLock() {
+            this->unlock();
+        }
+
+        void unlock() {
+            if (!this->proxy) {
+                return;
+            }
+
+            auto completions = Completions{};
+            (*this->proxy)->settle(completions);
+            this->proxy.reset();
+            for (auto& completion : completions) {
+                completion();
+            }
+        }
+
+        template <typename Condition>
+        void wait(Condition condition) {
+            // the lock is released while waiting, so run whatever completed
+            // so far first, the state has to be settled before other threads
+            // see it and this thread might be asleep for a while
+            while (true) {
+                auto completions = Completions{};
+                (*this->proxy)->settle(completions);
+                if (completions.empty()) {
+                    break;
+                }
+
+                this->proxy.reset();
+                for (auto& completion : completions) {
+                    completion();
+                }
+                this->proxy.emplace(this->concurrent.lock());
+            }
+
+            this->proxy->wait(condition);
+        }
+
+        auto operator->() {
+            return (*this->proxy).operator->();
+        }
+        auto& operator*() {
+            return *(*this->proxy);
+        }
+
+    private:
+        using Proxy = decltype(std::declval<ConcurrentState&>().lock());
+
+        ConcurrentState& concurrent;
+        std::optional<Proxy> proxy;
+    };
+
+    /**
+     * Fulfill a promise with the value or exception in a Try
+     */
+    template <typename Type>
+    void fulfill(sharp::Promise<Type>& promise, sharp::Try<Type>& value) {
+        if (value.has_exception()) {
+            promise.set_exception(value.exception());
+        } else {
+            promise.set_value(std::move(value).value());
+        }
+    }
+
     /**
      * Concepts(ish)
      */
@@ -24,43 +126,302 @@ namespace channel_detail {
     template <typename Channel, typename Func>
     using EnableIfRead = sharp::void_t<decltype(
         std::declval<Func>()(std::declval<typename Channel::value_type>()))>;
+    /**
+     * Enable if the function is a write function, i.e. it accepts no
+     * arguments and returns something that can be sent over the channel
+     */
+    template <typename Channel, typename Func>
+    using EnableIfWrite = std::enable_if_t<std::is_convertible<
+        decltype(std::declval<Func>()()),
+        typename Channel::value_type>::value>;
+
+    /**
+     * A type erased handle to a case in a select statement, this lets the
+     * select implementation shuffle and iterate through the cases at runtime
+     * without caring about what the cases are
+     */
+    class SelectCase {
+    public:
+        template <typename Case>
+        explicit SelectCase(Case& case_in)
+            : instance{&case_in},
+              try_execute_impl{[](void* c, SelectWaiter& waiter) {
+                  return static_cast<Case*>(c)->try_execute(waiter);
+              }},
+              add_waiter_impl{[](void* c, SelectWaiter& waiter) {
+                  static_cast<Case*>(c)->add_waiter(waiter);
+              }},
+              remove_waiter_impl{[](void* c, SelectWaiter& waiter) {
+                  static_cast<Case*>(c)->remove_waiter(waiter);
+              }},
+              is_default{Case::is_default} {}
+
+        bool try_execute(SelectWaiter& waiter) {
+            return this->try_execute_impl(this->instance, waiter);
+        }
+        void add_waiter(SelectWaiter& waiter) {
+            this->add_waiter_impl(this->instance, waiter);
+        }
+        void remove_waiter(SelectWaiter& waiter) {
+            this->remove_waiter_impl(this->instance, waiter);
+        }
+
+        void* instance;
+        bool (*try_execute_impl)(void*, SelectWaiter&);
+        void (*add_waiter_impl)(void*, SelectWaiter&);
+        void (*remove_waiter_impl)(void*, SelectWaiter&);
+        bool is_default;
+    };
+
+    /**
+     * Commits a select to a write on the channel, this fails if the select
+     * has already committed to something else, including a read on the same
+     * channel that a sender went through against
+     */
+    inline bool commit_write(SelectWaiter& waiter, const void* channel) {
+        return waiter.synchronized([&](auto& state) {
+            if (state.claimed) {
+                return false;
+            }
+            state.claimed = channel;
+            return true;
+        });
+    }
+
+    /**
+     * Registering and unregistering waiters is the same for reads and writes
+     * except that a reader is also offered to senders that find no open
+     * slot, so that a writer on an unbuffered channel can go through and
+     * rendezvous with the select.  The reader is not counted as an open slot
+     * because the select might still pick another case, a sender going
+     * through against it commits it to the read instead
+     */
+    template <typename Channel, bool IsRead>
+    class ChannelCase {
+    public:
+        static constexpr auto is_default = false;
+
+        explicit ChannelCase(Channel& channel_in) : channel{channel_in} {}
+
+        void add_waiter(SelectWaiter& waiter) {
+            this->synchronized([&](auto& state) {
+                if (IsRead) {
+                    state.notify_selects();
+                    state.read_selects.push_back(&waiter);
+                }
+                state.selects.push_back(&waiter);
+            });
+        }
+        void remove_waiter(SelectWaiter& waiter) {
+            this->synchronized([&](auto& state) {
+                for (auto selects : {&state.selects, &state.read_selects}) {
+                    selects->erase(std::remove(selects->begin(),
+                                selects->end(), &waiter), selects->end());
+                }
+            });
+        }
+
+    protected:
+        /**
+         * Run the function on the locked state of the channel
+         */
+        template <typename Func>
+        decltype(auto) synchronized(Func&& func) {
+            return this->channel.synchronized(std::forward<Func>(func));
+        }
+
+        Channel& channel;
+    };
+
+    /**
+     * A read case, the value is moved out of the channel with the channel
+     * locked and the callable is invoked after unlocking it
+     */
+    template <typename Channel, typename Func>
+    class ReadCase : public ChannelCase<Channel, true> {
+    public:
+        template <typename F>
+        ReadCase(Channel& channel_in, F&& func_in)
+            : ChannelCase<Channel, true>{channel_in},
+              func{std::forward<F>(func_in)} {}
+
+        bool try_execute(SelectWaiter& waiter) {
+            auto value = this->synchronized([&](auto& state) {
+                using Value = sharp::Try<typename Channel::value_type>;
+
+                // a read on a closed channel is always ready, and it throws
+                // when the callable is invoked
+                auto ready = state.can_read_succeed() || state.closed;
+                auto committed = false;
+                auto owed = waiter.synchronized([&](auto& select) {
+                    if (select.claimed && select.claimed != &state) {
+                        return false;
+                    }
+                    committed = ready;
+                    auto owed = (select.claimed == &state);
+                    select.claimed = ready ? &state : select.claimed;
+                    return owed;
+                });
+                if (!committed) {
+                    return Value{nullptr};
+                }
+
+                // a sender that went through against this read already
+                // counted it as a waiting reader, a read that was not owed a
+                // value frees up a slot in the channel instead
+                if (!state.can_read_succeed()) {
+                    if (owed) {
+                        --state.open_slots;
+                    }
+                    return Value{make_closed_exception()};
+                }
+                if (!owed) {
+                    ++state.open_slots;
+                    state.notify_selects();
+                }
+                return Value{state.read()};
+            });
+
+            if (!value.valid()) {
+                return false;
+            }
+            this->func(std::move(value).get());
+            return true;
+        }
+
+    private:
+        Func func;
+    };
+
+    /**
+     * A write case, the callable is invoked only when the write can go
+     * through and with the channel locked
+     */
     template <typename Channel, typename Func>
-    using EnableIfWrite = sharp::void_t<decltype(std::declval<Func>())>;
+    class WriteCase : public ChannelCase<Channel, false> {
+    public:
+        template <typename F>
+        WriteCase(Channel& channel_in, F&& func_in)
+            : ChannelCase<Channel, false>{channel_in},
+              func{std::forward<F>(func_in)} {}
+
+        bool try_execute(SelectWaiter& waiter) {
+            return this->synchronized([&](auto& state) {
+                if (state.closed) {
+                    if (!commit_write(waiter, &state)) {
+                        return false;
+                    }
+                    throw ChannelClosedError{"sharp::select() tried to send "
+                        "to a closed channel"};
+                }
+
+                auto written = state.write([&](auto& elements) {
+                    elements.emplace(this->func());
+                }, &waiter);
+                if (written) {
+                    state.notify_selects();
+                }
+                return written;
+            });
+        }
+
+    private:
+        Func func;
+    };
+
+    /**
+     * The default case, always succeeds and is only ever tried after all
+     * the other cases have been tried once
+     */
+    template <typename Func>
+    class DefaultCase {
+    public:
+        static constexpr auto is_default = true;
+
+        template <typename F>
+        explicit DefaultCase(F&& func_in) : func{std::forward<F>(func_in)} {}
+
+        bool try_execute(SelectWaiter&) {
+            this->func();
+            return true;
+        }
+        void add_waiter(SelectWaiter&) {}
+        void remove_waiter(SelectWaiter&) {}
+
+    private:
+        Func func;
+    };
 
     /**
      * Specializations for the make_case function that wrap the callable
-     * around a speculative reader/writer that 1 operates under the assumption
-     * that the channel in question is already locked and 2 succeeds only when
-     * either the read or write could go through
+     * in either a read or a write case based on its signature
      */
     template <typename Channel, typename Func,
               EnableIfRead<Channel, Func>* = nullptr>
     auto make_case_impl(Channel& channel, Func&& func) {
-        // returns a pair of the channel itself and a callable that accepts
-        // the state of the concurrent object as a parameter and if a read can
-        // succeed, it reads from the channel and invokes the fucntion passed
-        // with the read value as a parameter
-        return std::make_pair(std::ref(channel), [&](auto& state) {
-            if (state.can_read_succeed()) {
-                std::forward<Func>(func)(state.read());
-                return true;
-            }
-            return false;
-        });
+        return ReadCase<Channel, std::decay_t<Func>>{
+            channel, std::forward<Func>(func)};
     }
     template <typename Channel, typename Func,
               EnableIfWrite<Channel, Func>* = nullptr>
     auto make_case_impl(Channel& channel, Func&& func) {
-        // return a pair of the channel itself and a callable that writes the
-        // value into the channel if the channel is ready
-        return std::make_pair(std::ref(channel), [&](auto& state) {
-            if (state.can_write_succeed()) {
-                state.elements.emplace(std::forward<Func>(func)());
-                return true;
-            }
-            return false;
+        return WriteCase<Channel, std::decay_t<Func>>{
+            channel, std::forward<Func>(func)};
+    }
+
+    /**
+     * The non template part of select()
+     *
+     * The cases are tried in a random order once, if none succeed then the
+     * default case is executed if there is one.  Otherwise a waiter is
+     * registered with every channel and the cases are retried every time
+     * the waiter is woken up.  Since the waiter is registered before the
+     * retry and every change to a channel flags all of its waiters under the
+     * channel's lock, no state change can be missed between a failed retry
+     * and going to sleep
+     *
+     * Once a sender has committed the select to one of its reads every other
+     * case fails, so the select keeps waiting for that read
+     */
+    inline void select_impl(SelectCase* begin, SelectCase* end) {
+        thread_local auto engine = std::minstd_rand{std::random_device{}()};
+
+        // move the default case (if any) to the end, it is tried last
+        auto last = std::partition(begin, end, [](auto& c) {
+            return !c.is_default;
         });
+        assert((end - last) <= 1);
+
+        SelectWaiter waiter;
+        auto try_all = [&]() {
+            std::shuffle(begin, last, engine);
+            return std::any_of(begin, last, [&](auto& c) {
+                return c.try_execute(waiter);
+            });
+        };
+
+        if (try_all()) {
+            return;
+        }
+        if (last != end) {
+            last->try_execute(waiter);
+            return;
+        }
+
+        std::for_each(begin, last, [&](auto& c) { c.add_waiter(waiter); });
+        auto deferred = sharp::defer([&]() {
+            std::for_each(begin, last, [&](auto& c) {
+                c.remove_waiter(waiter);
+            });
+        });
+
+        while (!try_all()) {
+            auto lock = waiter.lock();
+            lock.wait([](auto& state) { return state.ready; });
+            lock->ready = false;
+        }
     }
+
 } // namespace channel_detail
 
 template <typename Type, typename Mutex, typename Cv>
@@ -114,21 +475,28 @@ Type Channel<Type, Mutex, Cv>::read() {
 template <typename Type, typename Mutex, typename Cv>
 sharp::Try<Type> Channel<Type, Mutex, Cv>::read_try() {
     // wait for the elements to have an element and then read it
-    auto state = this->state.lock();
+    auto state = this->lock();
 
     // increment the number of open slots before going to bed because there is
     // now a read which is possibly waiting for a write to go through on the
     // other end
     ++(state->open_slots);
+    state->notify_selects();
 
     // sleep af if the elements queue is empty
     state.wait([](auto& state) {
-        return state.can_read_succeed();
+        return state.can_read_succeed() || state.closed;
     });
 
+    // elements sent before the channel was closed can still be read, after
+    // that the read is no longer waiting so give its slot back
+    if (!state->can_read_succeed()) {
+        --(state->open_slots);
+        return channel_detail::make_closed_exception();
+    }
+
     // return the first element and pop af
-    auto deferred = sharp::defer([&]() { state->elements.pop(); });
-    return std::move(state->elements.front());
+    return state->read();
 }
 
 template <typename Type, typename Mutex, typename Cv>
@@ -143,24 +511,152 @@ std::optional<Type> Channel<Type, Mutex, Cv>::try_read() {
 
 template <typename Type, typename Mutex, typename Cv>
 sharp::Try<Type> Channel<Type, Mutex, Cv>::try_read_try() {
-    return this->state.synchronized([](auto& state) -> sharp::Try<Type> {
-        if (!state.elements.empty()) {
+    return this->synchronized([](auto& state) -> sharp::Try<Type> {
+        if (state.can_read_succeed()) {
+            // a read frees up a slot in the channel
+            ++state.open_slots;
+            state.notify_selects();
             return state.read();
+        } else if (state.closed) {
+            return channel_detail::make_closed_exception();
         } else {
             return nullptr;
         }
     });
 }
 
+template <typename Type, typename Mutex, typename Cv>
+template <typename InputIterator>
+void Channel<Type, Mutex, Cv>::send_batch(InputIterator first,
+                                          InputIterator last) {
+    while (first != last) {
+        auto state = this->lock();
+        state->check_closed();
+        state.wait([](auto& state) {
+            return state.can_write_succeed() || state.closed;
+        });
+        state->check_closed();
+
+        // write as many elements as there are open slots for, the waiters
+        // are notified once when the lock is released
+        for (; first != last; ++first) {
+            auto written = state->write([&](auto& elements) {
+                elements.emplace(std::in_place, *first);
+            });
+            if (!written) {
+                break;
+            }
+        }
+        state->notify_selects();
+    }
+}
+
+template <typename Type, typename Mutex, typename Cv>
+template <typename Range>
+void Channel<Type, Mutex, Cv>::send_batch(Range&& range) {
+    using std::begin;
+    using std::end;
+    this->send_batch(begin(range), end(range));
+}
+
+template <typename Type, typename Mutex, typename Cv>
+template <typename OutputIterator>
+std::size_t Channel<Type, Mutex, Cv>::read_batch(OutputIterator out,
+                                                 std::size_t max) {
+    if (!max) {
+        return 0;
+    }
+
+    // advertise a waiting reader like read_try() does and take it back
+    // once there is something to read, read_batch() on the state gives
+    // back one slot for each element read
+    auto state = this->lock();
+    ++(state->open_slots);
+    state->notify_selects();
+    state.wait([](auto& state) {
+        return state.can_read_succeed() || state.closed;
+    });
+    --(state->open_slots);
+
+    if (!state->can_read_succeed()) {
+        throw ChannelClosedError{"sharp::Channel::read_batch() called on a "
+            "closed channel"};
+    }
+    return state->read_batch(out, max);
+}
+
+template <typename Type, typename Mutex, typename Cv>
+template <typename OutputIterator>
+std::size_t Channel<Type, Mutex, Cv>::try_read_batch(OutputIterator out,
+                                                     std::size_t max) {
+    auto state = this->lock();
+    if (!state->can_read_succeed() && state->closed) {
+        throw ChannelClosedError{"sharp::Channel::try_read_batch() called "
+            "on a closed channel"};
+    }
+    return state->read_batch(out, max);
+}
+
+template <typename Type, typename Mutex, typename Cv>
+sharp::Future<Type> Channel<Type, Mutex, Cv>::async_read() {
+    // queue the read and let the lock complete it right away if there is
+    // something to read, like a blocked read the queued read is advertised
+    // as an open slot for senders
+    auto promise = sharp::Promise<Type>{};
+    auto future = promise.get_future();
+
+    auto state = this->lock();
+    state->async_reads.push_back(std::move(promise));
+    ++(state->open_slots);
+    state->notify_selects();
+    return future;
+}
+
+template <typename Type, typename Mutex, typename Cv>
+sharp::Future<sharp::Unit> Channel<Type, Mutex, Cv>::async_send(
+        const Type& value) {
+    return this->async_send_impl(value);
+}
+
+template <typename Type, typename Mutex, typename Cv>
+sharp::Future<sharp::Unit> Channel<Type, Mutex, Cv>::async_send(Type&& value) {
+    return this->async_send_impl(std::move(value));
+}
+
+template <typename Type, typename Mutex, typename Cv>
+template <typename Value>
+sharp::Future<sharp::Unit> Channel<Type, Mutex, Cv>::async_send_impl(
+        Value&& value) {
+    auto promise = sharp::Promise<sharp::Unit>{};
+    auto future = promise.get_future();
+
+    auto state = this->lock();
+    state->async_sends.push_back(typename State::AsyncSend{
+        sharp::Try<Type>{std::forward<Value>(value)}, std::move(promise)});
+    return future;
+}
+
+template <typename Type, typename Mutex, typename Cv>
+void Channel<Type, Mutex, Cv>::close() {
+    auto state = this->lock();
+    state->closed = true;
+    state->notify_selects();
+}
+
+template <typename Type, typename Mutex, typename Cv>
+bool Channel<Type, Mutex, Cv>::is_closed() {
+    return this->synchronized([](auto& state) {
+        return state.closed;
+    });
+}
+
 template <typename Type, typename Mutex, typename Cv>
 template <typename Func>
 bool Channel<Type, Mutex, Cv>::try_send_impl(Func enqueue) {
-    return this->state.synchronized([enqueue](auto& state) {
-        if (state.open_slots) {
-            // if there is space then enqueue the element and decrement the
-            // number of open slots for sends
-            enqueue(state.elements);
-            --(state.open_slots);
+    return this->synchronized([enqueue](auto& state) {
+        state.check_closed();
+        if (state.write(enqueue)) {
+            state.notify_selects();
             return true;
         }
 
@@ -171,31 +667,129 @@ bool Channel<Type, Mutex, Cv>::try_send_impl(Func enqueue) {
 template <typename Type, typename Mutex, typename Cv>
 template <typename Func>
 void Channel<Type, Mutex, Cv>::send_impl(Func enqueue) {
-    auto state = this->state.lock();
+    auto state = this->lock();
 
-    // wait for open slots to be non 0
-    state.wait([](auto& state) {
-        return state.can_write_succeed();
-    });
+    // wait for an open slot or a select waiting to read, the select can
+    // commit to another case in between so check again after waking up
+    state->check_closed();
+    do {
+        state.wait([](auto& state) {
+            return state.can_write_succeed() || state.closed;
+        });
+        state->check_closed();
+    } while (!state->write(enqueue));
+    state->notify_selects();
+}
 
-    // then decrement the open slots and write to the queue af
-    enqueue(state->elements);
-    --(state->open_slots);
+template <typename Type, typename Mutex, typename Cv>
+auto Channel<Type, Mutex, Cv>::lock() {
+    return channel_detail::StateLock<sharp::Concurrent<State>>{this->state};
 }
 
-template <typename ChannelType, typename Func>
+template <typename Type, typename Mutex, typename Cv>
+template <typename Func>
+decltype(auto) Channel<Type, Mutex, Cv>::synchronized(Func&& func) {
+    auto state = this->lock();
+    return std::forward<Func>(func)(*state);
+}
+
+template <typename ChannelType, typename Func,
+          channel_detail::EnableIfChannel<ChannelType>*>
 auto make_case(ChannelType& channel, Func&& func) {
     return channel_detail::make_case_impl(channel, std::forward<Func>(func));
 }
 
+template <typename Func>
+auto make_case(default_case::tag_t, Func&& func) {
+    return channel_detail::DefaultCase<std::decay_t<Func>>{
+        std::forward<Func>(func)};
+}
+
+template <typename... Cases>
+void select(Cases&&... cases) {
+    static_assert(sizeof...(Cases) > 0, "select() needs at least one case");
+
+    auto handles = std::array<channel_detail::SelectCase, sizeof...(Cases)>{{
+        channel_detail::SelectCase{cases}...}};
+    channel_detail::select_impl(handles.data(),
+            handles.data() + handles.size());
+}
+
 template <typename Type, typename Mutex, typename Cv>
 bool Channel<Type, Mutex, Cv>::State::can_read_succeed() const noexcept {
     return !this->elements.empty();
 }
 
 template <typename Type, typename Mutex, typename Cv>
-bool Channel<Type, Mutex, Cv>::State::can_write_succeed() const noexcept {
-    return this->open_slots != 0;
+bool Channel<Type, Mutex, Cv>::State::can_write_succeed() const {
+    if (this->open_slots > 0) {
+        return true;
+    }
+    return std::any_of(this->read_selects.begin(), this->read_selects.end(),
+            [](auto waiter) {
+        return waiter->synchronized([](auto& select) {
+            return !select.claimed;
+        });
+    });
+}
+
+template <typename Type, typename Mutex, typename Cv>
+template <typename EnqueueFunc>
+bool Channel<Type, Mutex, Cv>::State::write(
+        EnqueueFunc enqueue, channel_detail::SelectWaiter* self) {
+    // a select that writes has to commit to this channel in the same step as
+    // it takes the slot, a sender can be committing it to a read elsewhere
+    if (this->open_slots > 0) {
+        if (self && !channel_detail::commit_write(*self, this)) {
+            return false;
+        }
+    } else {
+        // otherwise go through against a select waiting to read, which
+        // commits it to the read and makes it a waiting reader whose slot
+        // this write takes.  A select cannot go through against itself
+        auto claimed = false;
+        for (auto waiter : this->read_selects) {
+            if (waiter == self) {
+                continue;
+            }
+
+            auto claim = [&](auto& select) {
+                if (select.claimed) {
+                    return false;
+                }
+                select.claimed = this;
+                select.ready = true;
+                return true;
+            };
+            if (!self) {
+                claimed = waiter->synchronized(claim);
+            } else {
+                auto locks = sharp::lock(*waiter, *self);
+                if (std::get<1>(locks)->claimed) {
+                    return false;
+                }
+                claimed = claim(*std::get<0>(locks));
+                std::get<1>(locks)->claimed = claimed ? this : nullptr;
+            }
+            if (claimed) {
+                break;
+            }
+        }
+        if (!claimed) {
+            return false;
+        }
+        ++this->open_slots;
+    }
+
+    // if the value cannot be made the slot stays open
+    --this->open_slots;
+    try {
+        enqueue(this->elements);
+    } catch (...) {
+        ++this->open_slots;
+        throw;
+    }
+    return true;
 }
 
 template <typename Type, typename Mutex, typename Cv>
@@ -205,4 +799,105 @@ auto Channel<Type, Mutex, Cv>::State::read() {
     return std::move(this->elements.front());
 }
 
+template <typename Type, typename Mutex, typename Cv>
+template <typename OutputIterator>
+std::size_t Channel<Type, Mutex, Cv>::State::read_batch(OutputIterator& out,
+                                                        std::size_t max) {
+    // notify once for the whole batch, even if an element throws
+    auto deferred = sharp::defer([&]() { this->notify_selects(); });
+
+    // stop short of an element holding an exception so the elements read so
+    // far are returned with their count, the exception is thrown by the next
+    // read when it comes first
+    auto count = std::size_t{0};
+    for (; (count < max) && this->can_read_succeed(); ++count) {
+        if (count && this->elements.front().has_exception()) {
+            break;
+        }
+        ++(this->open_slots);
+        *out = this->read().get();
+        ++out;
+    }
+    return count;
+}
+
+template <typename Type, typename Mutex, typename Cv>
+void Channel<Type, Mutex, Cv>::State::settle(
+        channel_detail::Completions& completions) {
+    if (this->async_reads.empty() && this->async_sends.empty()) {
+        return;
+    }
+
+    // a queued send going through can let a queued read go through and vice
+    // versa, so keep going till neither can make progress
+    auto settled = false;
+    auto progress = false;
+    while (!settled) {
+        settled = true;
+
+        while (!this->async_sends.empty()) {
+            auto& front = this->async_sends.front();
+            if (this->closed) {
+                completions.push_back([send = std::move(front)]() mutable {
+                    send.promise.set_exception(std::make_exception_ptr(
+                        ChannelClosedError{"sharp::Channel::async_send() "
+                            "called on a closed channel"}));
+                });
+            } else if (this->write([&](auto& elements) {
+                        elements.push(std::move(front.value));
+                    })) {
+                completions.push_back([send = std::move(front)]() mutable {
+                    send.promise.set_value(sharp::Unit{});
+                });
+            } else {
+                break;
+            }
+            this->async_sends.pop_front();
+            settled = false;
+        }
+
+        while (!this->async_reads.empty()
+                && (this->can_read_succeed() || this->closed)) {
+            auto promise = std::move(this->async_reads.front());
+            this->async_reads.pop_front();
+            settled = false;
+
+            // the read was advertised as an open slot, which is used up by
+            // reading an element and taken back otherwise
+            auto readable = this->can_read_succeed();
+            if (!readable) {
+                --(this->open_slots);
+            }
+            auto value = readable
+                ? sharp::Try<Type>{this->read()}
+                : sharp::Try<Type>{channel_detail::make_closed_exception()};
+            completions.push_back([promise = std::move(promise),
+                                   value = std::move(value)]() mutable {
+                channel_detail::fulfill(promise, value);
+            });
+        }
+
+        progress = progress || !settled;
+    }
+
+    if (progress) {
+        this->notify_selects();
+    }
+}
+
+template <typename Type, typename Mutex, typename Cv>
+void Channel<Type, Mutex, Cv>::State::check_closed() const {
+    if (this->closed) {
+        throw ChannelClosedError{"sharp::Channel::send() called on a closed "
+            "channel"};
+    }
+}
+
+template <typename Type, typename Mutex, typename Cv>
+void Channel<Type, Mutex, Cv>::State::notify_selects() {
+    for (auto waiter : this->selects) {
+        waiter->synchronized([](auto& select) { select.ready = true; });
+    }
+}
+
 } // namespace sharp
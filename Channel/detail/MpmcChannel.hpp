@@ -0,0 +1,209 @@
+/**
+ * @file MpmcChannel.hpp
+ * @author Aaryaman Sagar
+ *
+ * A specialization of Channel that any number of threads can send to and
+ * read from without sharing a lock.  Selected by passing sharp::Mpmc in
+ * place of the mutex
+ *
+ *      sharp::Channel<Task, sharp::Mpmc> channel{1024};
+ */
+
+#pragma once
+
+#include <sharp/Channel/Channel.hpp>
+#include <sharp/Channel/detail/Waiters.hpp>
+#include <sharp/Portability/cpp17.hpp>
+#include <sharp/Try/Try.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+namespace sharp {
+
+/**
+ * @class Channel<Type, Mpmc, Cv>
+ *
+ * This is the bounded queue described by Dmitry Vyukov.  Each slot in the
+ * ring has a sequence number next to it that says whether the slot is ready
+ * to be written to or read from for a given position.  A sender claims a
+ * position with a compare and swap on the enqueue index, constructs the
+ * element in the slot and then publishes it by bumping the slot's sequence
+ * number, readers do the same with the dequeue index.  Senders and readers
+ * therefore only contend on their own index, and past that only touch the
+ * slot they claimed, each of which is on its own cache line
+ *
+ * Threads that find the ring full or empty spin for a short while and then
+ * sleep on a futex word, every operation wakes up one sleeping thread on
+ * the other side if there is one
+ *
+ * The buffer size is rounded up to a power of two, and as with the single
+ * producer single consumer channel, sends do not rendezvous with readers so
+ * a buffer size of 0 gives a channel with room for one element.  This
+ * channel cannot be used with select()
+ */
+template <typename Type, typename Cv>
+class Channel<Type, Mpmc, Cv> {
+public:
+
+    using value_type = Type;
+
+    /**
+     * Constructs a channel that can hold at least buffer_size elements that
+     * have not been read yet
+     */
+    explicit Channel(int buffer_size = 0);
+
+    /**
+     * Destroys all the elements that were sent but never read
+     */
+    ~Channel();
+
+    /**
+     * Non copyable and non movable, same as the general channel
+     */
+    Channel(const Channel&) = delete;
+    Channel(Channel&&) = delete;
+    Channel& operator=(const Channel&) = delete;
+    Channel& operator=(Channel&&) = delete;
+
+    /**
+     * Sends a value across the channel, blocking while the channel is full.
+     * See the general channel for documentation
+     */
+    void send(const Type& value);
+    void send(Type&& value);
+    template <typename... Args>
+    void send(std::in_place_t, Args&&... args);
+    template <typename U, typename... Args>
+    void send(std::in_place_t, std::initializer_list<U> il, Args&&... args);
+
+    /**
+     * Sends a value only if there is room in the channel, returns false and
+     * leaves the value untouched otherwise
+     */
+    bool try_send(const Type& value);
+    bool try_send(Type&& value);
+
+    /**
+     * Reads a value from the channel, blocking while the channel is empty
+     */
+    Type read();
+    sharp::Try<Type> read_try();
+
+    /**
+     * Reads a value from the channel only if there is one, returns an empty
+     * optional or an empty Try otherwise
+     */
+    std::optional<Type> try_read();
+    sharp::Try<Type> try_read_try();
+
+    /**
+     * Batch sends and reads, see the general channel for documentation.
+     * A batch claims all the slots it can with one compare and swap and
+     * wakes up the other side at most once per batch
+     *
+     * A batch send has to know how many slots to claim up front, so ranges
+     * of input iterators that are not forward iterators are sent one
+     * element at a time
+     */
+    template <typename InputIterator>
+    void send_batch(InputIterator first, InputIterator last);
+    template <typename Range>
+    void send_batch(Range&& range);
+    template <typename OutputIterator>
+    std::size_t read_batch(OutputIterator out, std::size_t max);
+    template <typename OutputIterator>
+    std::size_t try_read_batch(OutputIterator out, std::size_t max);
+
+    /**
+     * Close the channel, see the general channel for documentation
+     */
+    void close();
+    bool is_closed() const noexcept;
+
+private:
+
+    using Storage = std::aligned_storage_t<sizeof(sharp::Try<Type>),
+                                           alignof(sharp::Try<Type>)>;
+
+    /**
+     * A slot in the ring.  The sequence number is equal to the position of
+     * the slot when it is ready to be written to, and to the position + 1
+     * when it is ready to be read from.  The exception flag says whether the
+     * element holds an exception, batch reads look at it to stop short of
+     * such elements before they claim them
+     */
+    struct alignas(64) Cell {
+        std::atomic<std::uint64_t> sequence;
+        std::atomic<bool> exception;
+        Storage storage;
+    };
+
+    /**
+     * Non blocking halves of the channel operations, these return false or
+     * an empty Try when the ring is full or empty respectively
+     */
+    template <typename... Args>
+    bool try_emplace(Args&&... args);
+    template <typename... Args>
+    void emplace(Args&&... args);
+    sharp::Try<Type> try_pop();
+
+    /**
+     * Claim a run of consecutive slots with one compare and swap and fill
+     * them in or empty them, returning the number of slots claimed.  A
+     * return value of 0 means the ring was full or empty
+     */
+    template <typename ForwardIterator>
+    void send_batch(ForwardIterator first, ForwardIterator last,
+                    std::forward_iterator_tag);
+    template <typename InputIterator>
+    void send_batch(InputIterator first, InputIterator last,
+                    std::input_iterator_tag);
+    template <typename ForwardIterator>
+    std::size_t try_emplace_batch(ForwardIterator& first,
+                                  std::size_t remaining);
+    template <typename OutputIterator>
+    std::size_t try_pop_batch(OutputIterator& out, std::size_t max);
+    std::size_t claim(std::atomic<std::uint64_t>& index, std::uint64_t lag,
+                      std::size_t max, std::uint64_t& position);
+
+    /**
+     * Publish the element constructed in a claimed slot to readers, and move
+     * the element out of a claimed slot and mark the slot free for the next
+     * lap
+     */
+    void publish(Cell& cell, std::uint64_t position);
+    sharp::Try<Type> release(std::uint64_t position);
+
+    /**
+     * Whether the slot at the current enqueue or dequeue position is ready,
+     * used to decide whether to keep waiting
+     */
+    bool is_full() const;
+    bool is_empty() const;
+    bool is_ready(std::uint64_t position, std::uint64_t lag) const;
+    bool holds_exception(std::uint64_t position) const;
+    void check_closed() const;
+
+    const std::uint64_t mask;
+    const std::unique_ptr<char[]> memory;
+    Cell* cells;
+
+    alignas(64) std::atomic<std::uint64_t> enqueue_position{0};
+    alignas(64) std::atomic<std::uint64_t> dequeue_position{0};
+
+    channel_detail::Waiters readable;
+    channel_detail::Waiters writable;
+    std::atomic<bool> closed{false};
+};
+
+} // namespace sharp
+
+#include <sharp/Channel/detail/MpmcChannel.ipp>
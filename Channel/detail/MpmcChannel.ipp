@@ -0,0 +1,472 @@
+#include <sharp/Channel/detail/MpmcChannel.hpp>
+#include <sharp/Defer/Defer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace sharp {
+
+template <typename Type, typename Cv>
+Channel<Type, Mpmc, Cv>::Channel(int buffer_size)
+    : mask{channel_detail::round_up_power_of_two(
+            static_cast<std::uint64_t>(std::max(buffer_size, 1))) - 1},
+      memory{new char[sizeof(Cell) * (this->mask + 1) + alignof(Cell)]} {
+
+    // align the cells by hand, over aligned new is not available before
+    // C++17
+    auto size = sizeof(Cell) * (this->mask + 1);
+    auto space = size + alignof(Cell);
+    auto pointer = static_cast<void*>(this->memory.get());
+    this->cells = static_cast<Cell*>(
+            std::align(alignof(Cell), size, pointer, space));
+
+    for (auto i = std::uint64_t{0}; i <= this->mask; ++i) {
+        new (&this->cells[i]) Cell{};
+        this->cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename Type, typename Cv>
+Channel<Type, Mpmc, Cv>::~Channel() {
+    while (this->try_pop().valid()) {}
+}
+
+template <typename Type, typename Cv>
+void Channel<Type, Mpmc, Cv>::send(const Type& value) {
+    this->emplace(value);
+}
+
+template <typename Type, typename Cv>
+void Channel<Type, Mpmc, Cv>::send(Type&& value) {
+    this->emplace(std::move(value));
+}
+
+template <typename Type, typename Cv>
+template <typename... Args>
+void Channel<Type, Mpmc, Cv>::send(std::in_place_t, Args&&... args) {
+    this->emplace(std::in_place, std::forward<Args>(args)...);
+}
+
+template <typename Type, typename Cv>
+template <typename U, typename... Args>
+void Channel<Type, Mpmc, Cv>::send(std::in_place_t,
+                                   std::initializer_list<U> il,
+                                   Args&&... args) {
+    this->emplace(std::in_place, il, std::forward<Args>(args)...);
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Mpmc, Cv>::try_send(const Type& value) {
+    this->check_closed();
+    return this->try_emplace(sharp::Try<Type>(value));
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Mpmc, Cv>::try_send(Type&& value) {
+    this->check_closed();
+    return this->try_emplace(std::move(value));
+}
+
+template <typename Type, typename Cv>
+Type Channel<Type, Mpmc, Cv>::read() {
+    return this->read_try().get();
+}
+
+template <typename Type, typename Cv>
+sharp::Try<Type> Channel<Type, Mpmc, Cv>::read_try() {
+    while (true) {
+        auto value = this->try_pop();
+        if (value.valid()) {
+            return value;
+        }
+
+        // elements sent before the close are still read, so only give up
+        // when the channel is closed and there is nothing left
+        if (this->closed.load()) {
+            auto last = this->try_pop();
+            if (last.valid()) {
+                return last;
+            }
+            return std::make_exception_ptr(ChannelClosedError{
+                "sharp::Channel::read() called on a closed channel"});
+        }
+
+        this->readable.wait([&]() {
+            return !this->is_empty() || this->closed.load();
+        });
+    }
+}
+
+template <typename Type, typename Cv>
+std::optional<Type> Channel<Type, Mpmc, Cv>::try_read() {
+    auto t = this->try_read_try();
+    if (t.valid()) {
+        return std::move(t).value();
+    } else {
+        return std::nullopt;
+    }
+}
+
+template <typename Type, typename Cv>
+sharp::Try<Type> Channel<Type, Mpmc, Cv>::try_read_try() {
+    auto value = this->try_pop();
+    if (value.valid() || !this->closed.load()) {
+        return value;
+    }
+
+    auto last = this->try_pop();
+    if (last.valid()) {
+        return last;
+    }
+    return std::make_exception_ptr(ChannelClosedError{
+        "sharp::Channel::try_read() called on a closed channel"});
+}
+
+template <typename Type, typename Cv>
+template <typename InputIterator>
+void Channel<Type, Mpmc, Cv>::send_batch(InputIterator first,
+                                         InputIterator last) {
+    using Category = typename std::iterator_traits<InputIterator>
+        ::iterator_category;
+    this->send_batch(first, last, Category{});
+}
+
+template <typename Type, typename Cv>
+template <typename InputIterator>
+void Channel<Type, Mpmc, Cv>::send_batch(InputIterator first,
+                                         InputIterator last,
+                                         std::input_iterator_tag) {
+    this->check_closed();
+    for (; first != last; ++first) {
+        this->emplace(std::in_place, *first);
+    }
+}
+
+template <typename Type, typename Cv>
+template <typename ForwardIterator>
+void Channel<Type, Mpmc, Cv>::send_batch(ForwardIterator first,
+                                         ForwardIterator last,
+                                         std::forward_iterator_tag) {
+    this->check_closed();
+    auto remaining = static_cast<std::size_t>(std::distance(first, last));
+    while (remaining) {
+        auto sent = this->try_emplace_batch(first, remaining);
+        remaining -= sent;
+        if (!sent) {
+            this->writable.wait([&]() {
+                return !this->is_full() || this->closed.load();
+            });
+            this->check_closed();
+        }
+    }
+}
+
+template <typename Type, typename Cv>
+template <typename Range>
+void Channel<Type, Mpmc, Cv>::send_batch(Range&& range) {
+    using std::begin;
+    using std::end;
+    this->send_batch(begin(range), end(range));
+}
+
+template <typename Type, typename Cv>
+template <typename OutputIterator>
+std::size_t Channel<Type, Mpmc, Cv>::read_batch(OutputIterator out,
+                                                std::size_t max) {
+    if (!max) {
+        return 0;
+    }
+
+    while (true) {
+        auto read = this->try_read_batch(out, max);
+        if (read) {
+            return read;
+        }
+
+        this->readable.wait([&]() {
+            return !this->is_empty() || this->closed.load();
+        });
+    }
+}
+
+template <typename Type, typename Cv>
+template <typename OutputIterator>
+std::size_t Channel<Type, Mpmc, Cv>::try_read_batch(OutputIterator out,
+                                                    std::size_t max) {
+    if (!max) {
+        return 0;
+    }
+
+    auto read = this->try_pop_batch(out, max);
+    if (read || !this->closed.load()) {
+        return read;
+    }
+
+    read = this->try_pop_batch(out, max);
+    if (!read) {
+        throw ChannelClosedError{"sharp::Channel::read_batch() called on a "
+            "closed channel"};
+    }
+    return read;
+}
+
+template <typename Type, typename Cv>
+void Channel<Type, Mpmc, Cv>::close() {
+    this->closed.store(true);
+    this->readable.notify_all();
+    this->writable.notify_all();
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Mpmc, Cv>::is_closed() const noexcept {
+    return this->closed.load();
+}
+
+template <typename Type, typename Cv>
+template <typename... Args>
+bool Channel<Type, Mpmc, Cv>::try_emplace(Args&&... args) {
+    auto position = this->enqueue_position.load(std::memory_order_relaxed);
+    auto cell = static_cast<Cell*>(nullptr);
+    while (true) {
+        cell = &this->cells[position & this->mask];
+        auto sequence = cell->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::int64_t>(sequence - position);
+
+        // the slot is free for this position, try and claim it, and if
+        // another sender got here first then position is reloaded by the
+        // failed compare and swap
+        if (difference == 0) {
+            if (this->enqueue_position.compare_exchange_weak(position,
+                        position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+
+        // the slot still holds an element from the previous lap, full
+        } else if (difference < 0) {
+            return false;
+
+        // another sender claimed this position, catch up
+        } else {
+            position = this->enqueue_position.load(
+                    std::memory_order_relaxed);
+        }
+    }
+
+    // the claimed slot has to be published no matter what, readers wait for
+    // the slots in order.  So if constructing the element throws, the
+    // exception is sent in its place like in try_emplace_batch()
+    try {
+        new (&cell->storage) sharp::Try<Type>(std::forward<Args>(args)...);
+    } catch (...) {
+        new (&cell->storage) sharp::Try<Type>(std::current_exception());
+    }
+    this->publish(*cell, position);
+    this->readable.notify();
+    return true;
+}
+
+template <typename Type, typename Cv>
+template <typename... Args>
+void Channel<Type, Mpmc, Cv>::emplace(Args&&... args) {
+    // construct the element before claiming a slot so that an exception
+    // from the constructor goes to the sender, and only the move into the
+    // slot is left to try_emplace()
+    this->check_closed();
+    auto value = sharp::Try<Type>(std::forward<Args>(args)...);
+    while (!this->try_emplace(std::move(value))) {
+        this->writable.wait([&]() {
+            return !this->is_full() || this->closed.load();
+        });
+        this->check_closed();
+    }
+}
+
+template <typename Type, typename Cv>
+sharp::Try<Type> Channel<Type, Mpmc, Cv>::try_pop() {
+    auto position = this->dequeue_position.load(std::memory_order_relaxed);
+    auto cell = static_cast<Cell*>(nullptr);
+    while (true) {
+        cell = &this->cells[position & this->mask];
+        auto sequence = cell->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::int64_t>(sequence - (position + 1));
+
+        if (difference == 0) {
+            if (this->dequeue_position.compare_exchange_weak(position,
+                        position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return nullptr;
+        } else {
+            position = this->dequeue_position.load(
+                    std::memory_order_relaxed);
+        }
+    }
+
+    auto value = this->release(position);
+    this->writable.notify();
+    return value;
+}
+
+template <typename Type, typename Cv>
+std::size_t Channel<Type, Mpmc, Cv>::claim(std::atomic<std::uint64_t>& index,
+                                           std::uint64_t lag,
+                                           std::size_t max,
+                                           std::uint64_t& position) {
+    // same as the loops in try_emplace() and try_pop(), but once the slot at
+    // the current position is ready also count how many of the slots right
+    // after it are ready, and claim all of them in one go
+    position = index.load(std::memory_order_relaxed);
+    auto limit = std::min(static_cast<std::uint64_t>(max), this->mask + 1);
+    while (true) {
+        auto& cell = this->cells[position & this->mask];
+        auto sequence = cell.sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::int64_t>(
+                sequence - (position + lag));
+
+        if (difference == 0) {
+            // a batch read stops short of an element holding an exception,
+            // so that element is always claimed on its own, see
+            // try_pop_batch()
+            auto reading = (lag != 0);
+            auto stops = [&](auto at) {
+                return reading && this->holds_exception(at);
+            };
+            auto count = std::uint64_t{1};
+            while ((count < limit) && !stops(position)
+                    && this->is_ready(position + count, lag)
+                    && !stops(position + count)) {
+                ++count;
+            }
+            if (index.compare_exchange_weak(position, position + count,
+                        std::memory_order_relaxed)) {
+                return static_cast<std::size_t>(count);
+            }
+        } else if (difference < 0) {
+            return 0;
+        } else {
+            position = index.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename Type, typename Cv>
+template <typename ForwardIterator>
+std::size_t Channel<Type, Mpmc, Cv>::try_emplace_batch(
+        ForwardIterator& first, std::size_t remaining) {
+    auto position = std::uint64_t{0};
+    auto count = this->claim(this->enqueue_position, 0, remaining, position);
+
+    // the claimed slots have to be published no matter what, readers wait
+    // for them in order.  So if constructing an element throws, the
+    // exception is sent in its place
+    for (auto i = std::uint64_t{0}; i < count; ++i, ++first) {
+        auto& cell = this->cells[(position + i) & this->mask];
+        try {
+            new (&cell.storage) sharp::Try<Type>(std::in_place, *first);
+        } catch (...) {
+            new (&cell.storage) sharp::Try<Type>(std::current_exception());
+        }
+        this->publish(cell, position + i);
+    }
+
+    if (count) {
+        this->readable.notify(static_cast<int>(count));
+    }
+    return count;
+}
+
+template <typename Type, typename Cv>
+template <typename OutputIterator>
+std::size_t Channel<Type, Mpmc, Cv>::try_pop_batch(OutputIterator& out,
+                                                   std::size_t max) {
+    auto position = std::uint64_t{0};
+    auto count = this->claim(this->dequeue_position, 1, max, position);
+
+    // every claimed slot has to be emptied and released even if writing to
+    // the output iterator throws, the elements not written are lost then
+    auto i = std::uint64_t{0};
+    auto deferred = sharp::defer([&]() {
+        for (; i < count; ++i) {
+            this->release(position + i);
+        }
+        if (count) {
+            this->writable.notify(static_cast<int>(count));
+        }
+    });
+
+    // claim() only ever hands out an element holding an exception as a
+    // batch of one, so get() throws it before anything else is written
+    while (i < count) {
+        auto value = this->release(position + i);
+        ++i;
+        *out = std::move(value).get();
+        ++out;
+    }
+    return count;
+}
+
+template <typename Type, typename Cv>
+void Channel<Type, Mpmc, Cv>::publish(Cell& cell, std::uint64_t position) {
+    auto& element = reinterpret_cast<sharp::Try<Type>&>(cell.storage);
+    cell.exception.store(element.has_exception(), std::memory_order_relaxed);
+    cell.sequence.store(position + 1, std::memory_order_release);
+}
+
+template <typename Type, typename Cv>
+sharp::Try<Type> Channel<Type, Mpmc, Cv>::release(std::uint64_t position) {
+    auto& cell = this->cells[position & this->mask];
+    auto& element = reinterpret_cast<sharp::Try<Type>&>(cell.storage);
+    auto value = sharp::Try<Type>{std::move(element)};
+    element.~Try();
+    cell.sequence.store(position + this->mask + 1, std::memory_order_release);
+    return value;
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Mpmc, Cv>::is_ready(std::uint64_t position,
+                                       std::uint64_t lag) const {
+    auto& cell = this->cells[position & this->mask];
+    return cell.sequence.load(std::memory_order_acquire) == (position + lag);
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Mpmc, Cv>::holds_exception(std::uint64_t position) const {
+    // only called after is_ready() has seen the slot published, a stale
+    // value from another lap means the slot was taken by another reader and
+    // the compare and swap in claim() fails anyway
+    auto& cell = this->cells[position & this->mask];
+    return cell.exception.load(std::memory_order_relaxed);
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Mpmc, Cv>::is_full() const {
+    auto position = this->enqueue_position.load(std::memory_order_relaxed);
+    auto& cell = this->cells[position & this->mask];
+    auto sequence = cell.sequence.load(std::memory_order_acquire);
+    return static_cast<std::int64_t>(sequence - position) < 0;
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Mpmc, Cv>::is_empty() const {
+    auto position = this->dequeue_position.load(std::memory_order_relaxed);
+    auto& cell = this->cells[position & this->mask];
+    auto sequence = cell.sequence.load(std::memory_order_acquire);
+    return static_cast<std::int64_t>(sequence - (position + 1)) < 0;
+}
+
+template <typename Type, typename Cv>
+void Channel<Type, Mpmc, Cv>::check_closed() const {
+    if (this->closed.load(std::memory_order_relaxed)) {
+        throw ChannelClosedError{"sharp::Channel::send() called on a closed "
+            "channel"};
+    }
+}
+
+} // namespace sharp
@@ -0,0 +1,193 @@
+/**
+ * @file SpscChannel.hpp
+ * @author Aaryaman Sagar
+ *
+ * A specialization of Channel for the case where there is exactly one thread
+ * sending values and exactly one thread reading them.  Selected by passing
+ * sharp::Spsc in place of the mutex
+ *
+ *      sharp::Channel<Message, sharp::Spsc> channel{1024};
+ */
+
+#pragma once
+
+#include <sharp/Channel/Channel.hpp>
+#include <sharp/Channel/detail/Waiters.hpp>
+#include <sharp/Portability/cpp17.hpp>
+#include <sharp/Try/Try.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+
+namespace sharp {
+
+/**
+ * @class Channel<Type, Spsc, Cv>
+ *
+ * The elements live in a fixed size ring buffer, the sender owns the tail
+ * index and the reader owns the head index.  Each of them publishes its
+ * index with a release store and reads the other's with an acquire load, so
+ * a send or a read that does not have to wait is a handful of plain loads
+ * and stores with no read-modify-write operations and no locks, followed by
+ * the one full fence it takes to check for a sleeping thread on the other
+ * side (see Waiters).  Each side also keeps a private cached copy of the
+ * other side's index so the shared cache line is only touched when the ring
+ * looks full or empty
+ *
+ * The indices and the bookkeeping for each side are on separate cache lines
+ * so the two threads do not false share
+ *
+ * Only when the ring is full (for the sender) or empty (for the reader) does
+ * the thread spin for a short while and then go to sleep on a futex word.
+ * The other side checks whether anyone is sleeping after every operation and
+ * wakes them up if so.  That check has to be ordered after the store that
+ * publishes the operation, so it is the one fence every send and read pays
+ *
+ * The semantics differ from the general channel in one way, sends never
+ * rendezvous with the reader.  A buffer size of 0 gives a channel with room
+ * for one element, and a send returns as soon as the element is in the ring
+ *
+ * Calling the sending methods from more than one thread at a time, or the
+ * reading methods from more than one thread at a time is undefined
+ */
+template <typename Type, typename Cv>
+class Channel<Type, Spsc, Cv> {
+public:
+
+    using value_type = Type;
+
+    /**
+     * Constructs a channel that can hold up to buffer_size elements that
+     * have not been read yet
+     */
+    explicit Channel(int buffer_size = 0);
+
+    /**
+     * Destroys all the elements that were sent but never read
+     */
+    ~Channel();
+
+    /**
+     * Non copyable and non movable, same as the general channel
+     */
+    Channel(const Channel&) = delete;
+    Channel(Channel&&) = delete;
+    Channel& operator=(const Channel&) = delete;
+    Channel& operator=(Channel&&) = delete;
+
+    /**
+     * Sends a value across the channel, blocking while the channel is full.
+     * See the general channel for documentation
+     */
+    void send(const Type& value);
+    void send(Type&& value);
+    template <typename... Args>
+    void send(std::in_place_t, Args&&... args);
+    template <typename U, typename... Args>
+    void send(std::in_place_t, std::initializer_list<U> il, Args&&... args);
+
+    /**
+     * Sends a value only if there is room in the channel, returns false and
+     * leaves the value untouched otherwise
+     */
+    bool try_send(const Type& value);
+    bool try_send(Type&& value);
+
+    /**
+     * Reads a value from the channel, blocking while the channel is empty
+     */
+    Type read();
+    sharp::Try<Type> read_try();
+
+    /**
+     * Reads a value from the channel only if there is one, returns an empty
+     * optional or an empty Try otherwise
+     */
+    std::optional<Type> try_read();
+    sharp::Try<Type> try_read_try();
+
+    /**
+     * Batch sends and reads, see the general channel for documentation.
+     * A batch publishes all the elements it can fit in the ring at once and
+     * wakes up the other side at most once per batch
+     */
+    template <typename InputIterator>
+    void send_batch(InputIterator first, InputIterator last);
+    template <typename Range>
+    void send_batch(Range&& range);
+    template <typename OutputIterator>
+    std::size_t read_batch(OutputIterator out, std::size_t max);
+    template <typename OutputIterator>
+    std::size_t try_read_batch(OutputIterator out, std::size_t max);
+
+    /**
+     * Close the channel, see the general channel for documentation
+     */
+    void close();
+    bool is_closed() const noexcept;
+
+private:
+
+    using Storage = std::aligned_storage_t<sizeof(sharp::Try<Type>),
+                                           alignof(sharp::Try<Type>)>;
+
+    /**
+     * Construct an element in the slot at the tail and publish it to the
+     * reader, and move the element at the head out and publish the free slot
+     * to the sender
+     */
+    template <typename... Args>
+    bool try_emplace(Args&&... args);
+    template <typename... Args>
+    void emplace(Args&&... args);
+    sharp::Try<Type> pop(std::uint64_t head);
+    template <typename OutputIterator>
+    std::size_t pop_batch(std::uint64_t head, OutputIterator& out,
+                          std::size_t max);
+
+    bool is_full(std::uint64_t tail);
+    bool is_empty(std::uint64_t head);
+    void check_closed() const;
+
+    Storage& slot(std::uint64_t index) {
+        return this->ring[index & this->mask];
+    }
+
+    /**
+     * The maximum number of elements in the channel, the ring itself is
+     * rounded up to a power of two so indexing is just a mask
+     */
+    const std::uint64_t capacity;
+    const std::uint64_t mask;
+    const std::unique_ptr<Storage[]> ring;
+
+    /**
+     * The reader's side, the head index and the reader's cached copy of
+     * the tail
+     */
+    alignas(64) std::atomic<std::uint64_t> head{0};
+    std::uint64_t cached_tail{0};
+
+    /**
+     * The sender's side, the tail index and the sender's cached copy of the
+     * head
+     */
+    alignas(64) std::atomic<std::uint64_t> tail{0};
+    std::uint64_t cached_head{0};
+
+    /**
+     * Where the reader and the sender sleep when the channel is empty or
+     * full respectively
+     */
+    channel_detail::Waiters readable;
+    channel_detail::Waiters writable;
+    std::atomic<bool> closed{false};
+};
+
+} // namespace sharp
+
+#include <sharp/Channel/detail/SpscChannel.ipp>
@@ -0,0 +1,315 @@
+#include <sharp/Channel/detail/SpscChannel.hpp>
+#include <sharp/Defer/Defer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <initializer_list>
+#include <new>
+#include <utility>
+
+namespace sharp {
+
+namespace channel_detail {
+
+    inline std::uint64_t round_up_power_of_two(std::uint64_t value) {
+        auto rounded = std::uint64_t{1};
+        while (rounded < value) {
+            rounded *= 2;
+        }
+        return rounded;
+    }
+
+} // namespace channel_detail
+
+template <typename Type, typename Cv>
+Channel<Type, Spsc, Cv>::Channel(int buffer_size)
+    : capacity{static_cast<std::uint64_t>(std::max(buffer_size, 1))},
+      mask{channel_detail::round_up_power_of_two(this->capacity) - 1},
+      ring{new Storage[this->mask + 1]} {}
+
+template <typename Type, typename Cv>
+Channel<Type, Spsc, Cv>::~Channel() {
+    auto t = this->tail.load(std::memory_order_acquire);
+    for (auto h = this->head.load(); h != t; ++h) {
+        reinterpret_cast<sharp::Try<Type>&>(this->slot(h)).~Try();
+    }
+}
+
+template <typename Type, typename Cv>
+void Channel<Type, Spsc, Cv>::send(const Type& value) {
+    this->emplace(value);
+}
+
+template <typename Type, typename Cv>
+void Channel<Type, Spsc, Cv>::send(Type&& value) {
+    this->emplace(std::move(value));
+}
+
+template <typename Type, typename Cv>
+template <typename... Args>
+void Channel<Type, Spsc, Cv>::send(std::in_place_t, Args&&... args) {
+    this->emplace(std::in_place, std::forward<Args>(args)...);
+}
+
+template <typename Type, typename Cv>
+template <typename U, typename... Args>
+void Channel<Type, Spsc, Cv>::send(std::in_place_t,
+                                   std::initializer_list<U> il,
+                                   Args&&... args) {
+    this->emplace(std::in_place, il, std::forward<Args>(args)...);
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Spsc, Cv>::try_send(const Type& value) {
+    return this->try_emplace(value);
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Spsc, Cv>::try_send(Type&& value) {
+    return this->try_emplace(std::move(value));
+}
+
+template <typename Type, typename Cv>
+Type Channel<Type, Spsc, Cv>::read() {
+    return this->read_try().get();
+}
+
+template <typename Type, typename Cv>
+sharp::Try<Type> Channel<Type, Spsc, Cv>::read_try() {
+    auto h = this->head.load(std::memory_order_relaxed);
+    if (this->is_empty(h)) {
+        this->readable.wait([&]() {
+            return !this->is_empty(h) || this->closed.load();
+        });
+
+        // elements sent before the close are still read, recheck because the
+        // close might have raced with a send
+        if (this->is_empty(h)) {
+            return std::make_exception_ptr(ChannelClosedError{
+                "sharp::Channel::read() called on a closed channel"});
+        }
+    }
+
+    return this->pop(h);
+}
+
+template <typename Type, typename Cv>
+std::optional<Type> Channel<Type, Spsc, Cv>::try_read() {
+    auto t = this->try_read_try();
+    if (t.valid()) {
+        return std::move(t).value();
+    } else {
+        return std::nullopt;
+    }
+}
+
+template <typename Type, typename Cv>
+sharp::Try<Type> Channel<Type, Spsc, Cv>::try_read_try() {
+    auto h = this->head.load(std::memory_order_relaxed);
+    if (this->is_empty(h)) {
+        if (this->closed.load() && this->is_empty(h)) {
+            return std::make_exception_ptr(ChannelClosedError{
+                "sharp::Channel::try_read() called on a closed channel"});
+        }
+        return nullptr;
+    }
+
+    return this->pop(h);
+}
+
+template <typename Type, typename Cv>
+template <typename InputIterator>
+void Channel<Type, Spsc, Cv>::send_batch(InputIterator first,
+                                         InputIterator last) {
+    this->check_closed();
+    auto t = this->tail.load(std::memory_order_relaxed);
+    while (first != last) {
+        if (this->is_full(t)) {
+            this->writable.wait([&]() {
+                return !this->is_full(t) || this->closed.load();
+            });
+            this->check_closed();
+        }
+
+        // fill in all the free slots and then publish them with one store,
+        // the cached head can only understate the free space.  Elements
+        // constructed before an exception are still published
+        auto end = this->cached_head + this->capacity;
+        auto start = t;
+        auto deferred = sharp::defer([&]() {
+            if (t != start) {
+                this->tail.store(t, std::memory_order_release);
+                this->readable.notify();
+            }
+        });
+        for (; (first != last) && (t != end); ++first, ++t) {
+            new (&this->slot(t)) sharp::Try<Type>(std::in_place, *first);
+        }
+    }
+}
+
+template <typename Type, typename Cv>
+template <typename Range>
+void Channel<Type, Spsc, Cv>::send_batch(Range&& range) {
+    using std::begin;
+    using std::end;
+    this->send_batch(begin(range), end(range));
+}
+
+template <typename Type, typename Cv>
+template <typename OutputIterator>
+std::size_t Channel<Type, Spsc, Cv>::read_batch(OutputIterator out,
+                                                std::size_t max) {
+    if (!max) {
+        return 0;
+    }
+
+    auto h = this->head.load(std::memory_order_relaxed);
+    if (this->is_empty(h)) {
+        this->readable.wait([&]() {
+            return !this->is_empty(h) || this->closed.load();
+        });
+        if (this->is_empty(h)) {
+            throw ChannelClosedError{"sharp::Channel::read_batch() called "
+                "on a closed channel"};
+        }
+    }
+
+    return this->pop_batch(h, out, max);
+}
+
+template <typename Type, typename Cv>
+template <typename OutputIterator>
+std::size_t Channel<Type, Spsc, Cv>::try_read_batch(OutputIterator out,
+                                                    std::size_t max) {
+    auto h = this->head.load(std::memory_order_relaxed);
+    if (this->is_empty(h)) {
+        if (this->closed.load() && this->is_empty(h)) {
+            throw ChannelClosedError{"sharp::Channel::try_read_batch() "
+                "called on a closed channel"};
+        }
+        return 0;
+    }
+
+    return this->pop_batch(h, out, max);
+}
+
+template <typename Type, typename Cv>
+void Channel<Type, Spsc, Cv>::close() {
+    this->closed.store(true);
+    this->readable.notify_all();
+    this->writable.notify_all();
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Spsc, Cv>::is_closed() const noexcept {
+    return this->closed.load();
+}
+
+template <typename Type, typename Cv>
+template <typename... Args>
+bool Channel<Type, Spsc, Cv>::try_emplace(Args&&... args) {
+    this->check_closed();
+    auto t = this->tail.load(std::memory_order_relaxed);
+    if (this->is_full(t)) {
+        return false;
+    }
+
+    new (&this->slot(t)) sharp::Try<Type>(std::forward<Args>(args)...);
+    this->tail.store(t + 1, std::memory_order_release);
+    this->readable.notify();
+    return true;
+}
+
+template <typename Type, typename Cv>
+template <typename... Args>
+void Channel<Type, Spsc, Cv>::emplace(Args&&... args) {
+    this->check_closed();
+    auto t = this->tail.load(std::memory_order_relaxed);
+    if (this->is_full(t)) {
+        this->writable.wait([&]() {
+            return !this->is_full(t) || this->closed.load();
+        });
+        this->check_closed();
+    }
+
+    new (&this->slot(t)) sharp::Try<Type>(std::forward<Args>(args)...);
+    this->tail.store(t + 1, std::memory_order_release);
+    this->readable.notify();
+}
+
+template <typename Type, typename Cv>
+sharp::Try<Type> Channel<Type, Spsc, Cv>::pop(std::uint64_t h) {
+    auto& element = reinterpret_cast<sharp::Try<Type>&>(this->slot(h));
+    auto value = std::move(element);
+    element.~Try();
+
+    this->head.store(h + 1, std::memory_order_release);
+    this->writable.notify();
+    return value;
+}
+
+template <typename Type, typename Cv>
+template <typename OutputIterator>
+std::size_t Channel<Type, Spsc, Cv>::pop_batch(std::uint64_t h,
+                                               OutputIterator& out,
+                                               std::size_t max) {
+    // read everything that is known to be there, and then publish the new
+    // head with one store.  The batch stops short of an element holding an
+    // exception, that element is only read as the first one in a batch, in
+    // which case the exception is thrown
+    auto start = h;
+    auto end = h + std::min(static_cast<std::uint64_t>(max),
+                            this->cached_tail - h);
+    auto deferred = sharp::defer([&]() {
+        this->head.store(h, std::memory_order_release);
+        this->writable.notify();
+    });
+
+    while (h != end) {
+        auto& element = reinterpret_cast<sharp::Try<Type>&>(this->slot(h));
+        if ((h != start) && element.has_exception()) {
+            break;
+        }
+        auto value = std::move(element);
+        element.~Try();
+        ++h;
+
+        *out = std::move(value).get();
+        ++out;
+    }
+
+    return static_cast<std::size_t>(h - start);
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Spsc, Cv>::is_full(std::uint64_t t) {
+    // only go to the shared head index if the cached copy says the ring is
+    // full, the cached copy can only lag behind the real one
+    if ((t - this->cached_head) < this->capacity) {
+        return false;
+    }
+    this->cached_head = this->head.load(std::memory_order_acquire);
+    return (t - this->cached_head) >= this->capacity;
+}
+
+template <typename Type, typename Cv>
+bool Channel<Type, Spsc, Cv>::is_empty(std::uint64_t h) {
+    if (h != this->cached_tail) {
+        return false;
+    }
+    this->cached_tail = this->tail.load(std::memory_order_acquire);
+    return h == this->cached_tail;
+}
+
+template <typename Type, typename Cv>
+void Channel<Type, Spsc, Cv>::check_closed() const {
+    if (this->closed.load(std::memory_order_relaxed)) {
+        throw ChannelClosedError{"sharp::Channel::send() called on a closed "
+            "channel"};
+    }
+}
+
+} // namespace sharp
@@ -0,0 +1,92 @@
+/**
+ * @file Waiters.hpp
+ * @author Aaryaman Sagar
+ *
+ * The slow path used by the lock free channels when a thread has to wait for
+ * the ring to stop being full or empty
+ */
+
+#pragma once
+
+#include <sharp/Threads/Futex.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+namespace sharp {
+namespace channel_detail {
+
+    /**
+     * The number of times a thread checks for progress before going to sleep
+     */
+    constexpr auto CHANNEL_SPIN_COUNT = 128;
+
+    /**
+     * @class Waiters
+     *
+     * A futex word that threads sleep on along with a count of how many
+     * threads are sleeping, so that the common case of nobody waiting costs
+     * the other side a fence and a load
+     *
+     * A waiter reads the word before announcing itself, and announces itself
+     * before rechecking its condition.  A notifier makes its progress visible
+     * before checking for waiters.  The fences on both sides then guarantee
+     * that either the notifier sees the waiter, in which case the word is
+     * changed and the futex wait cannot sleep, or the waiter sees the
+     * progress and does not go to sleep
+     *
+     * The fence in notify() is a full store-load barrier (an mfence or a
+     * locked instruction on x86) and runs on every call, including when
+     * nobody is waiting.  It cannot move behind the check for waiters
+     * because the check is the load it has to order, without it the load of
+     * the waiter count can be satisfied before the caller's progress is
+     * visible and a waiter that has just gone to sleep is never woken up
+     */
+    class alignas(64) Waiters {
+    public:
+
+        /**
+         * Wait till ready() returns true, spinning for a short while before
+         * going to sleep
+         */
+        template <typename Ready>
+        void wait(Ready ready) {
+            for (auto i = 0; i < CHANNEL_SPIN_COUNT; ++i) {
+                if (ready()) {
+                    return;
+                }
+            }
+
+            while (!ready()) {
+                auto epoch = this->word.load(std::memory_order_acquire);
+                this->waiting.fetch_add(1, std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!ready()) {
+                    sharp::futex_wait(this->word, epoch);
+                }
+                this->waiting.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Wake up to count waiting threads, if there are any
+         */
+        void notify(int count = 1) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->waiting.load(std::memory_order_acquire)) {
+                this->word.fetch_add(1, std::memory_order_release);
+                sharp::futex_wake(this->word, count);
+            }
+        }
+        void notify_all() {
+            this->notify(std::numeric_limits<int>::max());
+        }
+
+    private:
+        std::atomic<std::uint32_t> word{0};
+        std::atomic<std::uint32_t> waiting{0};
+    };
+
+} // namespace channel_detail
+} // namespace sharp
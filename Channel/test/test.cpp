@@ -3,6 +3,15 @@
 
 #include <gtest/gtest.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 #include <random>
@@ -89,39 +98,163 @@ TEST(Channel, UnbufferedThreadedSend) {
     th_two.join();
 }
 
-// TEST(Channel, SelectBasicRead) {
-    // sharp::Channel<int> c{1};
-    // c.send(1);
-    // int val = 0;
-    // sharp::select(
-        // std::make_pair(std::ref(c), [&val](auto value) {
-            // ++val;
-            // EXPECT_EQ(value, 1);
-        // }),
-        // std::make_pair(std::ref(c), []() -> int {
-            // EXPECT_TRUE(false);
-            // return 0;
-        // })
-    // );
-    // EXPECT_EQ(val, 1);
-// }
+TEST(Channel, SelectBasicRead) {
+    sharp::Channel<int> c{1};
+    c.send(1);
+    int val = 0;
+    sharp::select(
+        sharp::make_case(c, [&val](auto value) {
+            ++val;
+            EXPECT_EQ(value, 1);
+        }),
+        sharp::make_case(c, []() -> int {
+            EXPECT_TRUE(false);
+            return 0;
+        })
+    );
+    EXPECT_EQ(val, 1);
+}
 
-// TEST(Channel, SelectBasicWrite) {
-    // sharp::Channel<int> c{1};
-    // int val = 0;
-    // sharp::select(
-        // std::make_pair(std::ref(c), [](auto) {
-            // EXPECT_TRUE(false);
-        // }),
-        // std::make_pair(std::ref(c), [&val]() -> int {
-            // ++val;
-            // return 2;
-        // })
-    // );
-    // auto value = c.try_read();
-    // EXPECT_TRUE(value);
-    // EXPECT_EQ(value.value(), 2);
-// }
+TEST(Channel, SelectBasicWrite) {
+    sharp::Channel<int> c{1};
+    int val = 0;
+    sharp::select(
+        sharp::make_case(c, [](auto) {
+            EXPECT_TRUE(false);
+        }),
+        sharp::make_case(c, [&val]() -> int {
+            ++val;
+            return 2;
+        })
+    );
+    auto value = c.try_read();
+    EXPECT_TRUE(value);
+    EXPECT_EQ(value.value(), 2);
+}
+
+TEST(Channel, SelectDefault) {
+    sharp::Channel<int> c;
+    auto default_executed = false;
+    sharp::select(
+        sharp::make_case(c, [](auto) {
+            EXPECT_TRUE(false);
+        }),
+        sharp::make_case(sharp::default_case::tag, [&]() {
+            default_executed = true;
+        })
+    );
+    EXPECT_TRUE(default_executed);
+
+    // the default case is not executed when another case is ready
+    sharp::Channel<int> d{1};
+    d.send(1);
+    auto value = 0;
+    sharp::select(
+        sharp::make_case(sharp::default_case::tag, []() {
+            EXPECT_TRUE(false);
+        }),
+        sharp::make_case(d, [&](auto v) { value = v; })
+    );
+    EXPECT_EQ(value, 1);
+}
+
+TEST(Channel, SelectBlocksUntilReady) {
+    sharp::Channel<int> one;
+    sharp::Channel<int> two;
+
+    for (auto i = 0; i < number_iterations; ++i) {
+        auto th = std::thread{[&]() {
+            if (i % 2) {
+                one.send(i);
+            } else {
+                two.send(i);
+            }
+        }};
+
+        auto value = -1;
+        sharp::select(
+            sharp::make_case(one, [&](auto v) {
+                EXPECT_EQ(i % 2, 1);
+                value = v;
+            }),
+            sharp::make_case(two, [&](auto v) {
+                EXPECT_EQ(i % 2, 0);
+                value = v;
+            })
+        );
+        th.join();
+        EXPECT_EQ(value, i);
+    }
+}
+
+TEST(Channel, SelectIsFair) {
+    sharp::Channel<int> one{1};
+    sharp::Channel<int> two{1};
+    auto counts = std::array<int, 2>{};
+
+    for (auto i = 0; i < number_iterations; ++i) {
+        one.try_send(1);
+        two.try_send(2);
+        sharp::select(
+            sharp::make_case(one, [&](auto) { ++counts[0]; }),
+            sharp::make_case(two, [&](auto) { ++counts[1]; })
+        );
+    }
+
+    // both channels are always ready, so both should be picked a fair
+    // number of times
+    EXPECT_GT(counts[0], number_iterations / 4);
+    EXPECT_GT(counts[1], number_iterations / 4);
+}
+
+TEST(Channel, SelectDoesNotStrandSends) {
+    for (auto i = 0; i < number_iterations; ++i) {
+        sharp::Channel<int> one;
+        sharp::Channel<int> two{1};
+        std::atomic<bool> sent{false};
+
+        // a send on the unbuffered channel only completes if the select
+        // takes it, so if the select picks the other channel the sender has
+        // to still be waiting for a reader
+        auto sender = std::thread{[&]() {
+            one.send(1);
+            sent = true;
+        }};
+        auto other = std::thread{[&]() { two.send(2); }};
+
+        auto picked = 0;
+        sharp::select(
+            sharp::make_case(one, [&](auto v) { picked = v; }),
+            sharp::make_case(two, [&](auto v) { picked = v; })
+        );
+        other.join();
+        if (picked == 2) {
+            EXPECT_FALSE(sent.load());
+            EXPECT_EQ(one.read(), 1);
+        } else {
+            EXPECT_EQ(picked, 1);
+            EXPECT_EQ(two.read(), 2);
+        }
+        sender.join();
+        EXPECT_FALSE(one.try_read());
+        EXPECT_FALSE(two.try_read());
+    }
+}
+
+TEST(Channel, SelectRendezvousWithSelect) {
+    sharp::Channel<int> c;
+    auto th = std::thread{[&]() {
+        for (auto i = 0; i < number_iterations; ++i) {
+            sharp::select(sharp::make_case(c, [&]() { return i; }));
+        }
+    }};
+    for (auto i = 0; i < number_iterations; ++i) {
+        auto value = -1;
+        sharp::select(sharp::make_case(c, [&](auto v) { value = v; }));
+        EXPECT_EQ(value, i);
+    }
+    th.join();
+}
 
 template <typename InputIt>
 void sum(InputIt begin, InputIt end, sharp::Channel<int>& c) {
@@ -134,59 +267,63 @@ TEST(Channel, ExampleOneTest) {
     auto s = std::vector<int>{7, 2, 8, -9, 4, 0};
 
     sharp::Channel<int> c;
-    std::thread{[&]() { sum(s.begin(), s.begin() + s.size()/2, c); }}.detach();
-    std::thread{[&]() { sum(s.begin() + s.size()/2, s.end(), c); }}.detach();
+    auto one = std::thread{[&]() { sum(s.begin(), s.begin() + s.size()/2, c); }};
+    auto two = std::thread{[&]() { sum(s.begin() + s.size()/2, s.end(), c); }};
 
     auto x = c.read();
     auto y = c.read();
 
+    // the senders can still be unlocking the channel after the reads return
+    one.join();
+    two.join();
+
     EXPECT_TRUE(x == 17 || x == -5);
     EXPECT_TRUE(y == 17 || y == -5);
 }
 
 
-// void fibonacci(sharp::Channel<int>& c, sharp::Channel<int>& quit) {
-    // auto x = 0, y = 1;
+void fibonacci(sharp::Channel<int>& c, sharp::Channel<int>& quit) {
+    auto x = 0, y = 1;
 
-    // auto should_continue = true;
-    // while (should_continue) {
+    auto should_continue = true;
+    while (should_continue) {
 
-        // sharp::select(
-            // std::make_pair(std::ref(c), [&] () -> int {
+        sharp::select(
+            sharp::make_case(c, [&] () -> int {
 
-                // auto to_send = x, new_y = x + y;
-                // x = y;
-                // y = new_y;
+                auto to_send = x, new_y = x + y;
+                x = y;
+                y = new_y;
 
-                // return to_send;
-            // }),
+                return to_send;
+            }),
 
-            // std::make_pair(std::ref(quit), [&](auto) {
-                // should_continue = false;
-            // })
-        // );
-    // }
-// }
+            sharp::make_case(quit, [&](auto) {
+                should_continue = false;
+            })
+        );
+    }
+}
 
-// TEST(Channel, ExampleTwoTest) {
+TEST(Channel, ExampleTwoTest) {
 
-    // for (auto i = 0; i < number_iterations; ++i) {
-        // sharp::Channel<int> c;
-        // sharp::Channel<int> quit;
-        // auto results = std::vector<int>{0, 1, 1, 2, 3, 5, 8, 13, 21, 34};
+    for (auto i = 0; i < number_iterations; ++i) {
+        sharp::Channel<int> c;
+        sharp::Channel<int> quit;
+        auto results = std::vector<int>{0, 1, 1, 2, 3, 5, 8, 13, 21, 34};
 
-        // auto th = std::thread{[&]() {
-            // for (auto i = 0; i < 10; ++i) {
-                // auto val = c.read();
-                // EXPECT_EQ(val, results[i]);
-            // }
-            // quit.send(0);
-        // }};
+        auto th = std::thread{[&]() {
+            for (auto i = 0; i < 10; ++i) {
+                auto val = c.read();
+                EXPECT_EQ(val, results[i]);
+            }
+            quit.send(0);
+        }};
 
-        // fibonacci(c, quit);
-        // th.join();
-    // }
-// }
+        fibonacci(c, quit);
+        th.join();
+    }
+}
 
 // void fibonacci_range(sharp::Channel<int>& c) {
     // auto x = 0, y = 1;
@@ -215,3 +352,463 @@ TEST(Channel, ExampleOneTest) {
         // EXPECT_EQ(val, results[counter++]);
     // }
 // }
+
+TEST(Channel, SpscBasic) {
+    sharp::Channel<int, sharp::Spsc> c{2};
+    EXPECT_FALSE(c.try_read());
+    EXPECT_TRUE(c.try_send(1));
+    EXPECT_TRUE(c.try_send(2));
+    EXPECT_FALSE(c.try_send(3));
+    EXPECT_EQ(c.read(), 1);
+    EXPECT_EQ(c.try_read().value(), 2);
+    EXPECT_FALSE(c.try_read());
+}
+
+TEST(Channel, SpscDestroysUnreadElements) {
+    auto shared = std::make_shared<int>(1);
+    {
+        sharp::Channel<std::shared_ptr<int>, sharp::Spsc> c{4};
+        c.send(shared);
+        c.send(shared);
+        c.send(shared);
+        EXPECT_EQ(c.read(), shared);
+        EXPECT_EQ(shared.use_count(), 3);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(Channel, SpscThreaded) {
+    for (auto buffer_size : {0, 1, 7, 64}) {
+        sharp::Channel<std::unique_ptr<int>, sharp::Spsc> c{buffer_size};
+        auto th = std::thread{[&]() {
+            for (auto i = 0; i < number_iterations * 100; ++i) {
+                c.send(std::make_unique<int>(i));
+            }
+        }};
+
+        for (auto i = 0; i < number_iterations * 100; ++i) {
+            EXPECT_EQ(*c.read(), i);
+        }
+        th.join();
+    }
+}
+
+namespace {
+
+template <typename ChannelType>
+void test_close(ChannelType& c) {
+    c.send(1);
+    c.close();
+    EXPECT_TRUE(c.is_closed());
+
+    // elements sent before the close can still be read
+    EXPECT_EQ(c.read(), 1);
+    EXPECT_THROW(c.read(), sharp::ChannelClosedError);
+    EXPECT_THROW(c.try_read(), sharp::ChannelClosedError);
+    EXPECT_THROW(c.send(2), sharp::ChannelClosedError);
+    EXPECT_THROW(c.try_send(2), sharp::ChannelClosedError);
+    EXPECT_FALSE(c.read_try().has_value());
+}
+
+template <typename ChannelType>
+void test_close_wakes_readers(ChannelType& c) {
+    auto readers = std::vector<std::thread>{};
+    for (auto i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            EXPECT_THROW(c.read(), sharp::ChannelClosedError);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    c.close();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+}
+
+} // namespace anonymous
+
+TEST(Channel, Close) {
+    {
+        sharp::Channel<int> c{1};
+        test_close(c);
+    }
+    {
+        sharp::Channel<int, sharp::Spsc> c{1};
+        test_close(c);
+    }
+    {
+        sharp::Channel<int, sharp::Mpmc> c{1};
+        test_close(c);
+    }
+}
+
+TEST(Channel, CloseWakesReaders) {
+    {
+        sharp::Channel<int> c;
+        test_close_wakes_readers(c);
+    }
+    {
+        sharp::Channel<int, sharp::Mpmc> c;
+        test_close_wakes_readers(c);
+    }
+}
+
+TEST(Channel, CloseWakesSelect) {
+    sharp::Channel<int> c;
+    auto th = std::thread{[&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        c.close();
+    }};
+    EXPECT_THROW(sharp::select(sharp::make_case(c, [](auto) {})),
+                 sharp::ChannelClosedError);
+    th.join();
+}
+
+TEST(Channel, MpmcBasic) {
+    sharp::Channel<std::unique_ptr<int>, sharp::Mpmc> c{2};
+    EXPECT_FALSE(c.try_read());
+    EXPECT_TRUE(c.try_send(std::make_unique<int>(1)));
+    EXPECT_TRUE(c.try_send(std::make_unique<int>(2)));
+
+    // a failed try_send does not move from the value
+    auto three = std::make_unique<int>(3);
+    EXPECT_FALSE(c.try_send(std::move(three)));
+    EXPECT_TRUE(three);
+
+    EXPECT_EQ(*c.read(), 1);
+    EXPECT_EQ(*c.try_read().value(), 2);
+    EXPECT_FALSE(c.try_read());
+}
+
+namespace {
+
+class ThrowsOnCopy {
+public:
+    explicit ThrowsOnCopy(int value_in) : value{value_in} {}
+    ThrowsOnCopy(const ThrowsOnCopy& other) : value{other.value} {
+        if (other.value < 0) {
+            throw std::runtime_error{"copy"};
+        }
+    }
+
+    int value;
+};
+
+} // namespace anonymous
+
+TEST(Channel, MpmcThrowingSend) {
+    sharp::Channel<ThrowsOnCopy, sharp::Mpmc> c{2};
+
+    // a send whose element throws on construction does not take up a slot
+    auto bad = ThrowsOnCopy{-1};
+    EXPECT_THROW(c.send(bad), std::runtime_error);
+    EXPECT_THROW(c.try_send(bad), std::runtime_error);
+    EXPECT_FALSE(c.try_read());
+
+    auto good = ThrowsOnCopy{1};
+    c.send(good);
+    EXPECT_TRUE(c.try_send(good));
+    EXPECT_EQ(c.try_read().value().value, 1);
+    EXPECT_EQ(c.try_read().value().value, 1);
+    EXPECT_FALSE(c.try_read());
+}
+
+TEST(Channel, MpmcBatchStopsAtException) {
+    sharp::Channel<ThrowsOnCopy, sharp::Mpmc> c{4};
+
+    // the element that fails to copy is sent as an exception, a batch read
+    // returns what is before it and the next read throws it
+    auto values = std::vector<ThrowsOnCopy>{};
+    values.reserve(3);
+    for (auto value : {1, -1, 2}) {
+        values.emplace_back(value);
+    }
+    c.send_batch(values);
+
+    auto read = std::vector<ThrowsOnCopy>{};
+    EXPECT_EQ(c.read_batch(std::back_inserter(read), 10), 1);
+    EXPECT_THROW(c.read_batch(std::back_inserter(read), 10),
+                 std::runtime_error);
+    EXPECT_EQ(c.try_read_batch(std::back_inserter(read), 10), 1);
+    ASSERT_EQ(read.size(), 2);
+    EXPECT_EQ(read[0].value, 1);
+    EXPECT_EQ(read[1].value, 2);
+    EXPECT_EQ(c.try_read_batch(std::back_inserter(read), 10), 0);
+}
+
+TEST(Channel, MpmcBatchInputIterators) {
+    sharp::Channel<int, sharp::Mpmc> c{4};
+    auto stream = std::istringstream{"1 2 3"};
+    c.send_batch(std::istream_iterator<int>{stream},
+                 std::istream_iterator<int>{});
+
+    auto read = std::vector<int>{};
+    EXPECT_EQ(c.read_batch(std::back_inserter(read), 10), 3);
+    EXPECT_EQ(read, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(Channel, MpmcThreaded) {
+    constexpr auto threads = 4;
+    constexpr auto per_thread = static_cast<int>(number_iterations) * 10;
+
+    sharp::Channel<int, sharp::Mpmc> c{8};
+    std::vector<std::atomic<int>> seen(threads * per_thread);
+    auto producers = std::vector<std::thread>{};
+    auto consumers = std::vector<std::thread>{};
+    for (auto i = 0; i < threads; ++i) {
+        producers.emplace_back([&, i]() {
+            for (auto j = 0; j < per_thread; ++j) {
+                c.send(i * per_thread + j);
+            }
+        });
+        consumers.emplace_back([&]() {
+            while (true) {
+                auto value = c.read_try();
+                if (!value.has_value()) {
+                    break;
+                }
+                ++seen[value.value()];
+            }
+        });
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    c.close();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    // every value was read exactly once
+    for (auto& count : seen) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
+namespace {
+
+template <typename ChannelType>
+void test_batch(ChannelType& c) {
+    auto values = std::vector<int>{1, 2, 3};
+    c.send_batch(values);
+
+    auto read = std::vector<int>{};
+    EXPECT_EQ(c.try_read_batch(std::back_inserter(read), 2), 2);
+    EXPECT_EQ(read, (std::vector<int>{1, 2}));
+    EXPECT_EQ(c.read_batch(std::back_inserter(read), 10), 1);
+    EXPECT_EQ(read, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(c.try_read_batch(std::back_inserter(read), 10), 0);
+
+    c.send_batch(values.begin(), values.begin() + 1);
+    c.close();
+    EXPECT_THROW(c.send_batch(values), sharp::ChannelClosedError);
+    EXPECT_EQ(c.read_batch(std::back_inserter(read), 10), 1);
+    EXPECT_THROW(c.read_batch(std::back_inserter(read), 10),
+                 sharp::ChannelClosedError);
+    EXPECT_THROW(c.try_read_batch(std::back_inserter(read), 10),
+                 sharp::ChannelClosedError);
+}
+
+template <typename ChannelType>
+void test_batch_threaded(ChannelType& c) {
+    constexpr auto total = static_cast<int>(number_iterations) * 7;
+    auto sender = std::thread{[&]() {
+        auto batch = std::vector<int>(7);
+        for (auto i = 0; i < total; i += batch.size()) {
+            std::iota(batch.begin(), batch.end(), i);
+            c.send_batch(batch);
+        }
+    }};
+
+    // the elements arrive in order, in batches of arbitrary sizes
+    auto read = std::vector<int>{};
+    while (static_cast<int>(read.size()) < total) {
+        EXPECT_GT(c.read_batch(std::back_inserter(read), 5), 0);
+    }
+    sender.join();
+
+    for (auto i = 0; i < total; ++i) {
+        EXPECT_EQ(read[i], i);
+    }
+}
+
+} // namespace anonymous
+
+TEST(Channel, Batch) {
+    {
+        sharp::Channel<int> c{4};
+        test_batch(c);
+    }
+    {
+        sharp::Channel<int, sharp::Spsc> c{4};
+        test_batch(c);
+    }
+    {
+        sharp::Channel<int, sharp::Mpmc> c{4};
+        test_batch(c);
+    }
+}
+
+TEST(Channel, BatchThreaded) {
+    {
+        sharp::Channel<int> c{8};
+        test_batch_threaded(c);
+    }
+    {
+        sharp::Channel<int, sharp::Spsc> c{8};
+        test_batch_threaded(c);
+    }
+    {
+        sharp::Channel<int, sharp::Mpmc> c{8};
+        test_batch_threaded(c);
+    }
+}
+
+TEST(Channel, MpmcBatchThreaded) {
+    constexpr auto threads = 4;
+    constexpr auto per_thread = static_cast<int>(number_iterations) * 7;
+
+    sharp::Channel<int, sharp::Mpmc> c{16};
+    std::vector<std::atomic<int>> seen(threads * per_thread);
+    auto producers = std::vector<std::thread>{};
+    auto consumers = std::vector<std::thread>{};
+    for (auto i = 0; i < threads; ++i) {
+        producers.emplace_back([&, i]() {
+            auto batch = std::vector<int>(7);
+            for (auto j = 0; j < per_thread; j += batch.size()) {
+                std::iota(batch.begin(), batch.end(), i * per_thread + j);
+                c.send_batch(batch);
+            }
+        });
+        consumers.emplace_back([&]() {
+            auto read = std::vector<int>{};
+            try {
+                while (true) {
+                    read.clear();
+                    c.read_batch(std::back_inserter(read), 5);
+                    for (auto value : read) {
+                        ++seen[value];
+                    }
+                }
+            } catch (sharp::ChannelClosedError&) {}
+        });
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    c.close();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    for (auto& count : seen) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
+TEST(Channel, AsyncReadThenSend) {
+    sharp::Channel<int> c;
+    auto future = c.async_read();
+    EXPECT_FALSE(future.is_ready());
+
+    // the queued read is a reader waiting on the other end, so a send on an
+    // unbuffered channel goes through
+    EXPECT_TRUE(c.try_send(1));
+    EXPECT_TRUE(future.is_ready());
+    EXPECT_EQ(future.get(), 1);
+}
+
+TEST(Channel, AsyncSendThenRead) {
+    sharp::Channel<int> c;
+    auto one = c.async_send(1);
+    auto two = c.async_send(2);
+    EXPECT_FALSE(one.is_ready());
+    EXPECT_FALSE(c.try_read());
+
+    EXPECT_EQ(c.read(), 1);
+    EXPECT_TRUE(one.is_ready());
+    EXPECT_FALSE(two.is_ready());
+    EXPECT_EQ(c.read(), 2);
+    EXPECT_TRUE(two.is_ready());
+    EXPECT_EQ(one.get(), sharp::Unit{});
+}
+
+TEST(Channel, AsyncSendAndReadPair) {
+    sharp::Channel<int> c{1};
+    auto send = c.async_send(1);
+    EXPECT_TRUE(send.is_ready());
+    auto read = c.async_read();
+    EXPECT_TRUE(read.is_ready());
+    EXPECT_EQ(read.get(), 1);
+
+    // a queued read and a queued send complete each other
+    auto second_read = c.async_read();
+    auto second_send = c.async_send(2);
+    EXPECT_TRUE(second_send.is_ready());
+    EXPECT_EQ(second_read.get(), 2);
+}
+
+TEST(Channel, AsyncClose) {
+    sharp::Channel<int> c;
+    auto read = c.async_read();
+    sharp::Channel<int> other;
+    auto send = other.async_send(1);
+    c.close();
+    other.close();
+
+    EXPECT_THROW(read.get(), sharp::ChannelClosedError);
+    EXPECT_THROW(send.get(), sharp::ChannelClosedError);
+    EXPECT_THROW(c.async_read().get(), sharp::ChannelClosedError);
+    EXPECT_THROW(c.async_send(1).get(), sharp::ChannelClosedError);
+}
+
+TEST(Channel, AsyncContinuationsUseChannel) {
+    // continuations run after the channel is unlocked, so they can chain
+    // more operations on the same channel
+    sharp::Channel<int> c{1};
+    auto values = std::vector<int>{};
+    std::function<int(sharp::Future<int>)> consume;
+    consume = [&](auto future) {
+        auto value = future.get();
+        values.push_back(value);
+        if (value < 10) {
+            c.async_read().then(consume);
+        }
+        return value;
+    };
+    c.async_read().then(consume);
+
+    for (auto i = 1; i <= 10; ++i) {
+        c.send(i);
+    }
+    EXPECT_EQ(values.size(), 10);
+}
+
+TEST(Channel, AsyncManyReaders) {
+    constexpr auto readers = static_cast<int>(number_iterations);
+
+    sharp::Channel<int> c;
+    std::atomic<int> sum{0};
+    auto futures = std::vector<sharp::Future<int>>{};
+    for (auto i = 0; i < readers; ++i) {
+        futures.push_back(c.async_read().then([&](auto future) {
+            auto value = future.get();
+            sum.fetch_add(value);
+            return value;
+        }));
+    }
+
+    auto sender = std::thread{[&]() {
+        for (auto i = 0; i < readers; ++i) {
+            c.send(i);
+        }
+    }};
+    sender.join();
+
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(sum.load(), readers * (readers - 1) / 2);
+}
@@ -0,0 +1,52 @@
+/**
+ * @file AsyncSynchronized.hpp
+ * @author Aaryaman Sagar
+ *
+ * A version of Concurrent::synchronized() that never blocks the calling
+ * thread and returns a future instead.  This lives in its own header so that
+ * users of Concurrent do not pull in executors and futures
+ */
+
+#pragma once
+
+#include <sharp/Concurrent/Concurrent.hpp>
+#include <sharp/Executor/Executor.hpp>
+#include <sharp/Future/Future.hpp>
+
+namespace sharp {
+
+/**
+ * @function async_synchronized
+ *
+ * A version of synchronized() that never blocks the calling thread, and
+ * returns a future for the value returned by the function instead.  A
+ * function that returns void gives a future of sharp::Unit
+ *
+ *      auto size = sharp::async_synchronized(vec, executor, [](auto& vec) {
+ *          vec.push_back(1);
+ *          return vec.size();
+ *      });
+ *
+ * If the lock is free the function is run right away on the calling thread.
+ * Otherwise it is queued, and the thread holding the lock runs all the
+ * queued functions right before it releases the lock.  A task is also added
+ * to the executor that locks the object and runs the function if the holder
+ * released the lock before the function was queued.  If a holder ran the
+ * function first the task does nothing and does not touch the object, which
+ * might be gone by then.  So the executor should not be an inline executor
+ * if the caller must never block
+ *
+ * The promise is fulfilled after the lock is released, so continuations
+ * attached to the future can go back to the object.  The function itself
+ * runs with the lock held and must not.  The object has to stay alive till
+ * the future is fulfilled, and the mutex has to support try_lock()
+ */
+template <typename Type, typename Mutex, typename Cv, typename Func>
+auto /* sharp::Future<> */ async_synchronized(
+        Concurrent<Type, Mutex, Cv>& concurrent,
+        sharp::Executor& executor,
+        Func&& func);
+
+} // namespace sharp
+
+#include <sharp/Concurrent/AsyncSynchronized.ipp>
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <sharp/Concurrent/AsyncSynchronized.hpp>
+#include <sharp/Concurrent/Concurrent.hpp>
+#include <sharp/Executor/Executor.hpp>
+#include <sharp/Functional/Functional.hpp>
+#include <sharp/Future/Future.hpp>
+#include <sharp/Try/Try.hpp>
+#include <sharp/Utility/Utility.hpp>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace sharp {
+
+namespace concurrent_detail {
+
+    /**
+     * Run a function and capture its result or the exception it threw in a
+     * Try, void results are turned into sharp::Unit
+     */
+    template <typename Value, typename Func, typename Type>
+    sharp::Try<Value> invoke_try(Func& func, Type& datum, std::false_type) {
+        return sharp::Try<Value>{std::in_place, func(datum)};
+    }
+    template <typename Value, typename Func, typename Type>
+    sharp::Try<Value> invoke_try(Func& func, Type& datum, std::true_type) {
+        func(datum);
+        return sharp::Try<Value>{std::in_place};
+    }
+    template <typename Value, typename Func, typename Type>
+    sharp::Try<Value> invoke_try(Func& func, Type& datum) {
+        try {
+            return invoke_try<Value>(func, datum,
+                    std::is_void<decltype(func(datum))>{});
+        } catch (...) {
+            return std::current_exception();
+        }
+    }
+
+    /**
+     * A friend of Concurrent, so that async_synchronized() can get to the
+     * mutex and the queue of functions without being a member
+     */
+    class AsyncSynchronized {
+    public:
+        template <typename Type, typename Mutex, typename Cv, typename Func>
+        static auto run(Concurrent<Type, Mutex, Cv>& concurrent,
+                        sharp::Executor& executor,
+                        Func&& func) {
+            using ConcurrentType = Concurrent<Type, Mutex, Cv>;
+            using AsyncClosure = typename ConcurrentType::AsyncClosure;
+            using AsyncQueue = typename ConcurrentType::AsyncQueue;
+            using AsyncTask = typename ConcurrentType::AsyncTask;
+            using Result = std::decay_t<decltype(func(std::declval<Type&>()))>;
+            using Value = std::conditional_t<
+                std::is_void<Result>::value, sharp::Unit, Result>;
+
+            auto promise = sharp::Promise<Value>{};
+            auto future = promise.get_future();
+            auto closure = AsyncClosure{[func = std::forward<Func>(func),
+                    promise = std::move(promise)](Type& datum) mutable {
+                auto result = invoke_try<Value>(func, datum);
+                return sharp::UniqueFunction<void()>{[
+                        promise = std::move(promise),
+                        result = std::move(result)]() mutable {
+                    if (result.has_exception()) {
+                        promise.set_exception(result.exception());
+                    } else {
+                        promise.set_value(std::move(result).value());
+                    }
+                }};
+            }};
+
+            // run the function right away if the lock is free, releasing the
+            // lock runs anything else that was queued as well
+            if (concurrent.mtx.try_lock()) {
+                auto completion = [&]() {
+                    auto lock = concurrent.lock(std::adopt_lock);
+                    return closure(*lock);
+                }();
+                completion();
+                return future;
+            }
+
+            auto queue = concurrent.async_queue.load(std::memory_order_acquire);
+            if (!queue) {
+                auto fresh = std::make_unique<AsyncQueue>();
+                if (concurrent.async_queue.compare_exchange_strong(
+                            queue, fresh.get(), std::memory_order_acq_rel)) {
+                    queue = fresh.release();
+                }
+            }
+            auto task = std::make_shared<AsyncTask>();
+            task->closure = std::move(closure);
+            {
+                std::lock_guard<std::mutex> lck{queue->mtx};
+                queue->tasks.push_back(task);
+            }
+
+            // the holder might have released the lock before the push above,
+            // in which case nobody would run the function.  The executor task
+            // covers that, if it claims the function then the future has not
+            // been fulfilled and the object is still alive.  If it loses then
+            // the object might already have been destroyed, so it must not be
+            // touched
+            executor.add([&concurrent, task = std::move(task)]() {
+                if (task->claimed.exchange(true, std::memory_order_acq_rel)) {
+                    return;
+                }
+                auto completion = [&]() {
+                    auto lock = concurrent.lock();
+                    return task->closure(*lock);
+                }();
+                completion();
+            });
+            return future;
+        }
+    };
+} // namespace concurrent_detail
+
+template <typename Type, typename Mutex, typename Cv, typename Func>
+auto async_synchronized(Concurrent<Type, Mutex, Cv>& concurrent,
+                        sharp::Executor& executor,
+                        Func&& func) {
+    return concurrent_detail::AsyncSynchronized::run(
+        concurrent, executor, std::forward<Func>(func));
+}
+
+} // namespace sharp
@@ -24,14 +24,40 @@
 #include <sharp/Tags/Tags.hpp>
 #include <sharp/Portability/cpp17.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <utility>
 #include <type_traits>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace sharp {
 
+/**
+ * Policies that can be passed in place of the mutex type to select a
+ * specialized implementation of Concurrent
+ *
+ * Rcu selects a read copy update implementation for read mostly data.
+ * Readers do not lock at all and see a snapshot, writers copy the data and
+ * publish the copy, see sharp/Concurrent/detail/RcuConcurrent.hpp
+ *
+ * Seqlock selects a sequence lock for small trivially copyable values.
+ * Readers copy the value out optimistically and retry if a write overlapped,
+ * without writing to shared memory, see
+ * sharp/Concurrent/detail/SeqlockConcurrent.hpp
+ *
+ * Combining selects flat combining for synchronized() on heavily contended
+ * data.  The thread holding the lock runs the closures other threads have
+ * published, see sharp/Concurrent/detail/CombiningConcurrent.hpp
+ */
+class Rcu {};
+class Seqlock {};
+class Combining {};
+
 /**
  * @class Concurrent
  *
@@ -116,7 +142,7 @@ template <typename Type,
           typename Mutex = std::mutex,
           typename Cv = typename concurrent_detail::GetCv<Mutex>::type>
 class Concurrent : public concurrent_detail::Conditions<
-            Mutex, Cv, sharp::Function<bool(const Type&)>> {
+            Mutex, Cv, concurrent_detail::ConditionRef<Type>> {
 public:
 
     /**
@@ -225,6 +251,56 @@ private:
         template <typename Condition>
         void wait(Condition condition);
 
+        /**
+         * Keyed waits, the condition is only re-evaluated on unlocks that
+         * follow a call to touch() with the same key, instead of on every
+         * unlock.  This keeps the cost of an unlock proportional to the
+         * waiters that could actually be affected when there are a lot of
+         * threads waiting on different parts of the same object
+         *
+         *      // waiting thread
+         *      auto lock = jobs.lock();
+         *      lock.wait(id, [id](auto& jobs) {
+         *          return jobs.at(id).is_done();
+         *      });
+         *
+         *      // writing thread
+         *      auto lock = jobs.lock();
+         *      lock->at(id).finish();
+         *      lock.touch(id);
+         *
+         * A writer that changes something a keyed waiter is waiting on must
+         * touch the key, otherwise the waiter is not woken up.  Keys are
+         * hashed with std::hash, two keys that hash to the same value only
+         * cause extra evaluations of the conditions.  Unkeyed waits are not
+         * affected by keys and continue to be re-evaluated on every unlock
+         */
+        template <typename Key, typename Condition>
+        void wait(const Key& key, Condition condition);
+        template <typename Key>
+        void touch(const Key& key);
+
+        /**
+         * Timed versions of wait(), these return once the condition is true
+         * or the timeout expires, whichever happens first, and return the
+         * value of the condition at that point.  The lock is held on return
+         * in both cases
+         *
+         *      auto lock = data.lock();
+         *      auto ok = lock.wait_for(10ms, [](auto& data) {
+         *          return data.is_ready();
+         *      });
+         *      if (!ok) {
+         *          return Status::TIMEOUT;
+         *      }
+         */
+        template <typename Rep, typename Period, typename Condition>
+        bool wait_for(const std::chrono::duration<Rep, Period>& duration,
+                      Condition condition);
+        template <typename Clock, typename Duration, typename Condition>
+        bool wait_until(const std::chrono::time_point<Clock, Duration>& tp,
+                        Condition condition);
+
         /**
          * Friend the outer concurrent class, it is the only one that can
          * construct objects of type LockProxy
@@ -396,6 +472,11 @@ public:
      */
     Concurrent& operator=(Concurrent&& other);
 
+    /**
+     * Destroys the queue for async_synchronized() if there is one
+     */
+    ~Concurrent();
+
     /**
      * Friend the proxy class and the bookkeeping class, they should be able to
      * access internals of this class
@@ -406,6 +487,7 @@ public:
     friend class concurrent_detail::ConditionsLockWrap;
     template <typename... Args>
     friend std::tuple<decltype(std::declval<Args>().lock())...> lock(Args&...);
+    friend class concurrent_detail::AsyncSynchronized;
 
 private:
 
@@ -436,6 +518,46 @@ private:
     auto /* LockProxy<> */ lock(std::adopt_lock_t);
     auto /* LockProxy<> */ lock(std::adopt_lock_t) const;
 
+    /**
+     * The functions queued by async_synchronized().  Each one runs with the
+     * lock held and returns a completion that fulfills its promise, to be
+     * run after the lock is released
+     *
+     * A queued function is shared between the queue and the executor task
+     * that backs it up, whichever of the two sets claimed first runs it
+     */
+    using Completions = std::vector<sharp::UniqueFunction<void()>>;
+    using AsyncClosure = sharp::UniqueFunction<
+        sharp::UniqueFunction<void()>(Type&)>;
+    struct AsyncTask {
+        std::atomic<bool> claimed{false};
+        AsyncClosure closure;
+    };
+    struct AsyncQueue {
+        std::mutex mtx;
+        std::deque<std::shared_ptr<AsyncTask>> tasks;
+    };
+
+    /**
+     * Run all the queued functions, called by write lock proxies right
+     * before they release the lock
+     */
+    Completions drain(concurrent_detail::WriteLockTag);
+    Completions drain(concurrent_detail::ReadLockTag) const {
+        return {};
+    }
+
+    /**
+     * The waiter bookkeeping is not part of the value, so it is mutable and
+     * changed even through a read lock.  With an exclusive mutex the lock
+     * protects it and with a shared mutex readers serialize on it separately
+     */
+    using ConditionsBase = concurrent_detail::Conditions<
+        Mutex, Cv, concurrent_detail::ConditionRef<Type>>;
+    const ConditionsBase& conditions() const {
+        return *this;
+    }
+
     /**
      * The data object that is to be locked and the internal mutex used to
      * synchronize
@@ -443,6 +565,12 @@ private:
     Type datum;
     mutable Mutex mtx;
 
+    /**
+     * Only allocated on the first call to async_synchronized(), so objects
+     * that never use it pay for one pointer
+     */
+    std::atomic<AsyncQueue*> async_queue{nullptr};
+
     /**
      * Friend for testing
      */
@@ -466,3 +594,6 @@ std::tuple<decltype(std::declval<Args>().lock())...> lock(Args&... args);
 } // namespace sharp
 
 #include <sharp/Concurrent/Concurrent.ipp>
+#include <sharp/Concurrent/detail/RcuConcurrent.hpp>
+#include <sharp/Concurrent/detail/SeqlockConcurrent.hpp>
+#include <sharp/Concurrent/detail/CombiningConcurrent.hpp>
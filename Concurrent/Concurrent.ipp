@@ -6,8 +6,12 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
 #include <utility>
 #include <type_traits>
 
@@ -73,13 +77,22 @@ void Concurrent<Type, Mutex, Cv>::template LockProxy<C, LockTag>::unlock()
         noexcept {
     // unlock the mutex and go into a null state
     if (this->instance_ptr) {
+        // run the functions queued by async_synchronized() before waking
+        // anyone, so waiters see their effects
+        auto completions = this->instance_ptr->drain(LockTag{});
+
         // Wake threads if possible
-        this->instance_ptr->notify(*this, LockTag{});
+        this->instance_ptr->conditions().notify(*this, LockTag{});
 
         // unlock the mutex, the actual signalling will happen on destruction
         // of the raii object
         concurrent_detail::unlock_mutex(this->instance_ptr->mtx, LockTag{});
         this->instance_ptr = nullptr;
+
+        // fulfill the promises of the queued functions without the lock
+        for (auto& completion : completions) {
+            completion();
+        }
     }
 }
 
@@ -109,7 +122,47 @@ template <typename C, typename LockTag>
 template <typename Condition>
 void Concurrent<Type, Mutex, Cv>::template LockProxy<C, LockTag>::wait(
         Condition condition) {
-    this->instance_ptr->wait(std::move(condition), *this, LockTag{});
+    this->instance_ptr->conditions().wait(std::move(condition), *this,
+            LockTag{});
+}
+
+template <typename Type, typename Mutex, typename Cv>
+template <typename C, typename LockTag>
+template <typename Key, typename Condition>
+void Concurrent<Type, Mutex, Cv>::template LockProxy<C, LockTag>::wait(
+        const Key& key, Condition condition) {
+    this->instance_ptr->conditions().wait(std::move(condition), *this,
+            LockTag{}, std::hash<Key>{}(key));
+}
+
+template <typename Type, typename Mutex, typename Cv>
+template <typename C, typename LockTag>
+template <typename Rep, typename Period, typename Condition>
+bool Concurrent<Type, Mutex, Cv>::template LockProxy<C, LockTag>::wait_for(
+        const std::chrono::duration<Rep, Period>& duration,
+        Condition condition) {
+    return this->wait_until(std::chrono::steady_clock::now() + duration,
+            std::move(condition));
+}
+
+template <typename Type, typename Mutex, typename Cv>
+template <typename C, typename LockTag>
+template <typename Clock, typename Duration, typename Condition>
+bool Concurrent<Type, Mutex, Cv>::template LockProxy<C, LockTag>::wait_until(
+        const std::chrono::time_point<Clock, Duration>& tp,
+        Condition condition) {
+    return this->instance_ptr->conditions().wait(std::move(condition), *this,
+            LockTag{}, concurrent_detail::NO_KEY, tp);
+}
+
+template <typename Type, typename Mutex, typename Cv>
+template <typename C, typename LockTag>
+template <typename Key>
+void Concurrent<Type, Mutex, Cv>::template LockProxy<C, LockTag>::touch(
+        const Key& key) {
+    static_assert(!std::is_const<C>::value,
+            "touch() can only be called with a write lock held");
+    this->instance_ptr->touch(std::hash<Key>{}(key));
 }
 
 /**
@@ -135,6 +188,28 @@ decltype(auto) Concurrent<Type, Mutex, Cv>::synchronized(Func&& func) const {
     return std::forward<Func>(func)(*lock);
 }
 
+template <typename Type, typename Mutex, typename Cv>
+auto Concurrent<Type, Mutex, Cv>::drain(concurrent_detail::WriteLockTag)
+        -> Completions {
+    auto queue = this->async_queue.load(std::memory_order_acquire);
+    if (!queue) {
+        return {};
+    }
+
+    auto tasks = std::deque<std::shared_ptr<AsyncTask>>{};
+    {
+        std::lock_guard<std::mutex> lck{queue->mtx};
+        std::swap(tasks, queue->tasks);
+    }
+    auto completions = Completions{};
+    for (auto& task : tasks) {
+        if (!task->claimed.exchange(true, std::memory_order_acq_rel)) {
+            completions.push_back(task->closure(this->datum));
+        }
+    }
+    return completions;
+}
+
 template <typename Type, typename Mutex, typename Cv>
 auto Concurrent<Type, Mutex, Cv>::lock() {
     return LockProxy<Concurrent, concurrent_detail::WriteLockTag>{*this};
@@ -207,6 +282,11 @@ Concurrent<Type, Mutex, Cv>::Concurrent(Concurrent&& other)
     : Concurrent{sharp::delegate_constructor::tag, other.lock(),
         std::move(other)} {}
 
+template <typename Type, typename Mutex, typename Cv>
+Concurrent<Type, Mutex, Cv>::~Concurrent() {
+    delete this->async_queue.load(std::memory_order_relaxed);
+}
+
 template <typename Type, typename Mutex, typename Cv>
 template <typename... Args>
 Concurrent<Type, Mutex, Cv>::Concurrent(std::in_place_t, Args&&... args)
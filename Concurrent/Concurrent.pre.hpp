@@ -15,11 +15,20 @@
 #include <sharp/Traits/Traits.hpp>
 #include <sharp/TransparentList/TransparentList.hpp>
 #include <sharp/Defer/Defer.hpp>
+#include <sharp/Mutex/Mutex.hpp>
 #include <sharp/Threads/Threads.hpp>
 #include <sharp/Tags/Tags.hpp>
 #include <sharp/ForEach/ForEach.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <cassert>
@@ -89,6 +98,10 @@ namespace concurrent_detail {
     struct GetCv<std::mutex> {
         using type = std::condition_variable;
     };
+    template <typename Int>
+    struct GetCv<sharp::Mutex<Int>> {
+        using type = std::condition_variable_any;
+    };
 
     /**
      * A SFINAE trait for enabling a specialization when the class is
@@ -103,12 +116,82 @@ namespace concurrent_detail {
     InstantiatedWithValidCv<LockProxy<Type, Mutex, InvalidCv>> = true;
 
     /**
-     * Waiters provide the functionality needed to put them to sleep.  In the
-     * case where std::mutex and std::condition_variable are used, the waiter
-     * does not have an additional mutex
+     * The deadline for waits that do not time out
+     */
+    class NoDeadline {};
+
+    /**
+     * A non owning reference to the condition a thread is waiting on.  The
+     * condition lives in the frame of the waiting thread for as long as the
+     * waiter is in a wait list, so storing a pointer to it instead of a copy
+     * means a wait never allocates no matter how big the condition is
      */
+    template <typename Type>
+    class ConditionRef {
+    public:
+        template <typename Condition>
+        explicit ConditionRef(const Condition& condition)
+            : object{static_cast<const void*>(std::addressof(condition))},
+              stub{[](const void* object, const Type& datum) -> bool {
+                  return (*static_cast<const Condition*>(object))(datum);
+              }} {}
+
+        bool operator()(const Type& datum) const {
+            return this->stub(this->object, datum);
+        }
+
+    private:
+        const void* object;
+        bool (*stub)(const void*, const Type&);
+    };
+
+    /**
+     * Waiters provide the functionality needed to put them to sleep.  A
+     * waiter parks on its own address in the process wide parking lot till
+     * the waking thread sets its flag and unparks it, so a waiter is just a
+     * few words on the stack of the waiting thread and does not need a mutex
+     * and a condition variable of its own
+     *
+     * A waiter only returns from wait() after it reacquires a lock that the
+     * waking thread holds while it sets the flag and unparks the waiter.
+     * For std::mutex that is the main mutex, otherwise it is a per waiter
+     * mutex that protects the leader bookkeeping.  So the waiter is never
+     * gone from the stack by the time the waking thread touches it
+     *
+     * Timed waits return whether the waiter was signalled before the
+     * deadline
+     */
+    class WaiterWord {
+    public:
+        void park() {
+            while (!this->should_wake.load(std::memory_order_acquire)) {
+                sharp::park(this, [this]() {
+                    return !this->should_wake.load(std::memory_order_acquire);
+                });
+            }
+        }
+        template <typename Clock, typename Duration>
+        bool park_until(const std::chrono::time_point<Clock, Duration>& tp) {
+            while (!this->should_wake.load(std::memory_order_acquire)) {
+                auto result = sharp::park_until(this, [this]() {
+                    return !this->should_wake.load(std::memory_order_acquire);
+                }, tp);
+                if (result == ParkResult::Timeout) {
+                    return this->should_wake.load(std::memory_order_acquire);
+                }
+            }
+            return true;
+        }
+        void unpark() {
+            this->should_wake.store(1, std::memory_order_release);
+            sharp::unpark_one(this);
+        }
+
+        std::atomic<std::uint32_t> should_wake{0};
+    };
+
     template <typename Mutex>
-    struct WaiterBase {
+    struct WaiterBase : public WaiterWord {
         void lock() {
             mtx.lock();
         }
@@ -117,46 +200,65 @@ namespace concurrent_detail {
         }
         template <typename Lock>
         void wait(Lock&) {
-            auto lck = std::unique_lock<std::mutex>{this->mtx, std::adopt_lock};
-            auto deferred = sharp::defer([&]() { lck.release(); });
-            while (!this->should_wake) {
-                this->cv.wait(lck);
-            }
+            this->mtx.unlock();
+            this->park();
+            this->mtx.lock();
+        }
+        template <typename Lock, typename Clock, typename Duration>
+        bool wait_until(Lock&,
+                        const std::chrono::time_point<Clock, Duration>& tp) {
+            this->mtx.unlock();
+            auto signalled = this->park_until(tp);
+            this->mtx.lock();
+            return signalled;
         }
         template <typename F>
         void notify(F f = [](){}) {
             auto lck = std::unique_lock<std::mutex>{this->mtx};
-            this->should_wake = true;
             f();
-            cv.notify_one();
+            this->unpark();
         }
 
-        bool should_wake{false};
         std::mutex mtx;
-        std::condition_variable cv;
     };
     template <>
-    struct WaiterBase<std::mutex> {
+    struct WaiterBase<std::mutex> : public WaiterWord {
         void lock() {}
         void unlock() {}
         void wait(std::mutex& mtx) {
-            auto lck = std::unique_lock<std::mutex>{mtx, std::adopt_lock};
-            auto deferred = sharp::defer([&]() { lck.release(); });
-            while (!this->should_wake) {
-                this->cv.wait(lck);
-            }
+            mtx.unlock();
+            this->park();
+            mtx.lock();
+        }
+        template <typename Clock, typename Duration>
+        bool wait_until(std::mutex& mtx,
+                        const std::chrono::time_point<Clock, Duration>& tp) {
+            mtx.unlock();
+            auto signalled = this->park_until(tp);
+            mtx.lock();
+            return signalled;
         }
         template <typename F>
         void notify(F f = [](){}) {
-            this->should_wake = true;
             f();
-            cv.notify_one();
+            this->unpark();
         }
-
-        bool should_wake{false};
-        std::condition_variable cv;
     };
 
+    /**
+     * The key for waiters that did not wait on a key, these are re-evaluated
+     * on every unlock.  A keyed waiter that hashes to this is treated as not
+     * having a key, which is always safe, just slower
+     */
+    constexpr auto NO_KEY = std::numeric_limits<std::size_t>::max();
+
+    /**
+     * The number of touched keys that are tracked individually, once more
+     * keys than this are touched every keyed waiter is looked at on the next
+     * unlock, so touching a key never allocates
+     */
+    constexpr auto MAX_DIRTY_KEYS = std::size_t{8};
+
     /**
      * @class Waiter
      *
@@ -167,13 +269,15 @@ namespace concurrent_detail {
     template <typename Condition, typename Mutex>
     struct Waiter : public WaiterBase<Mutex> {
         template <typename C>
-        Waiter(bool is_reader_in, bool is_leader_in, C&& condition_in)
+        Waiter(bool is_reader_in, bool is_leader_in, C&& condition_in,
+               std::size_t key_in = NO_KEY)
             : is_reader{is_reader_in}, is_leader{is_leader_in},
-              condition{std::forward<C>(condition_in)} {}
+              condition{std::forward<C>(condition_in)}, key{key_in} {}
 
         const bool is_reader;
         bool is_leader;
         const Condition condition;
+        const std::size_t key;
     };
 
     /**
@@ -183,14 +287,12 @@ namespace concurrent_detail {
      * abstracted away from the details of the types of locks the Concurrent
      * instance was instantiated with
      *
-     * This class uses the standard C++ API to implement sleeping and waking
-     * up as needed.  This has the benefit of being a standard implementation
-     * and utilizes properties of standard monitor implementations to make the
-     * implementation more efficient.  Each waiter is allocated one condition
-     * variable, this allows us to pick and chose which thread to wake up
+     * Each waiter parks on its own address, this allows us to pick and chose
+     * which thread to wake up
      *
-     * Each waiter is stored on the stack and then in an intrusive list to
-     * prevent inefficient allocations with each wait.  When the
+     * Each waiter is stored on the stack and then in an intrusive list, and
+     * refers to the condition in the frame of the waiting thread instead of
+     * holding a type erased copy, so a wait never allocates.  When the
      * implementation used is not an exclusive mutex only, the wait list
      * itself is protected with a mutex to prevent data races when readers
      * interact with the methods in this class.  If however the implementation
@@ -207,7 +309,8 @@ namespace concurrent_detail {
      * condition variable for sleeping, this can cause problems when used with
      * std::condition_variable_any like spourious wakeups, lifetime
      * problems and added context switches.  The implementation tries to solve
-     * these problems by using std::mutex coupled with std::condition_variable
+     * these problems by parking each waiter on its own address and having
+     * only the thread that decides to wake the waiter up unpark it
      *
      * When a write lock unlocks the mutex it goes through the wait list to
      * see if there are other readers it can wake up, and if it is able to
@@ -235,6 +338,15 @@ namespace concurrent_detail {
      * has the responsiblity for, it has to make sure someone else can wake up
      * the threads later on if the condition becomes true, so it needs to
      * acquire the lock on the global wait queue and put the waiters back
+     *
+     * Waiters can also wait under a key, these are kept in a separate list
+     * and are not looked at on unlock unless a writer marked their key dirty
+     * with touch().  The dirty keys stay dirty until an unlock goes through
+     * the keyed list and finds no waiter under a dirty key whose condition is
+     * satisfied, so when a waiter under a dirty key is woken up the rest of
+     * the list is still looked at when the woken thread unlocks, just like
+     * with the unkeyed list.  Both lists are intrusive and the dirty keys are
+     * kept in a fixed size array, so neither waits nor unlocks allocate
      */
     template <typename Mutex, typename Cv, typename Condition>
     class ConditionsImpl {
@@ -244,7 +356,7 @@ namespace concurrent_detail {
                   typename LockTag>
         void notify_impl(LockProxy& proxy,
                          LockQueue lock_queue, UnlockQueue unlock_queue,
-                         LockTag) {
+                         LockTag) const {
             // if this is a writer or lead reader then try and wake someone up
             // from the wait queue, lead readers should not be able to wake up
             // a reader from the wait list because they should have already
@@ -253,40 +365,67 @@ namespace concurrent_detail {
             auto is_reader = std::is_same<LockTag, ReadLockTag>::value;
             if ((is_reader && proxy.is_leader) || (!is_reader)) {
                 lock_queue();
-                for (auto it = this->waiters.begin(); it != this->waiters.end();
-                     ++it) {
-                    if ((*it)->datum.condition(*proxy)) {
-                        assert(!(is_reader && (*it)->datum.is_reader));
-                        (*it)->datum.notify([&] {
-                            if ((*it)->datum.is_reader) {
-                                (*it)->datum.is_leader = true;
-                            }
-                        });
-                        this->waiters.erase(it);
-                        break;
-                    }
+                auto deferred = sharp::defer([&]() { unlock_queue(); });
+                auto any = [](auto&) { return true; };
+                if (this->notify_one(proxy, this->waiters, is_reader, any)) {
+                    return;
                 }
-                unlock_queue();
+
+                // then the waiters under the keys that were touched, the keys
+                // are cleaned only once none of those can be woken up
+                if (!this->num_dirty_keys) {
+                    return;
+                }
+                auto dirty = [this](auto& waiter) {
+                    return this->is_dirty(waiter.key);
+                };
+                if (this->notify_one(proxy, this->keyed_waiters, is_reader,
+                            dirty)) {
+                    return;
+                }
+                this->num_dirty_keys = 0;
             }
         }
 
+        /**
+         * Mark the waiters under the key as needing to be looked at on the
+         * next unlock, this is called with the lock held exclusively
+         */
+        void touch(std::size_t key) const {
+            if (this->is_dirty(key)) {
+                return;
+            }
+
+            // past the size of the array every key counts as dirty
+            if (this->num_dirty_keys < MAX_DIRTY_KEYS) {
+                this->dirty_keys[this->num_dirty_keys] = key;
+            }
+            ++this->num_dirty_keys;
+        }
+
+        /**
+         * Returns the value of the condition when the wait returns, this is
+         * always true unless a deadline was passed and the wait timed out
+         */
         template <typename C, typename LockProxy, typename Mtx,
                   typename Lock, typename Unlock,
                   typename LockQueue, typename UnlockQueue,
-                  typename LockTag>
-        void wait_impl(C condition, LockProxy& proxy,
+                  typename LockTag, typename Deadline>
+        bool wait_impl(C condition, LockProxy& proxy,
                        Mtx& mutex,
                        Lock lock , Unlock unlock,
                        LockQueue lock_queue, UnlockQueue unlock_queue,
-                       LockTag) {
+                       LockTag, std::size_t key,
+                       const Deadline& deadline) const {
             // if the condition is satisfied already at this point then return
             if (condition(*proxy)) {
-                return;
+                return true;
             }
 
             // otherwise make a wait node and prepare to sleep
             auto&& waiter = WaiterNode{std::in_place,
-                false, std::is_same<LockTag, WriteLockTag>::value, condition};
+                false, std::is_same<LockTag, WriteLockTag>::value, condition,
+                key};
 
             while (true) {
                 // acquire the lock on the queue and also on the waiter
@@ -296,11 +435,17 @@ namespace concurrent_detail {
                 // to hold the queue lock in order to signal a waiter, this
                 // also prevents against spurious waiter wakeups (and thus
                 // prevent lifetime problems with waiter state)
+                //
+                // The wake flag is reset before going back in the queue,
+                // otherwise a waiter that woke up to a false condition would
+                // not sleep the next time around and would end up in the
+                // queue twice
                 lock_queue();
                 waiter.datum.lock();
                 waiter.datum.is_leader = std::is_same<LockTag, WriteLockTag>{};
+                waiter.datum.should_wake.store(0, std::memory_order_relaxed);
                 this->notify_impl(proxy, []{}, []{}, LockTag{});
-                waiters.push_back(&waiter);
+                this->list_for(key).push_back(&waiter);
 
                 // unlock the mutex and the queue mutex and prepare to sleep,
                 // at this point the queue contains the waiter which has not
@@ -308,7 +453,7 @@ namespace concurrent_detail {
                 // waiter is synchronized that way
                 unlock();
                 unlock_queue();
-                waiter.datum.wait(mutex);
+                auto signalled = this->sleep(waiter.datum, mutex, deadline);
 
                 // the order of unlocking the queue mutex and locking the main
                 // mutex is very important, this is needed to prevent against
@@ -319,24 +464,120 @@ namespace concurrent_detail {
                 waiter.datum.unlock();
                 lock();
 
+                // on a timeout the waiter is still in the queue unless it was
+                // signalled right after the deadline, in which case it is
+                // treated like a normal wakeup since it might have been made
+                // the leader
+                if (!signalled) {
+                    lock_queue();
+                    waiter.datum.lock();
+                    signalled = waiter.datum.should_wake.load();
+                    proxy.is_leader = waiter.datum.is_leader;
+                    waiter.datum.unlock();
+                    if (!signalled) {
+                        this->remove(waiter);
+                    }
+                    unlock_queue();
+                }
+
                 // there are some things that need doing when threads wake up,
                 // like chaining reader wake calls, transferring stale waiters
                 // back to the global wait queue to prevent locking on lock
                 // release in user code for leader readers and transferring
                 // the leader baton to another reader for leader reader and
                 // going back to sleep yourself
-                auto should_return = condition(*proxy);
+                //
+                // A wait that timed out returns regardless of the condition
+                auto satisfied = condition(*proxy);
+                auto should_return = satisfied || !signalled;
                 this->after_wake(proxy, waiter, lock_queue, unlock_queue,
                                  should_return, LockTag{});
 
                 // if the condition is true now then return
                 if (should_return) {
-                    return;
+                    return satisfied;
                 }
             }
         }
 
     private:
+        /**
+         * Wake up the first waiter in the list that passes the filter and
+         * whose condition is satisfied, returns true if there was one
+         */
+        template <typename LockProxy, typename List, typename Filter>
+        bool notify_one(LockProxy& proxy, List& list, bool is_reader,
+                        Filter filter) const {
+            for (auto it = list.begin(); it != list.end(); ++it) {
+                if (filter((*it)->datum) && (*it)->datum.condition(*proxy)) {
+                    assert(!(is_reader && (*it)->datum.is_reader));
+                    static_cast<void>(is_reader);
+                    (*it)->datum.notify([&] {
+                        if ((*it)->datum.is_reader) {
+                            (*it)->datum.is_leader = true;
+                        }
+                    });
+                    list.erase(it);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Sleep on the waiter till it is signalled or the deadline passes,
+         * returns false on a timeout
+         */
+        template <typename Waiter, typename Mtx>
+        bool sleep(Waiter& waiter, Mtx& mutex, const NoDeadline&) const {
+            waiter.wait(mutex);
+            return true;
+        }
+        template <typename Waiter, typename Mtx, typename Clock,
+                  typename Duration>
+        bool sleep(Waiter& waiter, Mtx& mutex,
+                   const std::chrono::time_point<Clock, Duration>& deadline)
+                const {
+            return waiter.wait_until(mutex, deadline);
+        }
+
+        /**
+         * Take a waiter that timed out off its queue
+         */
+        template <typename Node>
+        void remove(Node& waiter) const {
+            auto& list = this->list_for(waiter.datum.key);
+            for (auto it = list.begin(); it != list.end(); ++it) {
+                if (*it == &waiter) {
+                    list.erase(it);
+                    break;
+                }
+            }
+        }
+
+        /**
+         * The list a waiter with the given key goes in
+         */
+        auto& list_for(std::size_t key) const {
+            if (key == NO_KEY) {
+                return this->waiters;
+            }
+            return this->keyed_waiters;
+        }
+
+        /**
+         * Whether touch() was called with the key since the keyed waiters
+         * were last looked at
+         */
+        bool is_dirty(std::size_t key) const {
+            if (this->num_dirty_keys > MAX_DIRTY_KEYS) {
+                return true;
+            }
+            auto first = this->dirty_keys.begin();
+            auto last = first + this->num_dirty_keys;
+            return std::find(first, last, key) != last;
+        }
+
         /**
          * After waking there are some things to be done
          *
@@ -350,7 +591,7 @@ namespace concurrent_detail {
                   typename LockQueue, typename UnlockQueue, typename LockTag>
         void after_wake(Proxy& proxy, Waiter& waiter,
                         LockQueue lock_queue,  UnlockQueue unlock_queue,
-                        bool should_return, LockTag) {
+                        bool should_return, LockTag) const {
             if (std::is_same<LockTag, WriteLockTag>::value) {
                 // assert(proxy.is_leader);
                 return;
@@ -388,7 +629,11 @@ namespace concurrent_detail {
         }
 
         using WaiterNode = TransparentNode<Waiter<Condition, Mutex>>;
-        TransparentList<Waiter<Condition, Mutex>> waiters;
+        using WaiterList = TransparentList<Waiter<Condition, Mutex>>;
+        mutable WaiterList waiters;
+        mutable WaiterList keyed_waiters;
+        mutable std::array<std::size_t, MAX_DIRTY_KEYS> dirty_keys;
+        mutable std::size_t num_dirty_keys{0};
     };
 
     /**
@@ -403,23 +648,26 @@ namespace concurrent_detail {
             : public ConditionsImpl<Mutex, Cv, Condition> {
     public:
         template <typename LockProxy>
-        void notify(LockProxy& proxy, WriteLockTag) {
+        void notify(LockProxy& proxy, WriteLockTag) const {
             this->notify_impl(proxy, []{}, []{}, WriteLockTag{});
         }
 
-        template <typename C, typename LockProxy>
-        void wait(C&& condition, LockProxy& proxy, WriteLockTag) {
+        template <typename C, typename LockProxy,
+                  typename Deadline = NoDeadline>
+        bool wait(C&& condition, LockProxy& proxy, WriteLockTag,
+                  std::size_t key = NO_KEY,
+                  const Deadline& deadline = Deadline{}) const {
             auto& mtx = proxy.instance_ptr->mtx;
             if (!std::is_same<Mutex, std::mutex>::value) {
-                this->wait_impl(std::forward<C>(condition), proxy, mtx,
+                return this->wait_impl(std::forward<C>(condition), proxy, mtx,
                         [&] { mtx.lock(); }, [&] { mtx.unlock(); },
                         [&] {}, [&] {},
-                        WriteLockTag{});
+                        WriteLockTag{}, key, deadline);
             } else {
-                this->wait_impl(std::forward<C>(condition), proxy, mtx,
+                return this->wait_impl(std::forward<C>(condition), proxy, mtx,
                         [&] {}, [&] {},
                         [&] {}, [&] {},
-                        WriteLockTag{});
+                        WriteLockTag{}, key, deadline);
             }
         }
     };
@@ -441,20 +689,23 @@ namespace concurrent_detail {
             : public ConditionsLockWrap<Mutex, Cv, Condition, false> {
     public:
         template <typename LockProxy>
-        void notify(LockProxy& proxy, ReadLockTag) {
+        void notify(LockProxy& proxy, ReadLockTag) const {
             this->notify_impl(proxy, []{}, []{}, ReadLockTag{});
         }
 
-        template <typename C, typename LockProxy>
-        void wait(C&& condition, LockProxy& proxy, ReadLockTag) {
+        template <typename C, typename LockProxy,
+                  typename Deadline = NoDeadline>
+        bool wait(C&& condition, LockProxy& proxy, ReadLockTag,
+                  std::size_t key = NO_KEY,
+                  const Deadline& deadline = Deadline{}) const {
             auto& mtx = proxy.instance_ptr->mtx;
-            this->wait_impl(std::forward<C>(condition), proxy, mtx,
+            return this->wait_impl(std::forward<C>(condition), proxy, mtx,
                     [&] { mtx.lock_shared(); }, [&] { mtx.unlock_shared(); },
                     [&] { queue_mtx.lock(); }, [&] { queue_mtx.unlock(); },
-                    ReadLockTag{});
+                    ReadLockTag{}, key, deadline);
         }
     private:
-        Mutex queue_mtx;
+        mutable Mutex queue_mtx;
     };
 
     /**
@@ -474,6 +725,8 @@ namespace concurrent_detail {
     public:
         template <typename... Args>
         void notify(Args&&...) const {}
+        template <typename... Args>
+        void touch(Args&&...) const {}
         template <typename Cv = InvalidCv, typename... Args>
         void wait(Args&&...) const {
             // this static assert stops compilation at this point with a
@@ -490,5 +743,12 @@ namespace concurrent_detail {
         }
     };
 
+
+    /**
+     * Implements sharp::async_synchronized(), see
+     * sharp/Concurrent/AsyncSynchronized.hpp
+     */
+    class AsyncSynchronized;
+
 } // namespace concurrent_detail
 } // namespace sharp
@@ -0,0 +1,135 @@
+/**
+ * @file ShardedConcurrent.hpp
+ * @author Aaryaman Sagar
+ *
+ * A container of Concurrent objects split by key, so that threads working on
+ * different keys of a large map do not all serialize on the same mutex
+ */
+
+#pragma once
+
+#include <sharp/Concurrent/Concurrent.hpp>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace sharp {
+
+/**
+ * @class ShardedConcurrent
+ *
+ * Holds N independent Concurrent<Map> objects, the shards, and routes each
+ * key to one of them by hash.  Operations on keys that land in different
+ * shards run in parallel, and each shard sits on its own cache lines so that
+ * locking one shard does not invalidate the line a neighbouring shard's
+ * mutex is on
+ *
+ *      sharp::ShardedConcurrent<std::unordered_map<int, Session>, 64> store;
+ *
+ *      store.synchronized(id, [&](auto& sessions) {
+ *          sessions[id].touch();
+ *      });
+ *
+ *      auto lock = store.lock(id);
+ *      lock->erase(id);
+ *
+ * lock(key) and synchronized(key, func) give access to the whole shard the
+ * key belongs to, not just the key.  Only keys that belong to the shard
+ * should be used through it, otherwise later lookups by that key go to a
+ * different shard and miss it
+ *
+ * Operations that need to see all the keys at once, like taking a size or
+ * iterating, can lock all the shards with lock_all().  The shards are always
+ * locked in the same order there so two calls to lock_all() do not deadlock.
+ * A thread should not hold a lock on one shard while locking another one
+ * through lock(key), since that can deadlock with a concurrent lock_all()
+ *
+ * The constness of the object selects between read and write locks, same as
+ * Concurrent
+ */
+template <typename Map,
+          std::size_t N = 16,
+          typename Mutex = std::mutex,
+          typename Hash = std::hash<typename Map::key_type>>
+class ShardedConcurrent {
+public:
+
+    static_assert(N > 0, "sharp::ShardedConcurrent needs at least one shard");
+
+    using value_type = Map;
+    using key_type = typename Map::key_type;
+    using mutex_type = Mutex;
+
+    /**
+     * The number of shards
+     */
+    static constexpr std::size_t number_shards = N;
+
+    /**
+     * Default constructs all the shards
+     */
+    ShardedConcurrent() = default;
+
+    /**
+     * The shards cannot be copied or moved as one, the locks of the shards
+     * would have to be held all at once for that to be meaningful
+     */
+    ShardedConcurrent(const ShardedConcurrent&) = delete;
+    ShardedConcurrent(ShardedConcurrent&&) = delete;
+    ShardedConcurrent& operator=(const ShardedConcurrent&) = delete;
+    ShardedConcurrent& operator=(ShardedConcurrent&&) = delete;
+
+    /**
+     * Returns a lock proxy for the shard that the key belongs to, see
+     * Concurrent::lock()
+     */
+    auto /* LockProxy<> */ lock(const key_type& key);
+    auto /* LockProxy<> */ lock(const key_type& key) const;
+
+    /**
+     * Runs the function on the shard that the key belongs to with the shard
+     * locked, see Concurrent::synchronized()
+     */
+    template <typename Func>
+    decltype(auto) synchronized(const key_type& key, Func&& func);
+    template <typename Func>
+    decltype(auto) synchronized(const key_type& key, Func&& func) const;
+
+    /**
+     * Locks all the shards in index order and returns a std::array of the
+     * lock proxies, indexed by shard
+     *
+     *      auto size = std::size_t{0};
+     *      for (auto& shard : sharp::as_const(store).lock_all()) {
+     *          size += shard->size();
+     *      }
+     */
+    auto /* std::array<LockProxy<>, N> */ lock_all();
+    auto /* std::array<LockProxy<>, N> */ lock_all() const;
+
+    /**
+     * Returns the index of the shard the key belongs to
+     */
+    std::size_t shard(const key_type& key) const;
+
+private:
+
+    template <typename Self, std::size_t... Indices>
+    static auto lock_all(Self& self, std::index_sequence<Indices...>);
+
+    /**
+     * Each shard starts on a cache line of its own
+     */
+    struct alignas(64) Shard {
+        sharp::Concurrent<Map, Mutex> map;
+    };
+
+    std::array<Shard, N> shards;
+};
+
+} // namespace sharp
+
+#include <sharp/Concurrent/ShardedConcurrent.ipp>
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <sharp/Concurrent/ShardedConcurrent.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace sharp {
+
+template <typename Map, std::size_t N, typename Mutex, typename Hash>
+constexpr std::size_t ShardedConcurrent<Map, N, Mutex, Hash>::number_shards;
+
+template <typename Map, std::size_t N, typename Mutex, typename Hash>
+auto ShardedConcurrent<Map, N, Mutex, Hash>::lock(const key_type& key) {
+    return this->shards[this->shard(key)].map.lock();
+}
+
+template <typename Map, std::size_t N, typename Mutex, typename Hash>
+auto ShardedConcurrent<Map, N, Mutex, Hash>::lock(const key_type& key) const {
+    return this->shards[this->shard(key)].map.lock();
+}
+
+template <typename Map, std::size_t N, typename Mutex, typename Hash>
+template <typename Func>
+decltype(auto) ShardedConcurrent<Map, N, Mutex, Hash>::synchronized(
+        const key_type& key, Func&& func) {
+    return this->shards[this->shard(key)].map.synchronized(
+        std::forward<Func>(func));
+}
+
+template <typename Map, std::size_t N, typename Mutex, typename Hash>
+template <typename Func>
+decltype(auto) ShardedConcurrent<Map, N, Mutex, Hash>::synchronized(
+        const key_type& key, Func&& func) const {
+    return this->shards[this->shard(key)].map.synchronized(
+        std::forward<Func>(func));
+}
+
+template <typename Map, std::size_t N, typename Mutex, typename Hash>
+auto ShardedConcurrent<Map, N, Mutex, Hash>::lock_all() {
+    return lock_all(*this, std::make_index_sequence<N>{});
+}
+
+template <typename Map, std::size_t N, typename Mutex, typename Hash>
+auto ShardedConcurrent<Map, N, Mutex, Hash>::lock_all() const {
+    return lock_all(*this, std::make_index_sequence<N>{});
+}
+
+template <typename Map, std::size_t N, typename Mutex, typename Hash>
+template <typename Self, std::size_t... Indices>
+auto ShardedConcurrent<Map, N, Mutex, Hash>::lock_all(
+        Self& self, std::index_sequence<Indices...>) {
+    // the elements of a braced initializer list are evaluated in order, so
+    // the shards are locked in index order
+    using Proxy = decltype(self.shards[0].map.lock());
+    return std::array<Proxy, N>{{self.shards[Indices].map.lock()...}};
+}
+
+template <typename Map, std::size_t N, typename Mutex, typename Hash>
+std::size_t ShardedConcurrent<Map, N, Mutex, Hash>::shard(
+        const key_type& key) const {
+    // std::hash is the identity for integers, so mix the bits before picking
+    // a shard, otherwise keys with a common stride all land in a few shards
+    auto hash = static_cast<std::uint64_t>(Hash{}(key));
+    hash *= UINT64_C(0x9e3779b97f4a7c15);
+    return static_cast<std::size_t>((hash >> 32) % N);
+}
+
+} // namespace sharp
@@ -0,0 +1,183 @@
+/**
+ * @file CombiningConcurrent.hpp
+ * @author Aaryaman Sagar
+ *
+ * A specialization of Concurrent that uses flat combining for synchronized()
+ * to keep heavily contended data in the cache of one core.  Selected by
+ * passing sharp::Combining in place of the mutex
+ *
+ *      sharp::Concurrent<std::priority_queue<Task>, sharp::Combining> tasks;
+ */
+
+#pragma once
+
+#include <sharp/Concurrent/Concurrent.hpp>
+#include <sharp/Portability/cpp17.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <initializer_list>
+#include <mutex>
+#include <type_traits>
+
+namespace sharp {
+
+namespace concurrent_detail {
+
+    /**
+     * The number of slots closures can be published to, threads that find
+     * every slot taken lock the mutex and run their closure themselves
+     */
+    constexpr auto COMBINING_SLOTS = std::size_t{64};
+
+    /**
+     * Returns the slot the calling thread tries first, assigned round robin
+     * the first time a thread asks for one
+     */
+    inline std::size_t combining_slot();
+
+} // namespace concurrent_detail
+
+/**
+ * @class Concurrent<Type, Combining, Cv>
+ *
+ * With a plain mutex every synchronized() call under contention moves the
+ * lock and the data to the cache of the next thread in line.  Here a thread
+ * calling synchronized() instead publishes its closure in a slot and tries
+ * to lock the mutex.  The thread that gets the lock becomes the combiner, it
+ * runs the closures in all the slots that have one, hands the results back
+ * through the slots and unlocks.  The other threads spin on their own slot
+ * till the result shows up, or till the lock is free in which case they
+ * become the combiner.  So under contention a batch of closures runs back to
+ * back on one core with the data staying in its cache, and the only shared
+ * lines that move are the slots
+ *
+ * Closures run on whichever thread is the combiner, so they should not
+ * depend on which thread they run on, and should be short.  Exceptions
+ * thrown from a closure are propagated to the thread that published it.
+ * Return values are returned by value
+ *
+ * lock() is still available and behaves like a plain mutex, closures that
+ * are published while a lock proxy is held are run after it is unlocked.
+ * Both overloads take the mutex exclusively, and conditional waits are not
+ * supported
+ */
+template <typename Type, typename Cv>
+class Concurrent<Type, Combining, Cv> {
+public:
+
+    using value_type = Type;
+    using mutex_type = Combining;
+
+private:
+    /**
+     * @class LockProxy
+     *
+     * Holds the mutex, the data is const if the Concurrent object is const
+     */
+    template <typename ConcurrentType>
+    class LockProxy {
+    public:
+
+        using value_type = std::conditional_t<
+            std::is_const<ConcurrentType>::value, const Type, Type>;
+
+        LockProxy(LockProxy&&) noexcept;
+        ~LockProxy();
+
+        void unlock() noexcept;
+
+        value_type* operator->() const;
+        value_type& operator*() const;
+
+        friend class Concurrent;
+    private:
+        explicit LockProxy(ConcurrentType&);
+
+        LockProxy(const LockProxy&) = delete;
+        LockProxy& operator=(const LockProxy&) = delete;
+        LockProxy& operator=(LockProxy&&) = delete;
+
+        ConcurrentType* instance_ptr{nullptr};
+    };
+
+public:
+
+    /**
+     * Runs the closure on the data, possibly on another thread that is
+     * combining, and returns its result.  The const version gives the
+     * closure a const reference to the data
+     */
+    template <typename F>
+    decltype(auto) synchronized(F&&);
+    template <typename F>
+    decltype(auto) synchronized(F&&) const;
+
+    /**
+     * Lock proxies that bypass combining, see the general Concurrent
+     */
+    auto /* LockProxy<> */ lock();
+    auto /* LockProxy<> */ lock() const;
+
+    /**
+     * Constructors, these mirror the general Concurrent
+     */
+    Concurrent() = default;
+    Concurrent(const Concurrent& other);
+    explicit Concurrent(const Type& instance);
+    explicit Concurrent(Type&& instance);
+    template <typename... Args>
+    Concurrent(std::in_place_t, Args&&... args);
+    template <typename U, typename... Args>
+    Concurrent(std::in_place_t, std::initializer_list<U> il, Args&&... args);
+
+private:
+
+    /**
+     * The states a slot goes through, a thread claims a free slot, fills it
+     * in and marks it pending.  The combiner runs a pending closure and
+     * marks the slot done, after which the publishing thread reads the
+     * result out and frees the slot
+     */
+    enum class SlotState : std::uint32_t {FREE, CLAIMED, PENDING, DONE};
+
+    /**
+     * A published closure, the closure and its result live on the stack of
+     * the publishing thread and run() is type erased so the slots do not
+     * have to allocate
+     */
+    struct alignas(64) Slot {
+        std::atomic<SlotState> state{SlotState::FREE};
+        void (*run)(void* closure, Type& datum){nullptr};
+        void* closure{nullptr};
+    };
+
+    /**
+     * The closure and space for its result, see the .ipp file
+     */
+    template <typename Func, typename Result>
+    class Closure;
+
+    /**
+     * Publishes the closure and waits for it to be run, either by this
+     * thread or by another thread that is combining
+     */
+    template <typename Func>
+    decltype(auto) combine(Func&& func);
+
+    /**
+     * Runs all the closures that are pending, must be called with the mutex
+     * held
+     */
+    void run_pending();
+
+    Type datum;
+    mutable std::mutex mtx;
+    mutable Slot slots[concurrent_detail::COMBINING_SLOTS];
+};
+
+} // namespace sharp
+
+#include <sharp/Concurrent/detail/CombiningConcurrent.ipp>
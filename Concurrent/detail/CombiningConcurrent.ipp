@@ -0,0 +1,239 @@
+#include <sharp/Concurrent/detail/CombiningConcurrent.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace sharp {
+
+namespace concurrent_detail {
+
+    /**
+     * The number of times a thread waiting for its closure to run checks its
+     * slot between attempts at becoming the combiner
+     */
+    constexpr auto COMBINING_POLL_COUNT = 16;
+
+    inline std::size_t combining_slot() {
+        static std::atomic<std::size_t> next{0};
+        thread_local auto slot
+            = next.fetch_add(1, std::memory_order_relaxed) % COMBINING_SLOTS;
+        return slot;
+    }
+
+} // namespace concurrent_detail
+
+/**
+ * A published closure along with space for its result or the exception it
+ * threw.  The combiner calls run() through the slot, and the publishing
+ * thread calls get() once the slot is marked done
+ */
+template <typename Type, typename Cv>
+template <typename Func, typename Result>
+class Concurrent<Type, Combining, Cv>::Closure {
+public:
+    explicit Closure(Func& func) : func{func} {}
+
+    static void run(void* closure, Type& datum) {
+        auto& self = *static_cast<Closure*>(closure);
+        try {
+            self.run_impl(datum, std::is_void<Result>{});
+        } catch (...) {
+            self.exception = std::current_exception();
+        }
+    }
+
+    Result get() {
+        if (this->exception) {
+            std::rethrow_exception(this->exception);
+        }
+        return this->get_impl(std::is_void<Result>{});
+    }
+
+private:
+    void run_impl(Type& datum, std::false_type) {
+        this->result.emplace(std::forward<Func>(this->func)(datum));
+    }
+    void run_impl(Type& datum, std::true_type) {
+        std::forward<Func>(this->func)(datum);
+    }
+    Result get_impl(std::false_type) {
+        return std::move(*this->result);
+    }
+    void get_impl(std::true_type) {}
+
+    Func& func;
+    std::optional<std::conditional_t<
+        std::is_void<Result>::value, std::nullptr_t, Result>> result;
+    std::exception_ptr exception;
+};
+
+/**
+ * Implementations for the lock proxy
+ */
+template <typename Type, typename Cv>
+template <typename C>
+Concurrent<Type, Combining, Cv>::LockProxy<C>::LockProxy(C& instance)
+        : instance_ptr{&instance} {
+    instance.mtx.lock();
+}
+
+template <typename Type, typename Cv>
+template <typename C>
+Concurrent<Type, Combining, Cv>::LockProxy<C>::LockProxy(
+        LockProxy&& other) noexcept : instance_ptr{other.instance_ptr} {
+    other.instance_ptr = nullptr;
+}
+
+template <typename Type, typename Cv>
+template <typename C>
+Concurrent<Type, Combining, Cv>::LockProxy<C>::~LockProxy() {
+    this->unlock();
+}
+
+template <typename Type, typename Cv>
+template <typename C>
+void Concurrent<Type, Combining, Cv>::LockProxy<C>::unlock() noexcept {
+    if (this->instance_ptr) {
+        this->instance_ptr->mtx.unlock();
+        this->instance_ptr = nullptr;
+    }
+}
+
+template <typename Type, typename Cv>
+template <typename C>
+auto Concurrent<Type, Combining, Cv>::LockProxy<C>::operator->() const
+        -> value_type* {
+    return &this->instance_ptr->datum;
+}
+
+template <typename Type, typename Cv>
+template <typename C>
+auto Concurrent<Type, Combining, Cv>::LockProxy<C>::operator*() const
+        -> value_type& {
+    return this->instance_ptr->datum;
+}
+
+/**
+ * Implementations for the Concurrent<Type, Combining> methods
+ */
+template <typename Type, typename Cv>
+template <typename Func>
+decltype(auto) Concurrent<Type, Combining, Cv>::synchronized(Func&& func) {
+    return this->combine(std::forward<Func>(func));
+}
+
+template <typename Type, typename Cv>
+template <typename Func>
+decltype(auto) Concurrent<Type, Combining, Cv>::synchronized(
+        Func&& func) const {
+    // the combiner holds a non const reference to the data, make sure the
+    // closure only sees a const one
+    auto& self = const_cast<Concurrent&>(*this);
+    return self.combine([&func](Type& datum) {
+        return std::forward<Func>(func)(static_cast<const Type&>(datum));
+    });
+}
+
+template <typename Type, typename Cv>
+auto Concurrent<Type, Combining, Cv>::lock() {
+    return LockProxy<Concurrent>{*this};
+}
+
+template <typename Type, typename Cv>
+auto Concurrent<Type, Combining, Cv>::lock() const {
+    return LockProxy<const Concurrent>{*this};
+}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Combining, Cv>::Concurrent(const Concurrent& other)
+    : Concurrent{*other.lock()} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Combining, Cv>::Concurrent(const Type& instance)
+    : datum{instance} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Combining, Cv>::Concurrent(Type&& instance)
+    : datum{std::move(instance)} {}
+
+template <typename Type, typename Cv>
+template <typename... Args>
+Concurrent<Type, Combining, Cv>::Concurrent(std::in_place_t, Args&&... args)
+    : datum{std::forward<Args>(args)...} {}
+
+template <typename Type, typename Cv>
+template <typename U, typename... Args>
+Concurrent<Type, Combining, Cv>::Concurrent(
+        std::in_place_t, std::initializer_list<U> il, Args&&... args)
+    : datum{il, std::forward<Args>(args)...} {}
+
+template <typename Type, typename Cv>
+template <typename Func>
+decltype(auto) Concurrent<Type, Combining, Cv>::combine(Func&& func) {
+    using Result = std::decay_t<decltype(std::forward<Func>(func)(
+        std::declval<Type&>()))>;
+    Closure<Func, Result> closure{func};
+
+    // claim a slot, starting at the one assigned to this thread so threads
+    // mostly stick to their own slot
+    auto start = concurrent_detail::combining_slot();
+    auto slot = static_cast<Slot*>(nullptr);
+    for (auto i = std::size_t{0}; i < concurrent_detail::COMBINING_SLOTS; ++i) {
+        auto& candidate
+            = this->slots[(start + i) % concurrent_detail::COMBINING_SLOTS];
+        auto expected = SlotState::FREE;
+        if (candidate.state.load(std::memory_order_relaxed) == SlotState::FREE
+                && candidate.state.compare_exchange_strong(
+                    expected, SlotState::CLAIMED, std::memory_order_acquire)) {
+            slot = &candidate;
+            break;
+        }
+    }
+
+    // with no free slot just run the closure directly
+    if (!slot) {
+        std::lock_guard<std::mutex> lck{this->mtx};
+        Closure<Func, Result>::run(&closure, this->datum);
+        return closure.get();
+    }
+
+    slot->run = &Closure<Func, Result>::run;
+    slot->closure = &closure;
+    slot->state.store(SlotState::PENDING, std::memory_order_release);
+
+    // wait for a combiner to get to the slot, and try to become the combiner
+    // every once in a while, the release when a combiner marks the slot done
+    // makes the result visible here
+    for (auto i = 0;
+            slot->state.load(std::memory_order_acquire) != SlotState::DONE;
+            ++i) {
+        if (!(i % concurrent_detail::COMBINING_POLL_COUNT)
+                && this->mtx.try_lock()) {
+            this->run_pending();
+            this->mtx.unlock();
+        } else if (i >= concurrent_detail::COMBINING_POLL_COUNT) {
+            std::this_thread::yield();
+        }
+    }
+
+    slot->state.store(SlotState::FREE, std::memory_order_release);
+    return closure.get();
+}
+
+template <typename Type, typename Cv>
+void Concurrent<Type, Combining, Cv>::run_pending() {
+    for (auto& slot : this->slots) {
+        if (slot.state.load(std::memory_order_acquire) == SlotState::PENDING) {
+            slot.run(slot.closure, this->datum);
+            slot.state.store(SlotState::DONE, std::memory_order_release);
+        }
+    }
+}
+
+} // namespace sharp
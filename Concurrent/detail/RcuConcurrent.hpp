@@ -0,0 +1,228 @@
+/**
+ * @file RcuConcurrent.hpp
+ * @author Aaryaman Sagar
+ *
+ * A specialization of Concurrent for read mostly data, readers do not take a
+ * lock at all and instead get a snapshot of the data that stays valid for as
+ * long as they hold on to it.  Selected by passing sharp::Rcu in place of the
+ * mutex
+ *
+ *      sharp::Concurrent<Config, sharp::Rcu> config;
+ */
+
+#pragma once
+
+#include <sharp/Concurrent/Concurrent.hpp>
+#include <sharp/Portability/cpp17.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace sharp {
+
+namespace concurrent_detail {
+
+    /**
+     * The number of reader counters in an Rcu concurrent object, threads are
+     * spread over these so that readers on different cores do not keep
+     * bouncing the same cache line between each other
+     */
+    constexpr auto RCU_STRIPES = std::size_t{16};
+
+    /**
+     * Returns the counter stripe for the calling thread, assigned round
+     * robin the first time a thread asks for one
+     */
+    inline std::size_t rcu_stripe();
+
+} // namespace concurrent_detail
+
+/**
+ * @class Concurrent<Type, Rcu, Cv>
+ *
+ * Readers and writers here never block each other.  The current version of
+ * the data object lives on the heap behind an atomic pointer.  A read lock
+ * registers the reader in the current epoch and loads the pointer, the read
+ * proxy then points to that version till it is unlocked.  A write lock takes
+ * a mutex that serializes writers and makes a private copy of the current
+ * version, the write proxy points to the copy and on unlock the copy is
+ * published with a single store
+ *
+ * The version that was replaced is retired once every reader that could
+ * have seen it has unlocked.  A writer ends the current epoch right after
+ * publishing and waits for the reader count of the old epoch to drain, this
+ * is the grace period.  Readers that start after the new version is
+ * published register in the new epoch and are never waited on.  The reader
+ * counts are split over a few cache lines, so locking and unlocking for a
+ * read is an increment and a decrement on a line that is usually not shared
+ * with other cores and a couple of loads.  There are no compare and swap
+ * loops and no writes to anything a writer touches
+ *
+ * So this trades slower writes, a copy and a grace period each, for reads
+ * that scale with the number of cores.  Use it for things like configs or
+ * routing tables that are read all the time and changed once in a while
+ *
+ * The lock() and synchronized() interface is the same as the general
+ * Concurrent, and the const overloads are still the read only ones.  Two
+ * things differ
+ *
+ *  - A reader sees the version that was current when it locked, writes
+ *    published after that are not visible through the same proxy.  And a
+ *    write is only visible to readers after the write proxy is unlocked
+ *  - Waiting on conditions is not supported, there is nothing to sleep on.
+ *    And a thread that holds a read proxy must not unlock a write proxy on
+ *    the same object, the grace period would wait for the thread itself
+ *
+ * The type has to be copy constructible since every write makes a copy
+ */
+template <typename Type, typename Cv>
+class Concurrent<Type, Rcu, Cv> {
+public:
+
+    using value_type = Type;
+    using mutex_type = Rcu;
+
+private:
+    /**
+     * @class ReadProxy
+     *
+     * Holds a registration in an epoch and a pointer to the version that was
+     * current at the time of locking.  The version is not retired till the
+     * proxy is unlocked
+     */
+    class ReadProxy {
+    public:
+        ReadProxy(ReadProxy&&) noexcept;
+        ~ReadProxy();
+
+        void unlock() noexcept;
+
+        const Type* operator->() const;
+        const Type& operator*() const;
+
+        friend class Concurrent;
+    private:
+        explicit ReadProxy(const Concurrent&);
+
+        ReadProxy(const ReadProxy&) = delete;
+        ReadProxy& operator=(const ReadProxy&) = delete;
+        ReadProxy& operator=(ReadProxy&&) = delete;
+
+        /**
+         * The reader counter this proxy is registered with, and the snapshot
+         * it points to
+         */
+        std::atomic<std::uint64_t>* counter{nullptr};
+        const Type* snapshot{nullptr};
+    };
+
+    /**
+     * @class WriteProxy
+     *
+     * Holds the writer mutex and a private copy of the data object, the copy
+     * is published on unlock
+     */
+    class WriteProxy {
+    public:
+        WriteProxy(WriteProxy&&) noexcept;
+        ~WriteProxy();
+
+        void unlock() noexcept;
+
+        Type* operator->() const;
+        Type& operator*() const;
+
+        friend class Concurrent;
+    private:
+        explicit WriteProxy(Concurrent&);
+
+        WriteProxy(const WriteProxy&) = delete;
+        WriteProxy& operator=(const WriteProxy&) = delete;
+        WriteProxy& operator=(WriteProxy&&) = delete;
+
+        Concurrent* instance_ptr{nullptr};
+        std::unique_ptr<Type> copy;
+    };
+
+public:
+
+    /**
+     * Same as the general Concurrent, the const versions hand out read
+     * proxies and the non const versions hand out write proxies
+     */
+    template <typename F>
+    decltype(auto) synchronized(F&&);
+    template <typename F>
+    decltype(auto) synchronized(F&&) const;
+    auto /* WriteProxy */ lock();
+    auto /* ReadProxy */ lock() const;
+
+    /**
+     * Constructors, these mirror the general Concurrent.  Copying and moving
+     * make a copy of the current version of the other object
+     */
+    Concurrent();
+    Concurrent(const Concurrent& other);
+    Concurrent(Concurrent&& other);
+    explicit Concurrent(const Type& instance);
+    explicit Concurrent(Type&& instance);
+    template <typename... Args>
+    Concurrent(std::in_place_t, Args&&... args);
+    template <typename U, typename... Args>
+    Concurrent(std::in_place_t, std::initializer_list<U> il, Args&&... args);
+
+    /**
+     * Assignment publishes a copy of the other object's current version,
+     * like a write
+     */
+    Concurrent& operator=(const Concurrent& other);
+    Concurrent& operator=(Concurrent&& other);
+
+    /**
+     * Destroys the current version, no proxies can be alive at this point
+     */
+    ~Concurrent();
+
+private:
+
+    /**
+     * A reader counter for each epoch, each stripe is on its own cache line
+     */
+    struct alignas(64) Stripe {
+        std::atomic<std::uint64_t> readers[2]{};
+    };
+
+    /**
+     * Register the calling thread as a reader in the current epoch, and
+     * return the counter it was registered with
+     */
+    std::atomic<std::uint64_t>& enter() const;
+
+    /**
+     * Swap in a new version and retire the old one after a grace period,
+     * must be called with the writer mutex held
+     */
+    void publish(std::unique_ptr<Type> version);
+
+    /**
+     * The current version, the epoch readers register in (only the low bit
+     * matters) and the reader counters
+     */
+    std::atomic<Type*> current;
+    mutable std::atomic<std::uint64_t> epoch{0};
+    mutable Stripe stripes[concurrent_detail::RCU_STRIPES];
+
+    /**
+     * Serializes writers
+     */
+    std::mutex writer;
+};
+
+} // namespace sharp
+
+#include <sharp/Concurrent/detail/RcuConcurrent.ipp>
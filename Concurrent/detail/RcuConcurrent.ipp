@@ -0,0 +1,224 @@
+#include <sharp/Concurrent/detail/RcuConcurrent.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace sharp {
+
+namespace concurrent_detail {
+
+    inline std::size_t rcu_stripe() {
+        static std::atomic<std::size_t> next{0};
+        thread_local auto stripe
+            = next.fetch_add(1, std::memory_order_relaxed) % RCU_STRIPES;
+        return stripe;
+    }
+
+} // namespace concurrent_detail
+
+/**
+ * Implementations for the read proxy
+ */
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::ReadProxy::ReadProxy(const Concurrent& instance)
+    : counter{&instance.enter()},
+      snapshot{instance.current.load(std::memory_order_acquire)} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::ReadProxy::ReadProxy(ReadProxy&& other) noexcept
+        : counter{other.counter}, snapshot{other.snapshot} {
+    other.counter = nullptr;
+    other.snapshot = nullptr;
+}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::ReadProxy::~ReadProxy() {
+    this->unlock();
+}
+
+template <typename Type, typename Cv>
+void Concurrent<Type, Rcu, Cv>::ReadProxy::unlock() noexcept {
+    // the release here orders all the reads of the snapshot before a writer
+    // that sees the count drop to zero and destroys the snapshot
+    if (this->counter) {
+        this->counter->fetch_sub(1, std::memory_order_release);
+        this->counter = nullptr;
+        this->snapshot = nullptr;
+    }
+}
+
+template <typename Type, typename Cv>
+const Type* Concurrent<Type, Rcu, Cv>::ReadProxy::operator->() const {
+    return this->snapshot;
+}
+
+template <typename Type, typename Cv>
+const Type& Concurrent<Type, Rcu, Cv>::ReadProxy::operator*() const {
+    return *this->snapshot;
+}
+
+/**
+ * Implementations for the write proxy
+ */
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::WriteProxy::WriteProxy(Concurrent& instance)
+        : instance_ptr{&instance} {
+    // the mutex should not stay locked if the copy throws
+    auto lock = std::unique_lock<std::mutex>{instance.writer};
+    this->copy = std::make_unique<Type>(
+        *instance.current.load(std::memory_order_relaxed));
+    lock.release();
+}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::WriteProxy::WriteProxy(WriteProxy&& other) noexcept
+        : instance_ptr{other.instance_ptr}, copy{std::move(other.copy)} {
+    other.instance_ptr = nullptr;
+}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::WriteProxy::~WriteProxy() {
+    this->unlock();
+}
+
+template <typename Type, typename Cv>
+void Concurrent<Type, Rcu, Cv>::WriteProxy::unlock() noexcept {
+    if (this->instance_ptr) {
+        this->instance_ptr->publish(std::move(this->copy));
+        this->instance_ptr->writer.unlock();
+        this->instance_ptr = nullptr;
+    }
+}
+
+template <typename Type, typename Cv>
+Type* Concurrent<Type, Rcu, Cv>::WriteProxy::operator->() const {
+    return this->copy.get();
+}
+
+template <typename Type, typename Cv>
+Type& Concurrent<Type, Rcu, Cv>::WriteProxy::operator*() const {
+    return *this->copy;
+}
+
+/**
+ * Implementations for the Concurrent<Type, Rcu> methods
+ */
+template <typename Type, typename Cv>
+template <typename Func>
+decltype(auto) Concurrent<Type, Rcu, Cv>::synchronized(Func&& func) {
+    auto lock = this->lock();
+    return std::forward<Func>(func)(*lock);
+}
+
+template <typename Type, typename Cv>
+template <typename Func>
+decltype(auto) Concurrent<Type, Rcu, Cv>::synchronized(Func&& func) const {
+    auto lock = this->lock();
+    return std::forward<Func>(func)(*lock);
+}
+
+template <typename Type, typename Cv>
+auto Concurrent<Type, Rcu, Cv>::lock() {
+    return WriteProxy{*this};
+}
+
+template <typename Type, typename Cv>
+auto Concurrent<Type, Rcu, Cv>::lock() const {
+    return ReadProxy{*this};
+}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::Concurrent() : current{new Type{}} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::Concurrent(const Concurrent& other)
+    : Concurrent{*other.lock()} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::Concurrent(Concurrent&& other)
+    : Concurrent{static_cast<const Concurrent&>(other)} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::Concurrent(const Type& instance)
+    : current{new Type{instance}} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::Concurrent(Type&& instance)
+    : current{new Type{std::move(instance)}} {}
+
+template <typename Type, typename Cv>
+template <typename... Args>
+Concurrent<Type, Rcu, Cv>::Concurrent(std::in_place_t, Args&&... args)
+    : current{new Type{std::forward<Args>(args)...}} {}
+
+template <typename Type, typename Cv>
+template <typename U, typename... Args>
+Concurrent<Type, Rcu, Cv>::Concurrent(
+        std::in_place_t, std::initializer_list<U> il, Args&&... args)
+    : current{new Type{il, std::forward<Args>(args)...}} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>& Concurrent<Type, Rcu, Cv>::operator=(
+        const Concurrent& other) {
+    // the read on the other object has to be over before publishing, on a
+    // self assignment the grace period would otherwise wait for ourselves
+    auto version = other.synchronized([](auto& instance) {
+        return std::make_unique<Type>(instance);
+    });
+
+    std::lock_guard<std::mutex> lock{this->writer};
+    this->publish(std::move(version));
+    return *this;
+}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>& Concurrent<Type, Rcu, Cv>::operator=(
+        Concurrent&& other) {
+    return this->operator=(static_cast<const Concurrent&>(other));
+}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Rcu, Cv>::~Concurrent() {
+    delete this->current.load(std::memory_order_relaxed);
+}
+
+template <typename Type, typename Cv>
+std::atomic<std::uint64_t>& Concurrent<Type, Rcu, Cv>::enter() const {
+    auto& stripe = this->stripes[concurrent_detail::rcu_stripe()];
+    while (true) {
+        auto index = this->epoch.load(std::memory_order_relaxed) & 1;
+        auto& counter = stripe.readers[index];
+        counter.fetch_add(1);
+
+        // a writer might have ended the epoch between the load and the
+        // increment and not seen the increment.  Either the recheck here sees
+        // the new epoch, or the writer sees the increment and waits for us
+        if ((this->epoch.load() & 1) == index) {
+            return counter;
+        }
+        counter.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+template <typename Type, typename Cv>
+void Concurrent<Type, Rcu, Cv>::publish(std::unique_ptr<Type> version) {
+    // readers that see the new epoch also see the new version, so only the
+    // readers registered in the old epoch could be holding the old version
+    auto old = std::unique_ptr<Type>{this->current.exchange(
+        version.release(), std::memory_order_acq_rel)};
+    auto index = this->epoch.fetch_add(1) & 1;
+
+    for (auto& stripe : this->stripes) {
+        while (stripe.readers[index].load()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // namespace sharp
@@ -0,0 +1,175 @@
+/**
+ * @file SeqlockConcurrent.hpp
+ * @author Aaryaman Sagar
+ *
+ * A specialization of Concurrent for small trivially copyable values, readers
+ * never write to shared memory.  Selected by passing sharp::Seqlock in place
+ * of the mutex
+ *
+ *      sharp::Concurrent<Stats, sharp::Seqlock> stats;
+ */
+
+#pragma once
+
+#include <sharp/Concurrent/Concurrent.hpp>
+#include <sharp/Portability/cpp17.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <type_traits>
+
+namespace sharp {
+
+/**
+ * @class Concurrent<Type, Seqlock, Cv>
+ *
+ * The value is guarded by a sequence counter that is odd while a write is
+ * in progress and even otherwise.  A reader loads the counter, copies the
+ * value out and loads the counter again, if the two loads differ or the
+ * first was odd a write overlapped the copy and the reader tries again.
+ * Readers therefore never write to anything shared and any number of them
+ * can run on different cores without the cache line ping ponging between
+ * them, which a mutex or a reader writer lock cannot offer
+ *
+ * Writers are serialized by a mutex.  A write lock copies the value out and
+ * hands the copy to the writer, and the unlock copies it back in between two
+ * increments of the counter.  So readers only have to retry while a value is
+ * being copied in, not for the whole time a writer holds the lock
+ *
+ * The value is stored as an array of atomic words and copied in and out with
+ * relaxed atomic loads and stores, this keeps the racing copies in a reader
+ * well defined
+ *
+ * The lock() and synchronized() interface is the same as the general
+ * Concurrent and the const overloads are the read only ones.  Read proxies
+ * hold a copy of the value, so they never block writers, and conditional
+ * waits are not supported.  Keep the type small, every read copies all of it
+ */
+template <typename Type, typename Cv>
+class Concurrent<Type, Seqlock, Cv> {
+public:
+
+    static_assert(std::is_trivially_copyable<Type>::value,
+            "sharp::Seqlock can only be used with trivially copyable types");
+
+    using value_type = Type;
+    using mutex_type = Seqlock;
+
+private:
+    /**
+     * @class ReadProxy
+     *
+     * A consistent copy of the value as of the time of locking
+     */
+    class ReadProxy {
+    public:
+        ReadProxy(ReadProxy&&) = default;
+
+        /**
+         * Nothing is held, this is here so code written against the other
+         * proxies works unchanged
+         */
+        void unlock() noexcept {}
+
+        const Type* operator->() const;
+        const Type& operator*() const;
+
+        friend class Concurrent;
+    private:
+        explicit ReadProxy(const Concurrent&);
+
+        ReadProxy(const ReadProxy&) = delete;
+        ReadProxy& operator=(const ReadProxy&) = delete;
+        ReadProxy& operator=(ReadProxy&&) = delete;
+
+        Type snapshot;
+    };
+
+    /**
+     * @class WriteProxy
+     *
+     * Holds the writer mutex and a copy of the value, the copy is written
+     * back on unlock
+     */
+    class WriteProxy {
+    public:
+        WriteProxy(WriteProxy&&) noexcept;
+        ~WriteProxy();
+
+        void unlock() noexcept;
+
+        Type* operator->();
+        Type& operator*();
+
+        friend class Concurrent;
+    private:
+        explicit WriteProxy(Concurrent&);
+
+        WriteProxy(const WriteProxy&) = delete;
+        WriteProxy& operator=(const WriteProxy&) = delete;
+        WriteProxy& operator=(WriteProxy&&) = delete;
+
+        Concurrent* instance_ptr{nullptr};
+        Type copy;
+    };
+
+public:
+
+    /**
+     * Same as the general Concurrent, the const versions hand out read
+     * proxies and the non const versions hand out write proxies
+     */
+    template <typename F>
+    decltype(auto) synchronized(F&&);
+    template <typename F>
+    decltype(auto) synchronized(F&&) const;
+    auto /* WriteProxy */ lock();
+    auto /* ReadProxy */ lock() const;
+
+    /**
+     * Constructors and assignment, these mirror the general Concurrent
+     */
+    Concurrent();
+    Concurrent(const Concurrent& other);
+    explicit Concurrent(const Type& instance);
+    template <typename... Args>
+    Concurrent(std::in_place_t, Args&&... args);
+    template <typename U, typename... Args>
+    Concurrent(std::in_place_t, std::initializer_list<U> il, Args&&... args);
+    Concurrent& operator=(const Concurrent& other);
+
+private:
+
+    static constexpr auto WORDS
+        = (sizeof(Type) + sizeof(std::uintptr_t) - 1) / sizeof(std::uintptr_t);
+
+    /**
+     * Copy the value out of and into the atomic words, these do not touch
+     * the sequence counter
+     */
+    Type load() const;
+    void store(const Type& instance);
+
+    /**
+     * Read a consistent copy of the value, and write a value under the
+     * writer mutex bumping the sequence counter around the write
+     */
+    Type read() const;
+    void write(const Type& instance);
+
+    /**
+     * The sequence counter and the value share a cache line when the value
+     * is small enough, the writer mutex is kept off it so contending
+     * writers do not disturb readers
+     */
+    alignas(64) std::atomic<std::uint64_t> sequence{0};
+    std::atomic<std::uintptr_t> words[WORDS];
+    alignas(64) std::mutex writer;
+};
+
+} // namespace sharp
+
+#include <sharp/Concurrent/detail/SeqlockConcurrent.ipp>
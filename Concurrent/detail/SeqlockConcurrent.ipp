@@ -0,0 +1,199 @@
+#include <sharp/Concurrent/detail/SeqlockConcurrent.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace sharp {
+
+namespace concurrent_detail {
+
+    /**
+     * The number of times a reader retries before yielding to let the
+     * writer finish
+     */
+    constexpr auto SEQLOCK_SPIN_COUNT = 64;
+
+} // namespace concurrent_detail
+
+/**
+ * Implementations for the read proxy
+ */
+template <typename Type, typename Cv>
+Concurrent<Type, Seqlock, Cv>::ReadProxy::ReadProxy(const Concurrent& instance)
+    : snapshot{instance.read()} {}
+
+template <typename Type, typename Cv>
+const Type* Concurrent<Type, Seqlock, Cv>::ReadProxy::operator->() const {
+    return &this->snapshot;
+}
+
+template <typename Type, typename Cv>
+const Type& Concurrent<Type, Seqlock, Cv>::ReadProxy::operator*() const {
+    return this->snapshot;
+}
+
+/**
+ * Implementations for the write proxy
+ */
+template <typename Type, typename Cv>
+Concurrent<Type, Seqlock, Cv>::WriteProxy::WriteProxy(Concurrent& instance)
+        // no other writer can change the value while the mutex is held, so
+        // there is no need to check the sequence counter.  The copy is
+        // initialized directly so Type does not have to be default
+        // constructible
+        : instance_ptr{&instance},
+          copy{(instance.writer.lock(), instance.load())} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Seqlock, Cv>::WriteProxy::WriteProxy(
+        WriteProxy&& other) noexcept
+        : instance_ptr{other.instance_ptr}, copy{other.copy} {
+    other.instance_ptr = nullptr;
+}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Seqlock, Cv>::WriteProxy::~WriteProxy() {
+    this->unlock();
+}
+
+template <typename Type, typename Cv>
+void Concurrent<Type, Seqlock, Cv>::WriteProxy::unlock() noexcept {
+    if (this->instance_ptr) {
+        this->instance_ptr->write(this->copy);
+        this->instance_ptr->writer.unlock();
+        this->instance_ptr = nullptr;
+    }
+}
+
+template <typename Type, typename Cv>
+Type* Concurrent<Type, Seqlock, Cv>::WriteProxy::operator->() {
+    return &this->copy;
+}
+
+template <typename Type, typename Cv>
+Type& Concurrent<Type, Seqlock, Cv>::WriteProxy::operator*() {
+    return this->copy;
+}
+
+/**
+ * Implementations for the Concurrent<Type, Seqlock> methods
+ */
+template <typename Type, typename Cv>
+template <typename Func>
+decltype(auto) Concurrent<Type, Seqlock, Cv>::synchronized(Func&& func) {
+    auto lock = this->lock();
+    return std::forward<Func>(func)(*lock);
+}
+
+template <typename Type, typename Cv>
+template <typename Func>
+decltype(auto) Concurrent<Type, Seqlock, Cv>::synchronized(Func&& func) const {
+    auto lock = this->lock();
+    return std::forward<Func>(func)(*lock);
+}
+
+template <typename Type, typename Cv>
+auto Concurrent<Type, Seqlock, Cv>::lock() {
+    return WriteProxy{*this};
+}
+
+template <typename Type, typename Cv>
+auto Concurrent<Type, Seqlock, Cv>::lock() const {
+    return ReadProxy{*this};
+}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Seqlock, Cv>::Concurrent() : Concurrent{Type{}} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Seqlock, Cv>::Concurrent(const Concurrent& other)
+    : Concurrent{other.read()} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Seqlock, Cv>::Concurrent(const Type& instance) {
+    this->store(instance);
+}
+
+template <typename Type, typename Cv>
+template <typename... Args>
+Concurrent<Type, Seqlock, Cv>::Concurrent(std::in_place_t, Args&&... args)
+    : Concurrent{Type{std::forward<Args>(args)...}} {}
+
+template <typename Type, typename Cv>
+template <typename U, typename... Args>
+Concurrent<Type, Seqlock, Cv>::Concurrent(
+        std::in_place_t, std::initializer_list<U> il, Args&&... args)
+    : Concurrent{Type{il, std::forward<Args>(args)...}} {}
+
+template <typename Type, typename Cv>
+Concurrent<Type, Seqlock, Cv>& Concurrent<Type, Seqlock, Cv>::operator=(
+        const Concurrent& other) {
+    auto instance = other.read();
+    std::lock_guard<std::mutex> lock{this->writer};
+    this->write(instance);
+    return *this;
+}
+
+template <typename Type, typename Cv>
+Type Concurrent<Type, Seqlock, Cv>::load() const {
+    std::uintptr_t buffer[WORDS];
+    for (auto i = std::size_t{0}; i < WORDS; ++i) {
+        buffer[i] = this->words[i].load(std::memory_order_relaxed);
+    }
+
+    // copy the bytes into raw storage rather than into a default
+    // constructed object, so Type does not have to be default constructible
+    auto storage = std::aligned_storage_t<sizeof(Type), alignof(Type)>{};
+    std::memcpy(&storage, buffer, sizeof(Type));
+    return *reinterpret_cast<const Type*>(&storage);
+}
+
+template <typename Type, typename Cv>
+void Concurrent<Type, Seqlock, Cv>::store(const Type& instance) {
+    std::uintptr_t buffer[WORDS] = {};
+    std::memcpy(buffer, &instance, sizeof(Type));
+    for (auto i = std::size_t{0}; i < WORDS; ++i) {
+        this->words[i].store(buffer[i], std::memory_order_relaxed);
+    }
+}
+
+template <typename Type, typename Cv>
+Type Concurrent<Type, Seqlock, Cv>::read() const {
+    for (auto i = 0; true; ++i) {
+        if (i >= concurrent_detail::SEQLOCK_SPIN_COUNT) {
+            std::this_thread::yield();
+        }
+
+        // the acquire fence orders the loads of the words before the second
+        // load of the counter, if the counter did not change then no write
+        // overlapped with the copy
+        auto before = this->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        auto instance = this->load();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (this->sequence.load(std::memory_order_relaxed) == before) {
+            return instance;
+        }
+    }
+}
+
+template <typename Type, typename Cv>
+void Concurrent<Type, Seqlock, Cv>::write(const Type& instance) {
+    // the release fence keeps the stores of the words from becoming visible
+    // before the counter goes odd
+    auto before = this->sequence.load(std::memory_order_relaxed);
+    this->sequence.store(before + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->store(instance);
+    this->sequence.store(before + 2, std::memory_order_release);
+}
+
+} // namespace sharp
@@ -1,11 +1,24 @@
+#include <sharp/Concurrent/AsyncSynchronized.hpp>
 #include <sharp/Concurrent/Concurrent.hpp>
+#include <sharp/Concurrent/ShardedConcurrent.hpp>
+#include <sharp/Executor/ThreadPoolExecutor.hpp>
+#include <sharp/Future/Future.hpp>
 #include <sharp/Tags/Tags.hpp>
 #include <sharp/Utility/Utility.hpp>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <stdexcept>
 #include <cassert>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 using namespace sharp;
 using std::cout;
@@ -388,6 +401,656 @@ TEST(Concurrent, WaitSignal) {
     }
 }
 
+TEST(Concurrent, WaitLargeCondition) {
+    // the waiter refers to the condition in place, so conditions with big
+    // captures work without being copied anywhere
+    for (auto i = 0; i < STRESS; ++i) {
+        auto concurrent = sharp::Concurrent<int>{0};
+        auto expected = std::array<int, 64>{};
+        expected.back() = 1;
+
+        auto th = std::thread{[&]() {
+            auto lock = concurrent.lock();
+            lock.wait([expected](auto& integer) {
+                return integer == expected.back();
+            });
+            EXPECT_EQ(*lock, 1);
+        }};
+
+        concurrent.synchronized([](auto& integer) { integer = 1; });
+        th.join();
+    }
+}
+
 TEST(Concurrent, TestLock) {
     ConcurrentTests::test_lock_free();
 }
+
+TEST(Concurrent, KeyedWait) {
+    for (auto i = 0; i < STRESS / 10; ++i) {
+        const auto THREADS = 10;
+        auto jobs = sharp::Concurrent<std::unordered_map<int, bool>>{};
+        auto threads = std::vector<std::thread>{};
+        for (auto j = 0; j < THREADS; ++j) {
+            threads.push_back(std::thread{[&, j]() {
+                auto lock = jobs.lock();
+                lock.wait(j, [j](auto& jobs) {
+                    return jobs.count(j) && jobs.at(j);
+                });
+                EXPECT_TRUE(lock->at(j));
+            }});
+        }
+
+        for (auto j = THREADS - 1; j >= 0; --j) {
+            auto lock = jobs.lock();
+            (*lock)[j] = true;
+            lock.touch(j);
+        }
+
+        for (auto& th : threads) {
+            th.join();
+        }
+    }
+}
+
+TEST(Concurrent, KeyedWaitOnlyEvaluatedOnTouch) {
+    std::atomic<int> evaluations{0};
+    auto data = sharp::Concurrent<int>{0};
+    auto waiting = sharp::Concurrent<bool>{false};
+
+    auto th = std::thread{[&]() {
+        auto lock = data.lock();
+        *waiting.lock() = true;
+        lock.wait(1, [&](auto& value) {
+            ++evaluations;
+            return value == 1;
+        });
+    }};
+    waiting.lock().wait([](auto waiting) { return waiting; });
+
+    // unlocks that do not touch the key do not look at the waiter, the
+    // waiter is asleep once the lock can be acquired
+    auto before = data.synchronized([&](auto&) { return evaluations.load(); });
+    for (auto i = 0; i < 100; ++i) {
+        data.synchronized([](auto& value) { value = 2; });
+    }
+    EXPECT_EQ(evaluations.load(), before);
+
+    // touching another key does not either
+    data.synchronized([](auto& value) { value = 1; });
+    {
+        auto lock = data.lock();
+        lock.touch(2);
+    }
+    EXPECT_EQ(evaluations.load(), before);
+
+    {
+        auto lock = data.lock();
+        lock.touch(1);
+    }
+    th.join();
+    EXPECT_GT(evaluations.load(), before);
+}
+
+TEST(Concurrent, KeyedWaitManyTouchedKeys) {
+    // touching more keys than are tracked one by one still wakes up the
+    // waiters under the keys that were touched
+    const auto THREADS = 4;
+    const auto KEYS = static_cast<int>(sharp::concurrent_detail::MAX_DIRTY_KEYS)
+        * 4;
+    auto jobs = sharp::Concurrent<std::unordered_map<int, bool>>{};
+    auto threads = std::vector<std::thread>{};
+    for (auto j = 0; j < THREADS; ++j) {
+        threads.push_back(std::thread{[&, j]() {
+            auto key = KEYS - 1 - j;
+            auto lock = jobs.lock();
+            lock.wait(key, [key](auto& jobs) { return jobs.count(key); });
+        }});
+    }
+
+    {
+        auto lock = jobs.lock();
+        for (auto key = 0; key < KEYS; ++key) {
+            (*lock)[key] = true;
+            lock.touch(key);
+        }
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+}
+
+TEST(Concurrent, KeyedWaitChainsWakeups) {
+    // a single touch wakes up every waiter under the key whose condition is
+    // satisfied, one after the other
+    for (auto i = 0; i < STRESS / 10; ++i) {
+        const auto THREADS = 10;
+        auto data = sharp::Concurrent<bool>{false};
+        auto threads = std::vector<std::thread>{};
+        for (auto j = 0; j < THREADS; ++j) {
+            threads.push_back(std::thread{[&]() {
+                auto lock = data.lock();
+                lock.wait(7, [](auto go) { return go; });
+            }});
+        }
+
+        auto lock = data.lock();
+        *lock = true;
+        lock.touch(7);
+        lock.unlock();
+
+        for (auto& th : threads) {
+            th.join();
+        }
+    }
+}
+
+TEST(Concurrent, WaitForTimesOut) {
+    auto data = sharp::Concurrent<int>{0};
+    auto lock = data.lock();
+    EXPECT_FALSE(lock.wait_for(std::chrono::milliseconds{10}, [](auto& value) {
+        return value == 1;
+    }));
+
+    // the lock is still held and the timed out waiter is out of the queue
+    *lock = 1;
+    EXPECT_TRUE(lock.wait_until(std::chrono::steady_clock::now(),
+            [](auto& value) { return value == 1; }));
+    lock.unlock();
+    EXPECT_EQ(data.synchronized([](auto value) { return value; }), 1);
+}
+
+TEST(Concurrent, WaitOnConstObject) {
+    // the waiter bookkeeping is mutable, so waiting through a read lock on
+    // an object that is declared const is fine
+    const sharp::Concurrent<int> data{0};
+    auto lock = data.lock();
+    EXPECT_FALSE(lock.wait_for(std::chrono::milliseconds{10}, [](auto& value) {
+        return value == 1;
+    }));
+    EXPECT_TRUE(lock.wait_for(std::chrono::milliseconds{10}, [](auto& value) {
+        return value == 0;
+    }));
+}
+
+TEST(Concurrent, WaitForSucceeds) {
+    for (auto i = 0; i < STRESS; ++i) {
+        auto data = sharp::Concurrent<int>{0};
+        auto th = std::thread{[&]() {
+            auto lock = data.lock();
+            EXPECT_TRUE(lock.wait_for(std::chrono::seconds{10},
+                    [](auto& value) { return value == 1; }));
+            EXPECT_EQ(*lock, 1);
+        }};
+
+        data.synchronized([](auto& value) { value = 1; });
+        th.join();
+    }
+}
+
+TEST(Concurrent, WaitForMixedWithWaits) {
+    // timed out waiters take themselves off the queue without disturbing the
+    // waiters around them
+    for (auto i = 0; i < STRESS / 10; ++i) {
+        const auto THREADS = 8;
+        auto data = sharp::Concurrent<int>{0};
+        std::atomic<int> timeouts{0};
+        auto threads = std::vector<std::thread>{};
+        for (auto j = 0; j < THREADS; ++j) {
+            threads.push_back(std::thread{[&, j]() {
+                auto lock = data.lock();
+                if (j % 2) {
+                    lock.wait([](auto& value) { return value == 2; });
+                } else if (!lock.wait_for(std::chrono::microseconds{j * 100},
+                            [](auto& value) { return value == 3; })) {
+                    ++timeouts;
+                }
+            }});
+        }
+
+        for (auto value = 0; value < 3; ++value) {
+            std::this_thread::sleep_for(std::chrono::microseconds{200});
+            data.synchronized([&](auto& v) { v = value; });
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+        EXPECT_EQ(timeouts.load(), THREADS / 2);
+    }
+}
+
+TEST(Concurrent, RcuBasic) {
+    auto data = sharp::Concurrent<std::vector<int>, sharp::Rcu>{
+        std::in_place, {1, 2, 3}};
+    const auto& const_data = data;
+
+    // a reader keeps its snapshot across a write, and sees the write once it
+    // locks again.  The writer waits for the reader to unlock before
+    // returning
+    auto snapshot = const_data.lock();
+    std::atomic<bool> written{false};
+    auto writer = std::thread{[&]() {
+        data.synchronized([](auto& vec) { vec.push_back(4); });
+        written.store(true);
+    }};
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    EXPECT_EQ(snapshot->size(), 3);
+    EXPECT_FALSE(written.load());
+    snapshot.unlock();
+    writer.join();
+    EXPECT_EQ(const_data.synchronized([](auto& vec) { return vec.size(); }),
+              4);
+
+    // writes are only visible after the write proxy is unlocked
+    {
+        auto lock = data.lock();
+        lock->push_back(5);
+        EXPECT_EQ(const_data.lock()->size(), 4);
+    }
+    EXPECT_EQ(*const_data.lock(), (std::vector<int>{1, 2, 3, 4, 5}));
+
+    auto copy = data;
+    data = sharp::Concurrent<std::vector<int>, sharp::Rcu>{};
+    EXPECT_EQ(const_data.lock()->size(), 0);
+    EXPECT_EQ(sharp::as_const(copy).lock()->size(), 5);
+    copy = copy;
+    EXPECT_EQ(sharp::as_const(copy).lock()->size(), 5);
+}
+
+namespace {
+    class Counted {
+    public:
+        static std::atomic<int> alive;
+        Counted() { ++alive; }
+        Counted(const Counted& other) : values{other.values} { ++alive; }
+        ~Counted() { --alive; }
+        std::vector<int> values = std::vector<int>(8, 0);
+    };
+    std::atomic<int> Counted::alive{0};
+} // namespace <anonymous>
+
+TEST(Concurrent, RcuReadersSeeConsistentSnapshots) {
+    {
+        const auto READERS = 4;
+        const auto WRITES = 200;
+        auto data = sharp::Concurrent<Counted, sharp::Rcu>{};
+        std::atomic<bool> done{false};
+
+        auto readers = std::vector<std::thread>{};
+        for (auto i = 0; i < READERS; ++i) {
+            readers.push_back(std::thread{[&]() {
+                while (!done.load()) {
+                    auto lock = sharp::as_const(data).lock();
+                    for (auto value : lock->values) {
+                        EXPECT_EQ(value, lock->values.front());
+                    }
+                }
+            }});
+        }
+
+        // every write changes all the values, a reader that sees a mix of
+        // two versions or a destroyed version fails above
+        auto writers = std::vector<std::thread>{};
+        for (auto i = 0; i < 2; ++i) {
+            writers.push_back(std::thread{[&]() {
+                for (auto j = 0; j < WRITES; ++j) {
+                    data.synchronized([](auto& counted) {
+                        for (auto& value : counted.values) {
+                            ++value;
+                        }
+                    });
+                }
+            }});
+        }
+
+        for (auto& th : writers) {
+            th.join();
+        }
+        done.store(true);
+        for (auto& th : readers) {
+            th.join();
+        }
+
+        // old versions are retired as soon as the write is done
+        EXPECT_EQ(Counted::alive.load(), 1);
+        EXPECT_EQ(sharp::as_const(data).lock()->values.front(), 2 * WRITES);
+    }
+    EXPECT_EQ(Counted::alive.load(), 0);
+}
+
+TEST(Concurrent, SeqlockBasic) {
+    struct Point {
+        int x;
+        int y;
+    };
+    auto point = sharp::Concurrent<Point, sharp::Seqlock>{std::in_place, 1, 2};
+    EXPECT_EQ(sharp::as_const(point).lock()->x, 1);
+    EXPECT_EQ(sharp::as_const(point).lock()->y, 2);
+
+    // writes are copied back on unlock, reads are copies
+    {
+        auto lock = point.lock();
+        lock->x = 3;
+        EXPECT_EQ(sharp::as_const(point).lock()->x, 1);
+    }
+    auto snapshot = sharp::as_const(point).lock();
+    point.synchronized([](auto& point) { point.y = 4; });
+    EXPECT_EQ(snapshot->y, 2);
+    EXPECT_EQ(sharp::as_const(point).synchronized([](auto& point) {
+        return point.x + point.y;
+    }), 7);
+
+    auto copy = point;
+    point = sharp::Concurrent<Point, sharp::Seqlock>{};
+    EXPECT_EQ(sharp::as_const(point).lock()->x, 0);
+    EXPECT_EQ(sharp::as_const(copy).lock()->x, 3);
+}
+
+TEST(Concurrent, SeqlockNotDefaultConstructible) {
+    class Point {
+    public:
+        Point(int x_in, int y_in) : x{x_in}, y{y_in} {}
+        int x;
+        int y;
+    };
+    auto point = sharp::Concurrent<Point, sharp::Seqlock>{std::in_place, 1, 2};
+    point.synchronized([](auto& point) { point.y = 3; });
+    auto lock = sharp::as_const(point).lock();
+    EXPECT_EQ(lock->x, 1);
+    EXPECT_EQ(lock->y, 3);
+}
+
+TEST(Concurrent, SeqlockReadersSeeConsistentValues) {
+    // a value that spans several words, a torn read would see values from
+    // two different writes
+    struct Values {
+        std::uint64_t values[6];
+    };
+    const auto WRITES = 20000;
+    auto data = sharp::Concurrent<Values, sharp::Seqlock>{};
+    std::atomic<bool> done{false};
+
+    auto readers = std::vector<std::thread>{};
+    for (auto i = 0; i < 4; ++i) {
+        readers.push_back(std::thread{[&]() {
+            while (!done.load()) {
+                auto lock = sharp::as_const(data).lock();
+                for (auto value : lock->values) {
+                    EXPECT_EQ(value, lock->values[0]);
+                }
+            }
+        }});
+    }
+
+    auto writers = std::vector<std::thread>{};
+    for (auto i = 0; i < 2; ++i) {
+        writers.push_back(std::thread{[&]() {
+            for (auto j = 0; j < WRITES; ++j) {
+                data.synchronized([](auto& data) {
+                    for (auto& value : data.values) {
+                        ++value;
+                    }
+                });
+            }
+        }});
+    }
+
+    for (auto& th : writers) {
+        th.join();
+    }
+    done.store(true);
+    for (auto& th : readers) {
+        th.join();
+    }
+    EXPECT_EQ(sharp::as_const(data).lock()->values[5], 2 * WRITES);
+}
+
+TEST(Concurrent, ShardedBasic) {
+    sharp::ShardedConcurrent<std::unordered_map<int, int>, 8> map;
+    for (auto i = 0; i < 100; ++i) {
+        map.synchronized(i, [i](auto& shard) { shard[i] = i * 2; });
+    }
+
+    // keys are spread over more than one shard, and each key is found in the
+    // shard it hashes to
+    auto used = std::vector<bool>(8, false);
+    for (auto i = 0; i < 100; ++i) {
+        used[map.shard(i)] = true;
+        EXPECT_EQ(sharp::as_const(map).lock(i)->at(i), i * 2);
+    }
+    EXPECT_GT(std::count(used.begin(), used.end(), true), 1);
+
+    auto size = std::size_t{0};
+    for (auto& shard : sharp::as_const(map).lock_all()) {
+        size += shard->size();
+    }
+    EXPECT_EQ(size, 100);
+}
+
+TEST(Concurrent, ShardedLockAllWithWriters) {
+    // lock_all() sees a consistent total while writers move counts between
+    // keys in different shards one key at a time
+    const auto KEYS = 64;
+    const auto ITERATIONS = 2000;
+    sharp::ShardedConcurrent<std::unordered_map<int, int>, 16> map;
+    for (auto i = 0; i < KEYS; ++i) {
+        map.synchronized(i, [i](auto& shard) { shard[i] = 0; });
+    }
+
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < 4; ++i) {
+        threads.push_back(std::thread{[&, i]() {
+            for (auto j = 0; j < ITERATIONS; ++j) {
+                map.synchronized((i * 7 + j) % KEYS, [&](auto& shard) {
+                    ++shard[(i * 7 + j) % KEYS];
+                });
+            }
+        }});
+    }
+    threads.push_back(std::thread{[&]() {
+        auto last = 0;
+        for (auto j = 0; j < ITERATIONS / 10; ++j) {
+            auto total = 0;
+            for (auto& shard : map.lock_all()) {
+                for (auto& entry : *shard) {
+                    total += entry.second;
+                }
+            }
+            EXPECT_GE(total, last);
+            last = total;
+        }
+    }});
+
+    for (auto& th : threads) {
+        th.join();
+    }
+    auto total = 0;
+    for (auto& shard : map.lock_all()) {
+        for (auto& entry : *shard) {
+            total += entry.second;
+        }
+    }
+    EXPECT_EQ(total, 4 * ITERATIONS);
+}
+
+TEST(Concurrent, CombiningBasic) {
+    auto data = sharp::Concurrent<std::vector<int>, sharp::Combining>{
+        std::in_place, {1, 2}};
+    EXPECT_EQ(data.synchronized([](auto& vec) {
+        vec.push_back(3);
+        return vec.size();
+    }), 3);
+    data.synchronized([](auto& vec) { vec.push_back(4); });
+    EXPECT_EQ(sharp::as_const(data).synchronized([](auto& vec) {
+        return vec.back();
+    }), 4);
+    EXPECT_EQ(data.lock()->size(), 4);
+    EXPECT_EQ(sharp::as_const(data).lock()->front(), 1);
+
+    // exceptions are propagated to the thread that published the closure
+    EXPECT_THROW(data.synchronized([](auto& vec) {
+        vec.push_back(5);
+        throw std::runtime_error{""};
+    }), std::runtime_error);
+    EXPECT_EQ(data.lock()->size(), 5);
+}
+
+TEST(Concurrent, CombiningThreaded) {
+    const auto THREADS = 8;
+    const auto ITERATIONS = 5000;
+    auto data = sharp::Concurrent<std::vector<int>, sharp::Combining>{};
+
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < THREADS; ++i) {
+        threads.push_back(std::thread{[&, i]() {
+            for (auto j = 0; j < ITERATIONS; ++j) {
+                auto size = data.synchronized([&](auto& vec) {
+                    vec.push_back(i);
+                    return vec.size();
+                });
+                EXPECT_GE(size, j + 1);
+
+                // lock proxies and combined closures exclude each other
+                if (!(j % 100)) {
+                    auto lock = data.lock();
+                    lock->push_back(-1);
+                    lock->pop_back();
+                }
+            }
+        }});
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    auto counts = std::vector<int>(THREADS, 0);
+    for (auto value : *data.lock()) {
+        ++counts.at(value);
+    }
+    for (auto count : counts) {
+        EXPECT_EQ(count, ITERATIONS);
+    }
+}
+
+namespace {
+    /**
+     * An executor that holds on to closures until told to run them
+     */
+    class ManualExecutor : public sharp::Executor {
+    public:
+        void add(sharp::UniqueFunction<void()> closure) override {
+            this->closures.push_back(std::move(closure));
+        }
+        void run() {
+            for (auto& closure : this->closures) {
+                closure();
+            }
+            this->closures.clear();
+        }
+        std::vector<sharp::UniqueFunction<void()>> closures;
+    };
+} // namespace <anonymous>
+
+TEST(Concurrent, AsyncSynchronized) {
+    auto executor = ManualExecutor{};
+    auto data = sharp::Concurrent<std::vector<int>>{};
+
+    // with the lock free the function runs right away
+    auto size = sharp::async_synchronized(data, executor, [](auto& vec) {
+        vec.push_back(1);
+        return vec.size();
+    });
+    EXPECT_TRUE(size.is_ready());
+    EXPECT_EQ(size.get(), 1);
+    EXPECT_TRUE(executor.closures.empty());
+
+    // with the lock held the functions are queued and run by the holder when
+    // it releases the lock
+    auto lock = data.lock();
+    auto one = sharp::async_synchronized(data, executor, [](auto& vec) {
+        vec.push_back(2);
+    });
+    auto two = sharp::async_synchronized(data, executor, [](auto& vec) {
+        vec.push_back(3);
+        throw std::runtime_error{""};
+        return 0;
+    });
+    EXPECT_FALSE(one.is_ready());
+    EXPECT_FALSE(two.is_ready());
+    EXPECT_EQ(lock->size(), 1);
+    lock.unlock();
+
+    EXPECT_TRUE(one.is_ready());
+    EXPECT_EQ(one.get(), sharp::Unit{});
+    EXPECT_THROW(two.get(), std::runtime_error);
+    EXPECT_EQ(*data.lock(), (std::vector<int>{1, 2, 3}));
+
+    // the executor tasks find nothing left to run
+    EXPECT_EQ(executor.closures.size(), 2);
+    executor.run();
+    EXPECT_EQ(data.lock()->size(), 3);
+}
+
+TEST(Concurrent, AsyncSynchronizedContinuations) {
+    auto executor = ManualExecutor{};
+    auto data = sharp::Concurrent<int>{0};
+
+    // continuations run without the lock held, so they can use the object
+    auto lock = data.lock();
+    auto future = sharp::async_synchronized(data, executor, [](auto& value) {
+        return ++value;
+    }).then([&](auto future) {
+        return data.synchronized([&](auto& value) {
+            return value + future.get();
+        });
+    });
+    lock.unlock();
+    EXPECT_EQ(future.get(), 2);
+    executor.run();
+}
+
+TEST(Concurrent, AsyncSynchronizedOutlivesObject) {
+    // once the holder has run the function the executor task must not touch
+    // the object, which is free to go away as soon as the future is ready
+    auto executor = ManualExecutor{};
+    {
+        auto data = std::make_unique<sharp::Concurrent<int>>(0);
+        auto lock = data->lock();
+        auto future = sharp::async_synchronized(*data, executor,
+                [](auto& value) { return ++value; });
+        lock.unlock();
+        EXPECT_EQ(future.get(), 1);
+    }
+    EXPECT_EQ(executor.closures.size(), 1);
+    executor.run();
+}
+
+TEST(Concurrent, AsyncSynchronizedThreaded) {
+    const auto THREADS = 4;
+    const auto ITERATIONS = 2000;
+    sharp::ThreadPoolExecutor executor{2};
+    auto data = sharp::Concurrent<int>{0};
+
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < THREADS; ++i) {
+        threads.push_back(std::thread{[&]() {
+            auto futures = std::vector<sharp::Future<int>>{};
+            for (auto j = 0; j < ITERATIONS; ++j) {
+                futures.push_back(sharp::async_synchronized(data, executor,
+                        [](auto& value) { return ++value; }));
+                if (!(j % 50)) {
+                    data.synchronized([](auto& value) { ++value; });
+                }
+            }
+            for (auto& future : futures) {
+                EXPECT_GT(future.get(), 0);
+            }
+        }});
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    executor.shutdown();
+    EXPECT_EQ(data.synchronized([](auto value) { return value; }),
+              THREADS * ITERATIONS + THREADS * (ITERATIONS / 50));
+}
@@ -1,7 +1,23 @@
 #include <sharp/Executor/Executor.hpp>
 
+#include <cstdint>
+#include <utility>
+
 namespace sharp {
 
+constexpr std::int8_t Executor::LO_PRI;
+constexpr std::int8_t Executor::MID_PRI;
+constexpr std::int8_t Executor::HI_PRI;
+
+void Executor::add_with_priority(sharp::UniqueFunction<void()> closure,
+                                 std::int8_t) {
+    this->add(std::move(closure));
+}
+
+int Executor::num_priorities() const {
+    return 1;
+}
+
 std::size_t Executor::num_pending_closures() const {
     return 0;
 }
@@ -13,6 +13,7 @@
 #include <sharp/Functional/Functional.hpp>
 
 #include <cstddef>
+#include <cstdint>
 
 namespace sharp {
 
@@ -33,10 +34,23 @@ namespace sharp {
  *
  * All implementations of executor classes will derive from this one base
  * class and then specialize the .add() member function
+ *
+ * Executors that can order closures by priority also specialize
+ * add_with_priority() and num_priorities(), everything else treats every
+ * closure the same and add_with_priority() just calls add()
  */
 class Executor {
 public:
 
+    /**
+     * Priorities are signed bytes, higher values run first.  These are the
+     * lowest, the default and the highest priority, an executor with a
+     * number of priority levels spreads the whole range evenly over them
+     */
+    static constexpr std::int8_t LO_PRI = INT8_MIN;
+    static constexpr std::int8_t MID_PRI = 0;
+    static constexpr std::int8_t HI_PRI = INT8_MAX;
+
     /**
      * Virtual destructor for the Executor class
      */
@@ -51,7 +65,20 @@ public:
      * implementation of the executor, for example it can either be executed
      * inline or on another thread
      */
-    virtual void add(sharp::Function<void()> closure) = 0;
+    virtual void add(sharp::UniqueFunction<void()> closure) = 0;
+
+    /**
+     * Adds a closure with the given priority, by default priorities are
+     * ignored and this is the same as add()
+     */
+    virtual void add_with_priority(sharp::UniqueFunction<void()> closure,
+                                   std::int8_t priority);
+
+    /**
+     * Returns the number of distinct priority levels the executor has, one
+     * for executors that do not support priorities
+     */
+    virtual int num_priorities() const;
 
     /**
      * Returns the number of function objects waiting to be executed
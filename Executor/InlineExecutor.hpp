@@ -28,7 +28,7 @@ public:
     /**
      * Do the thing
      */
-    void add(sharp::Function<void()> closure) override {
+    void add(sharp::UniqueFunction<void()> closure) override {
         closure();
     }
 
@@ -0,0 +1,163 @@
+#include <sharp/Executor/PriorityThreadPoolExecutor.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace sharp {
+
+namespace {
+
+    /**
+     * The pool the worker running on the current thread belongs to, if any.
+     * Workers can keep adding closures while the pool is shutting down
+     */
+    thread_local PriorityThreadPoolExecutor* current_pool{nullptr};
+
+} // namespace anonymous
+
+PriorityThreadPoolExecutor::PriorityThreadPoolExecutor(
+        int num_threads, int num_priorities, Clock::duration aging_in)
+        : lanes(std::max(num_priorities, 1)), served(lanes.size()),
+          aging{aging_in} {
+    assert(this->aging.count() > 0);
+    num_threads = std::max(num_threads, 1);
+    for (auto i = 0; i < num_threads; ++i) {
+        this->workers.emplace_back([this]() { this->run(); });
+    }
+}
+
+PriorityThreadPoolExecutor::~PriorityThreadPoolExecutor() {
+    this->shutdown();
+}
+
+void PriorityThreadPoolExecutor::add(sharp::UniqueFunction<void()> closure) {
+    this->add_with_priority(std::move(closure), Executor::MID_PRI);
+}
+
+void PriorityThreadPoolExecutor::add_with_priority(
+        sharp::UniqueFunction<void()> closure, std::int8_t priority) {
+    // spread the range of priorities evenly over the lanes, so the lowest
+    // priority goes to the first lane and the highest to the last
+    auto range = int{INT8_MAX} - int{INT8_MIN} + 1;
+    auto lane = (int{priority} - int{INT8_MIN}) * this->num_priorities()
+        / range;
+    auto task = Task{std::move(closure), Clock::now()};
+
+    {
+        auto lck = std::unique_lock<std::mutex>{this->mtx};
+        if (this->stopping && current_pool != this) {
+            throw std::logic_error{"sharp::PriorityThreadPoolExecutor::add() "
+                "called after shutdown()"};
+        }
+        this->lanes[lane].push_back(std::move(task));
+        ++this->pending;
+    }
+    this->cv.notify_one();
+}
+
+int PriorityThreadPoolExecutor::num_priorities() const {
+    return static_cast<int>(this->lanes.size());
+}
+
+std::size_t PriorityThreadPoolExecutor::num_pending_closures() const {
+    auto lck = std::unique_lock<std::mutex>{this->mtx};
+    return this->pending;
+}
+
+void PriorityThreadPoolExecutor::shutdown() {
+    assert(current_pool != this);
+    std::call_once(this->joined, [this]() {
+        {
+            auto lck = std::unique_lock<std::mutex>{this->mtx};
+            this->stopping = true;
+        }
+        this->cv.notify_all();
+
+        for (auto& worker : this->workers) {
+            worker.join();
+        }
+    });
+}
+
+void PriorityThreadPoolExecutor::run() {
+    current_pool = this;
+
+    auto lck = std::unique_lock<std::mutex>{this->mtx};
+    while (true) {
+        auto lane = this->pick_lane();
+        if (lane < 0) {
+            if (this->stopping) {
+                break;
+            }
+            this->cv.wait(lck);
+            continue;
+        }
+
+        auto task = std::move(this->lanes[lane].front());
+        this->lanes[lane].pop_front();
+        this->served[lane] = Clock::now();
+        --this->pending;
+
+        lck.unlock();
+        task.closure();
+        task = Task{};
+        lck.lock();
+    }
+
+    current_pool = nullptr;
+}
+
+int PriorityThreadPoolExecutor::pick_lane() const {
+    auto highest = static_cast<int>(this->lanes.size()) - 1;
+    while (highest >= 0 && this->lanes[highest].empty()) {
+        --highest;
+    }
+
+    // the clock only needs to be read when something below the highest
+    // non empty lane could have aged past it
+    auto lower = highest - 1;
+    while (lower >= 0 && this->lanes[lower].empty()) {
+        --lower;
+    }
+    if (lower < 0) {
+        return highest;
+    }
+
+    // every aging interval that a lane has gone without being served moves
+    // the closure at its front up one lane, among closures that end up in
+    // the same lane the one whose lane has waited the longest goes first.
+    // Aging from the last time the lane was served rather than from when
+    // the closure was added means a backlog that has been waiting for a
+    // while gets one closure in per aging interval, and does not outrank
+    // higher lanes for as long as it takes to run all of it
+    auto now = Clock::now();
+    auto best = highest;
+    auto best_since = this->waiting_since(highest);
+    auto best_level = static_cast<std::int64_t>(highest);
+    for (auto lane = lower; lane >= 0; --lane) {
+        if (this->lanes[lane].empty()) {
+            continue;
+        }
+        auto since = this->waiting_since(lane);
+        auto level = lane + (now - since) / this->aging;
+        if (level > best_level || (level == best_level
+                && since < best_since)) {
+            best = lane;
+            best_since = since;
+            best_level = level;
+        }
+    }
+    return best;
+}
+
+PriorityThreadPoolExecutor::Clock::time_point
+PriorityThreadPoolExecutor::waiting_since(int lane) const {
+    return std::max(this->lanes[lane].front().added, this->served[lane]);
+}
+
+} // namespace sharp
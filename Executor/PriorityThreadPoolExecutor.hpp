@@ -0,0 +1,168 @@
+/**
+ * @file PriorityThreadPoolExecutor.hpp
+ * @author Aaryaman Sagar
+ *
+ * A thread pool that runs closures by priority, so that latency sensitive
+ * work does not queue up behind a large backlog of batch work that shares the
+ * same threads
+ */
+
+#pragma once
+
+#include <sharp/Executor/Executor.hpp>
+#include <sharp/Functional/Functional.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sharp {
+
+/**
+ * @class PriorityThreadPoolExecutor
+ *
+ * Closures are put in one of a fixed number of lanes by priority and each
+ * lane is first in first out.  Workers take the closure at the front of the
+ * highest priority lane that has one, so a closure added with a high
+ * priority only has to wait for the closures that are already running and
+ * the ones ahead of it in its own lane
+ *
+ *      auto executor = sharp::PriorityThreadPoolExecutor{8};
+ *      for (auto& row : backfill) {
+ *          executor.add_with_priority([&]() { copy(row); },
+ *                                     sharp::Executor::LO_PRI);
+ *      }
+ *
+ *      // runs as soon as a worker is free, not after the backfill
+ *      future.via(&executor, sharp::Executor::HI_PRI).then(respond);
+ *
+ * Strict priorities starve the lower lanes when the higher ones never run
+ * dry, so lanes age.  For every aging interval that a lane has gone without
+ * a worker taking a closure from it, the closure at its front is treated as
+ * if it were in the lane one above, so a closure eventually runs no matter
+ * what else is going on, and a steady stream of high priority closures only
+ * delays lower ones by a bounded amount rather than forever.  Serving a lane
+ * resets its age, so a large backlog that has been waiting for a while gets
+ * one closure in per aging interval rather than all of it ahead of newer
+ * high priority closures
+ *
+ * Closures added with add() get Executor::MID_PRI.  Shutdown works like it
+ * does for ThreadPoolExecutor, everything pending runs before the workers
+ * are joined, and closures must not throw
+ */
+class PriorityThreadPoolExecutor : public Executor {
+public:
+
+    /**
+     * Starts the given number of worker threads with the given number of
+     * priority lanes, the whole range of priorities is spread evenly over the
+     * lanes
+     */
+    explicit PriorityThreadPoolExecutor(
+            int num_threads = std::thread::hardware_concurrency(),
+            int num_priorities = 3,
+            std::chrono::steady_clock::duration aging
+                = std::chrono::milliseconds{100});
+
+    /**
+     * Drains the pending closures and joins the worker threads, see
+     * shutdown()
+     */
+    ~PriorityThreadPoolExecutor() override;
+
+    /**
+     * Non copyable and non movable, the worker threads refer to the executor
+     * by address
+     */
+    PriorityThreadPoolExecutor(const PriorityThreadPoolExecutor&) = delete;
+    PriorityThreadPoolExecutor& operator=(
+            const PriorityThreadPoolExecutor&) = delete;
+
+    /**
+     * Adds the closure with Executor::MID_PRI
+     */
+    void add(sharp::UniqueFunction<void()> closure) override;
+
+    /**
+     * Adds the closure to the lane for the given priority
+     *
+     * Throws a std::logic_error if called from outside the pool after
+     * shutdown() has been called
+     */
+    void add_with_priority(sharp::UniqueFunction<void()> closure,
+                           std::int8_t priority) override;
+
+    /**
+     * Returns the number of priority lanes
+     */
+    int num_priorities() const override;
+
+    /**
+     * Returns the number of closures that have been added but have not
+     * started executing yet
+     */
+    std::size_t num_pending_closures() const override;
+
+    /**
+     * Stops accepting new closures from outside the pool, waits for all
+     * pending closures to finish and joins the worker threads.  Calling this
+     * more than once is fine, calling it from one of the worker threads is
+     * not
+     */
+    void shutdown();
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Task {
+        sharp::UniqueFunction<void()> closure;
+        Clock::time_point added;
+    };
+
+    /**
+     * The main loop for each worker thread
+     */
+    void run();
+
+    /**
+     * Returns the lane to pop from next taking aging into account, or -1 if
+     * every lane is empty.  Called with the lock held
+     */
+    int pick_lane() const;
+
+    /**
+     * Returns the point from which the closure at the front of a non empty
+     * lane has been waiting, the later of when it was added and when the
+     * lane was last served.  Called with the lock held
+     */
+    Clock::time_point waiting_since(int lane) const;
+
+    /**
+     * The lanes, indexed from the lowest priority to the highest, the last
+     * time a worker took a closure from each of them, and the total number
+     * of closures in them
+     */
+    std::vector<std::deque<Task>> lanes;
+    std::vector<Clock::time_point> served;
+    std::size_t pending{0};
+    Clock::duration aging;
+
+    /**
+     * All the state above is protected by the mutex, workers sleep on the
+     * condition variable when there is nothing to run
+     */
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping{false};
+
+    std::vector<std::thread> workers;
+    std::once_flag joined;
+};
+
+} // namespace sharp
@@ -0,0 +1,91 @@
+#include <sharp/Executor/SerialExecutor.hpp>
+
+#include <cassert>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace sharp {
+
+namespace {
+
+    /**
+     * The number of closures a drain task runs before it hands the rest back
+     * to the parent executor as a new task
+     */
+    constexpr auto DRAIN_BATCH = 64;
+
+} // namespace anonymous
+
+SerialExecutor::SerialExecutor(Executor* parent)
+        : state{std::make_shared<State>(parent)} {
+    assert(parent);
+}
+
+void SerialExecutor::add(sharp::UniqueFunction<void()> closure) {
+    // everything but the first closure of a burst goes in the queue, the
+    // drain task is already scheduled or about to be and trusts the count
+    // to mean that there is something to pop
+    if (this->state->pending.fetch_add(1, std::memory_order_acq_rel)) {
+        this->state->queue.push(std::move(closure));
+        return;
+    }
+
+    // the first closure of a burst is carried by the drain task itself, so
+    // if the parent rejects the task the closure goes with it and the count
+    // can be taken back.  Closures that other threads added in the meantime
+    // are counted already and still need a drain, so they run here
+    auto state = this->state;
+    try {
+        state->parent->add([state, closure = std::move(closure)]() mutable {
+            State::drain(std::move(state), std::move(closure));
+        });
+    } catch (...) {
+        if (state->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            State::drain(std::move(state), Task{});
+        }
+        throw;
+    }
+}
+
+std::size_t SerialExecutor::num_pending_closures() const {
+    return this->state->pending.load(std::memory_order_relaxed);
+}
+
+void SerialExecutor::State::drain(std::shared_ptr<State> state, Task task) {
+    auto i = 0;
+    while (true) {
+        for (; i < DRAIN_BATCH; ++i) {
+
+            // the count says there is a closure, but its producer might not
+            // have finished linking it in yet
+            while (!task && !state->queue.pop(task)) {
+                std::this_thread::yield();
+            }
+            task();
+            task = Task{};
+
+            // the release makes everything the closure did visible to the
+            // next closure, which might run on another thread in another
+            // drain task
+            if (state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                return;
+            }
+        }
+
+        // there is more to run, the count is still above zero so nobody
+        // else schedules a drain and this hands it over to a new task.  If
+        // the parent rejects the task, keep draining here instead
+        try {
+            auto parent = state->parent;
+            parent->add([state]() mutable {
+                State::drain(std::move(state), Task{});
+            });
+            return;
+        } catch (...) {
+            i = 0;
+        }
+    }
+}
+
+} // namespace sharp
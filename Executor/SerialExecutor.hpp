@@ -0,0 +1,110 @@
+/**
+ * @file SerialExecutor.hpp
+ * @author Aaryaman Sagar
+ *
+ * An executor that runs closures one at a time in the order they were added,
+ * on top of another executor.  This gives ordered execution per entity
+ * without needing a thread per entity
+ */
+
+#pragma once
+
+#include <sharp/Executor/Executor.hpp>
+#include <sharp/Executor/detail/MpscQueue.hpp>
+#include <sharp/Functional/Functional.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace sharp {
+
+/**
+ * @class SerialExecutor
+ *
+ * Closures added to a serial executor run on the parent executor, but never
+ * at the same time as each other and always in the order in which they were
+ * added.  Each closure happens before the next one starts, so state that is
+ * only touched from closures on one serial executor needs no locking
+ *
+ *      auto pool = sharp::ThreadPoolExecutor{8};
+ *      auto connection = sharp::SerialExecutor{&pool};
+ *
+ *      // these run in order on the pool, one after the other
+ *      connection.add([&]() { read_header(); });
+ *      connection.add([&]() { read_body(); });
+ *
+ * The executor keeps a count of the closures that have been added but have
+ * not finished running.  The thread that moves the count from zero adds a
+ * drain task carrying its closure to the parent, the closures added after
+ * that go into a lock free queue, and the drain task runs closures from the
+ * queue till the count goes back to zero.  So there is at most one drain
+ * task in flight on the parent and the parent sees one task per burst of
+ * closures rather than one per closure.  The drain task hands the rest of
+ * the burst back to the parent as a new task every once in a while, so a
+ * long burst does not hog a thread of the parent while other work is waiting
+ *
+ * If the parent throws from add(), for example a bounded thread pool with
+ * the Reject policy, the closure that started the burst is rejected as well
+ * and add() rethrows.  A drain task that cannot be handed back keeps running
+ * where it is.  The parent must not drop tasks without running them though,
+ * so bounded thread pools with the DropOldest policy cannot be parents
+ *
+ * Closures that are still pending when the serial executor is destroyed
+ * still run, the queue is kept alive by the drain task.  The parent has to
+ * outlive all of them.  Closures must not throw, same as with the thread
+ * pool
+ */
+class SerialExecutor : public Executor {
+public:
+
+    /**
+     * Runs closures on the parent executor, the parent is not owned
+     */
+    explicit SerialExecutor(Executor* parent);
+
+    /**
+     * Non copyable and non movable, like the other executors
+     */
+    SerialExecutor(const SerialExecutor&) = delete;
+    SerialExecutor& operator=(const SerialExecutor&) = delete;
+
+    /**
+     * Queues the closure to run after every closure that was added before
+     * it has finished.  Throws what the parent throws if it rejects the drain
+     * task, in which case the closure does not run
+     */
+    void add(sharp::UniqueFunction<void()> closure) override;
+
+    /**
+     * Returns the number of closures that have been added but have not
+     * finished running, including the one that is running if any
+     */
+    std::size_t num_pending_closures() const override;
+
+private:
+
+    using Task = sharp::UniqueFunction<void()>;
+
+    /**
+     * The state shared with the drain task
+     */
+    struct State {
+        explicit State(Executor* parent_in) : parent{parent_in} {}
+
+        /**
+         * Runs the given closure if any and then closures from the queue
+         * till there are none left or till the batch is done, in which case
+         * the drain is handed back to the parent
+         */
+        static void drain(std::shared_ptr<State> state, Task task);
+
+        Executor* parent;
+        detail::MpscQueue<Task> queue;
+        std::atomic<std::size_t> pending{0};
+    };
+
+    std::shared_ptr<State> state;
+};
+
+} // namespace sharp
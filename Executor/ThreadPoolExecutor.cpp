@@ -0,0 +1,256 @@
+#include <sharp/Executor/ThreadPoolExecutor.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace sharp {
+
+namespace {
+
+    /**
+     * The pool and index of the worker running on the current thread, if
+     * any.  Used to push closures added from a worker onto its own deque
+     */
+    thread_local ThreadPoolExecutor* current_pool{nullptr};
+    thread_local std::size_t current_index{0};
+
+} // namespace anonymous
+
+constexpr std::size_t ThreadPoolExecutor::UNBOUNDED;
+
+ThreadPoolExecutor::ThreadPoolExecutor(int num_threads,
+                                       std::size_t capacity_in,
+                                       OverflowPolicy policy_in)
+        : capacity{capacity_in}, policy{policy_in} {
+    assert(this->capacity > 0);
+    num_threads = std::max(num_threads, 1);
+    for (auto i = 0; i < num_threads; ++i) {
+        this->workers.push_back(std::make_unique<Worker>());
+    }
+
+    // start the threads only after all the workers have been constructed
+    // because workers steal from each other
+    for (auto i = std::size_t{0}; i < this->workers.size(); ++i) {
+        this->workers[i]->thread = std::thread{[this, i]() { this->run(i); }};
+    }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+    this->shutdown();
+}
+
+void ThreadPoolExecutor::add(sharp::UniqueFunction<void()> closure) {
+    // closures from a worker of this pool go on the worker's own deque, this
+    // is the common case for continuations and needs no locking.  If the
+    // deque is full the closure goes to the injection queue, past its bound
+    if (current_pool == this) {
+        this->pending.fetch_add(1);
+        if (!this->workers[current_index]->deque.push(std::move(closure))) {
+            auto lck = std::unique_lock<std::mutex>{this->injection_mtx};
+            this->injection.push_back(std::move(closure));
+        }
+        this->notify_one();
+        return;
+    }
+
+    // a dropped closure is destroyed after the lock has been released, its
+    // destructor might well add something to this executor
+    auto dropped_task = Task{};
+    {
+        auto lck = std::unique_lock<std::mutex>{this->injection_mtx};
+        this->check_stopping();
+
+        if (this->injection.size() >= this->capacity) {
+            switch (this->policy) {
+                case OverflowPolicy::Block:
+                    this->blocked.fetch_add(1, std::memory_order_relaxed);
+                    ++this->waiting_producers;
+                    this->space_cv.wait(lck, [this]() {
+                        return this->injection.size() < this->capacity
+                            || this->stopping.load();
+                    });
+                    --this->waiting_producers;
+                    this->check_stopping();
+                    break;
+                case OverflowPolicy::CallerRuns:
+                    this->ran_inline.fetch_add(1, std::memory_order_relaxed);
+                    lck.unlock();
+                    closure();
+                    return;
+                case OverflowPolicy::Reject:
+                    this->rejected.fetch_add(1, std::memory_order_relaxed);
+                    throw RejectedExecution{"sharp::ThreadPoolExecutor "
+                        "queue is full"};
+                case OverflowPolicy::DropOldest:
+                    this->dropped.fetch_add(1, std::memory_order_relaxed);
+                    dropped_task = std::move(this->injection.front());
+                    this->injection.pop_front();
+                    this->pending.fetch_sub(1);
+                    break;
+            }
+        }
+
+        this->pending.fetch_add(1);
+        this->injection.push_back(std::move(closure));
+    }
+
+    this->notify_one();
+}
+
+std::size_t ThreadPoolExecutor::num_pending_closures() const {
+    return this->pending.load();
+}
+
+std::size_t ThreadPoolExecutor::num_threads() const noexcept {
+    return this->workers.size();
+}
+
+ThreadPoolExecutor::Stats ThreadPoolExecutor::stats() const {
+    auto stats = Stats{};
+    {
+        auto lck = std::unique_lock<std::mutex>{this->injection_mtx};
+        stats.queued = this->injection.size();
+    }
+    stats.pending = this->pending.load();
+    stats.capacity = this->capacity;
+    stats.rejected = this->rejected.load(std::memory_order_relaxed);
+    stats.dropped = this->dropped.load(std::memory_order_relaxed);
+    stats.ran_inline = this->ran_inline.load(std::memory_order_relaxed);
+    stats.blocked = this->blocked.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ThreadPoolExecutor::shutdown() {
+    assert(current_pool != this);
+    std::call_once(this->joined, [this]() {
+        {
+            // set the flag under both locks, the injection lock to fence off
+            // external adders and the sleep lock to not miss a sleeping
+            // worker that is about to check the flag
+            auto lck_injection = std::unique_lock<std::mutex>{
+                this->injection_mtx};
+            auto lck_sleep = std::unique_lock<std::mutex>{this->sleep_mtx};
+            this->stopping.store(true);
+        }
+        this->sleep_cv.notify_all();
+        this->space_cv.notify_all();
+
+        for (auto& worker : this->workers) {
+            worker->thread.join();
+        }
+    });
+}
+
+void ThreadPoolExecutor::run(std::size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+        auto task = Task{};
+        if (this->find_task(index, task)) {
+            this->pending.fetch_sub(1);
+            task();
+            continue;
+        }
+
+        if (!this->wait_for_work()) {
+            break;
+        }
+    }
+
+    current_pool = nullptr;
+}
+
+bool ThreadPoolExecutor::find_task(std::size_t index, Task& task) {
+    return this->workers[index]->deque.pop(task)
+        || this->pop_injected(task)
+        || this->steal(index, task);
+}
+
+bool ThreadPoolExecutor::pop_injected(Task& task) {
+    auto lck = std::unique_lock<std::mutex>{this->injection_mtx};
+    if (this->injection.empty()) {
+        return false;
+    }
+    task = std::move(this->injection.front());
+    this->injection.pop_front();
+
+    // there is room for a producer blocked on a full queue now
+    if (this->waiting_producers) {
+        lck.unlock();
+        this->space_cv.notify_one();
+    }
+    return true;
+}
+
+void ThreadPoolExecutor::check_stopping() const {
+    if (this->stopping.load()) {
+        throw std::logic_error{"sharp::ThreadPoolExecutor::add() called "
+            "after shutdown()"};
+    }
+}
+
+bool ThreadPoolExecutor::steal(std::size_t index, Task& task) {
+    thread_local auto engine = std::minstd_rand{std::random_device{}()};
+
+    // sweep through all the other workers starting at a random victim, a
+    // failed steal might just mean that another thief won the race, so
+    // sweep once more if anything looked non empty
+    auto size = this->workers.size();
+    auto start = std::uniform_int_distribution<std::size_t>{0, size - 1}(
+            engine);
+    for (auto attempt = 0; attempt < 2; ++attempt) {
+        auto saw_work = false;
+        for (auto i = std::size_t{0}; i < size; ++i) {
+            auto victim = (start + i) % size;
+            if (victim == index) {
+                continue;
+            }
+
+            auto& deque = this->workers[victim]->deque;
+            if (deque.steal(task)) {
+                return true;
+            }
+            saw_work = saw_work || deque.size();
+        }
+
+        if (!saw_work) {
+            break;
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPoolExecutor::wait_for_work() {
+    auto lck = std::unique_lock<std::mutex>{this->sleep_mtx};
+    this->sleepers.fetch_add(1);
+    while (!this->pending.load()) {
+        if (this->stopping.load()) {
+            this->sleepers.fetch_sub(1);
+
+            // wake up someone else so the shutdown propagates to everyone
+            lck.unlock();
+            this->sleep_cv.notify_all();
+            return false;
+        }
+        this->sleep_cv.wait(lck);
+    }
+    this->sleepers.fetch_sub(1);
+    return true;
+}
+
+void ThreadPoolExecutor::notify_one() {
+    if (this->sleepers.load()) {
+        // acquiring the lock here orders this notification after a worker
+        // that incremented sleepers has actually gone to sleep
+        { auto lck = std::unique_lock<std::mutex>{this->sleep_mtx}; }
+        this->sleep_cv.notify_one();
+    }
+}
+
+} // namespace sharp
@@ -0,0 +1,279 @@
+/**
+ * @file ThreadPoolExecutor.hpp
+ * @author Aaryaman Sagar
+ *
+ * A multi threaded implementation of the Executor interface that uses work
+ * stealing to balance closures across a fixed set of worker threads
+ */
+
+#pragma once
+
+#include <sharp/Executor/Executor.hpp>
+#include <sharp/Executor/detail/WorkStealingDeque.hpp>
+#include <sharp/Functional/Functional.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace sharp {
+
+/**
+ * @enum OverflowPolicy
+ *
+ * What a bounded executor does with a closure that is added while its queue
+ * is full
+ *
+ *      Block      - the adding thread waits till there is room
+ *      CallerRuns - the closure runs right away on the adding thread, which
+ *                   also slows the producer down to the rate it can run
+ *                   closures itself
+ *      Reject     - add() throws a RejectedExecution exception and the
+ *                   closure is destroyed without running
+ *      DropOldest - the closure that has been queued the longest is
+ *                   destroyed without running to make room
+ */
+enum class OverflowPolicy {
+    Block,
+    CallerRuns,
+    Reject,
+    DropOldest,
+};
+
+/**
+ * @class RejectedExecution
+ *
+ * Thrown by add() on a bounded executor with the Reject policy when its
+ * queue is full
+ */
+class RejectedExecution : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @class ThreadPoolExecutor
+ *
+ * Each worker thread owns a Chase-Lev deque, closures added from a worker
+ * thread (which is what happens when a continuation on a future schedules
+ * another continuation) are pushed onto that worker's own deque without any
+ * locking.  Closures added from threads outside the pool go into a shared
+ * injection queue that workers pick from when their own deque runs dry.
+ * Both hold the closures by value, so adding a closure that fits inline in
+ * a UniqueFunction does not allocate beyond the queues themselves
+ *
+ * A worker that has nothing to do first checks its own deque, then the
+ * injection queue and then tries to steal from the top of the deques of
+ * other workers, starting at a random victim.  Only when all of those come
+ * up empty does it go to sleep
+ *
+ *      auto executor = sharp::ThreadPoolExecutor{4};
+ *      future.via(&executor).then([](auto future) {
+ *          // runs on one of the four worker threads
+ *      });
+ *
+ * On destruction (or on an explicit call to shutdown()) the executor stops
+ * accepting closures from outside the pool, runs every closure that is still
+ * pending, including ones that are added by closures during the drain, and
+ * then joins all the worker threads
+ *
+ * Closures must not throw, an exception escaping a closure terminates the
+ * program just like an exception escaping a std::thread would
+ *
+ * The injection queue can be bounded, so that a burst of producers cannot
+ * grow the queue without limit.  What happens to closures added while the
+ * queue is full is decided by the overflow policy, and how often that
+ * happened can be read from stats()
+ *
+ *      // at most 10k closures wait in the queue, producers block beyond that
+ *      auto executor = sharp::ThreadPoolExecutor{
+ *          8, 10000, sharp::OverflowPolicy::Block};
+ *
+ * Only closures from outside the pool count towards the bound, closures
+ * added by closures running on the pool go to the worker's own deque as
+ * usual.  A worker waiting for room in a queue that only workers can empty
+ * could deadlock the pool.  The deques have a fixed size, and a worker whose
+ * deque is full puts closures in the injection queue without waiting for
+ * room, so those can take the queue past its bound for a while
+ */
+class ThreadPoolExecutor : public Executor {
+public:
+
+    /**
+     * Counters that describe the state of the executor, as with
+     * num_pending_closures() these are for monitoring and are stale as soon
+     * as they are returned
+     *
+     *      pending    - closures that have been added but not started yet
+     *      queued     - closures waiting in the injection queue
+     *      capacity   - the bound on the injection queue
+     *      rejected   - closures rejected with the Reject policy
+     *      dropped    - closures dropped with the DropOldest policy
+     *      ran_inline - closures run on the adding thread with the
+     *                   CallerRuns policy
+     *      blocked    - adds that had to wait with the Block policy
+     */
+    struct Stats {
+        std::size_t pending;
+        std::size_t queued;
+        std::size_t capacity;
+        std::size_t rejected;
+        std::size_t dropped;
+        std::size_t ran_inline;
+        std::size_t blocked;
+    };
+
+    /**
+     * Means that the injection queue has no bound
+     */
+    static constexpr auto UNBOUNDED = std::numeric_limits<std::size_t>::max();
+
+    /**
+     * Starts the given number of worker threads, if no number is given then
+     * one thread is started per hardware thread.  At most capacity closures
+     * from outside the pool wait in the injection queue, beyond that the
+     * overflow policy kicks in
+     */
+    explicit ThreadPoolExecutor(
+            int num_threads = std::thread::hardware_concurrency(),
+            std::size_t capacity = UNBOUNDED,
+            OverflowPolicy policy = OverflowPolicy::Block);
+
+    /**
+     * Drains the pending closures and joins the worker threads, see
+     * shutdown()
+     */
+    ~ThreadPoolExecutor() override;
+
+    /**
+     * Non copyable and non movable, the worker threads refer to the executor
+     * by address
+     */
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+    /**
+     * Schedules the closure on the pool, when called from one of the pool's
+     * own worker threads the closure goes onto that worker's local deque,
+     * otherwise it goes to the shared injection queue
+     *
+     * Throws a std::logic_error if called from outside the pool after
+     * shutdown() has been called, threads that are blocked waiting for room
+     * when shutdown() is called throw as well.  Throws RejectedExecution if
+     * the queue is full and the policy is Reject
+     */
+    void add(sharp::UniqueFunction<void()> closure) override;
+
+    /**
+     * Returns the number of closures that have been added but have not
+     * started executing yet
+     */
+    std::size_t num_pending_closures() const override;
+
+    /**
+     * Returns the number of worker threads in the pool
+     */
+    std::size_t num_threads() const noexcept;
+
+    /**
+     * Returns the counters described in Stats
+     */
+    Stats stats() const;
+
+    /**
+     * Stops accepting new closures from outside the pool, waits for all
+     * pending closures to finish and joins the worker threads.  Calling this
+     * more than once is fine, calling it from one of the worker threads is
+     * not
+     */
+    void shutdown();
+
+private:
+
+    using Task = sharp::UniqueFunction<void()>;
+
+    /**
+     * Per worker state, aligned to avoid false sharing between the deques of
+     * neighbouring workers
+     */
+    struct alignas(64) Worker {
+        detail::WorkStealingDeque<Task> deque;
+        std::thread thread;
+    };
+
+    /**
+     * The main loop for each worker thread
+     */
+    void run(std::size_t index);
+
+    /**
+     * Finds a closure to run for the worker at the given index, first from
+     * its own deque, then from the injection queue and then by stealing from
+     * other workers.  Returns false if nothing could be found
+     */
+    bool find_task(std::size_t index, Task& task);
+    bool pop_injected(Task& task);
+    bool steal(std::size_t index, Task& task);
+
+    /**
+     * Throws if the pool is shutting down, called with the injection lock held
+     */
+    void check_stopping() const;
+
+    /**
+     * Puts the worker to sleep until there is something pending, returns
+     * false if the worker should exit because the pool is shutting down and
+     * everything has been drained
+     */
+    bool wait_for_work();
+
+    /**
+     * Wakes up one sleeping worker if there is one
+     */
+    void notify_one();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /**
+     * The queue that closures from outside the pool go to, its bound and
+     * what to do when it is full.  Producers blocked on a full queue wait on
+     * the condition variable and workers that pop from the queue signal it
+     * when there is someone waiting
+     */
+    mutable std::mutex injection_mtx;
+    std::deque<Task> injection;
+    std::size_t capacity;
+    OverflowPolicy policy;
+    std::condition_variable space_cv;
+    std::size_t waiting_producers{0};
+
+    /**
+     * The overflow counters, atomic so that stats() can read them without
+     * the injection lock
+     */
+    std::atomic<std::size_t> rejected{0};
+    std::atomic<std::size_t> dropped{0};
+    std::atomic<std::size_t> ran_inline{0};
+    std::atomic<std::size_t> blocked{0};
+
+    /**
+     * Bookkeeping for sleeping workers, a worker increments sleepers before
+     * checking for pending work one final time, and adders check sleepers
+     * after incrementing pending, so one of the two always sees the other
+     */
+    alignas(64) std::atomic<std::size_t> pending{0};
+    alignas(64) std::atomic<int> sleepers{0};
+    std::mutex sleep_mtx;
+    std::condition_variable sleep_cv;
+    std::atomic<bool> stopping{false};
+    std::once_flag joined;
+};
+
+} // namespace sharp
@@ -0,0 +1,55 @@
+/**
+ * @file TimedExecutor.hpp
+ * @author Aaryaman Sagar
+ *
+ * An executor that can also be asked to run closures at some point in time
+ * rather than as soon as possible
+ */
+
+#pragma once
+
+#include <sharp/Executor/Executor.hpp>
+#include <sharp/Functional/Functional.hpp>
+
+#include <chrono>
+#include <utility>
+
+namespace sharp {
+
+/**
+ * @class TimedExecutor
+ *
+ * Closures added with add_at() and add_after() run no earlier than the given
+ * time, but how much later than that depends on the implementation, timers
+ * usually round deadlines up to some granularity to keep things cheap
+ *
+ *      auto timer = sharp::TimingWheelExecutor{&pool};
+ *      timer.add_after(std::chrono::milliseconds{100}, []() {
+ *          // runs on the pool after at least a hundred milliseconds
+ *      });
+ */
+class TimedExecutor : public Executor {
+public:
+
+    /**
+     * The clock deadlines are measured against, a steady clock so that
+     * changes to the wall clock do not fire or delay timers
+     */
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Schedules the closure to run at or after the given point in time
+     */
+    virtual void add_at(Clock::time_point deadline,
+                        sharp::UniqueFunction<void()> closure) = 0;
+
+    /**
+     * Schedules the closure to run once the given duration has passed
+     */
+    void add_after(Clock::duration duration,
+                   sharp::UniqueFunction<void()> closure) {
+        this->add_at(Clock::now() + duration, std::move(closure));
+    }
+};
+
+} // namespace sharp
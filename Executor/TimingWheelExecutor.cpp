@@ -0,0 +1,111 @@
+#include <sharp/Executor/TimingWheelExecutor.hpp>
+#include <sharp/Threads/ParkingLot.hpp>
+
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace sharp {
+
+TimingWheelExecutor::TimingWheelExecutor(Executor* target_in,
+                                         Clock::duration tick_in)
+        : target{target_in}, tick{tick_in}, start{Clock::now()} {
+    assert(this->target);
+    assert(this->tick.count() > 0);
+    this->timer = std::thread{[this]() { this->run(); }};
+}
+
+TimingWheelExecutor::~TimingWheelExecutor() {
+    // the timer thread checks the flag with the parking lot bucket locked
+    // before it parks, so it either sees the flag or gets unparked
+    this->stopping.store(true);
+    sharp::unpark_one(&this->wake_tick);
+    this->timer.join();
+}
+
+void TimingWheelExecutor::add(sharp::UniqueFunction<void()> closure) {
+    this->target->add(std::move(closure));
+}
+
+void TimingWheelExecutor::add_at(Clock::time_point deadline,
+                                 sharp::UniqueFunction<void()> closure) {
+    if (this->stopping.load(std::memory_order_relaxed)) {
+        throw std::logic_error{"sharp::TimingWheelExecutor::add_at() called "
+            "during destruction"};
+    }
+
+    auto tick = this->deadline_tick(deadline);
+    this->pending.fetch_add(1, std::memory_order_relaxed);
+    this->incoming.push(Timer{tick, std::move(closure)});
+    this->pushed.fetch_add(1);
+
+    // the timer thread is only woken up if it is going to sleep past the new
+    // timer, this is zero while it is awake
+    if (tick < this->wake_tick.load()) {
+        sharp::unpark_one(&this->wake_tick);
+    }
+}
+
+std::size_t TimingWheelExecutor::num_pending_closures() const {
+    return this->pending.load(std::memory_order_relaxed);
+}
+
+TimingWheelExecutor* TimingWheelExecutor::get() {
+    static TimingWheelExecutor executor;
+    return &executor;
+}
+
+void TimingWheelExecutor::run() {
+    auto consumed = std::uint64_t{0};
+    auto fire = [this](Task closure) {
+        this->pending.fetch_sub(1, std::memory_order_relaxed);
+        this->target->add(std::move(closure));
+    };
+
+    while (!this->stopping.load()) {
+        auto added = Timer{};
+        while (this->incoming.pop(added)) {
+            ++consumed;
+            this->wheel.insert(added.tick, std::move(added.closure));
+        }
+        this->wheel.advance(this->current_tick(), fire);
+
+        // publish the tick to sleep till and then check for timers that
+        // were added after the queue was drained, an adder that increments
+        // the count after this check sees the tick and wakes this thread up
+        // if its timer expires sooner
+        auto next = this->wheel.next_tick();
+        this->wake_tick.store(next);
+        auto validate = [this, consumed]() {
+            return this->pushed.load() <= consumed && !this->stopping.load();
+        };
+        if (next == std::numeric_limits<std::uint64_t>::max()) {
+            sharp::park(&this->wake_tick, validate);
+        } else {
+            sharp::park_until(&this->wake_tick, validate,
+                              this->tick_time(next));
+        }
+        this->wake_tick.store(0);
+    }
+}
+
+std::uint64_t TimingWheelExecutor::deadline_tick(
+        Clock::time_point deadline) const {
+    if (deadline <= this->start) {
+        return 0;
+    }
+    auto elapsed = deadline - this->start;
+    return (elapsed / this->tick) + ((elapsed % this->tick).count() != 0);
+}
+
+std::uint64_t TimingWheelExecutor::current_tick() const {
+    return (Clock::now() - this->start) / this->tick;
+}
+
+TimedExecutor::Clock::time_point TimingWheelExecutor::tick_time(
+        std::uint64_t tick) const {
+    return this->start + this->tick * static_cast<Clock::rep>(tick);
+}
+
+} // namespace sharp
@@ -0,0 +1,146 @@
+/**
+ * @file TimingWheelExecutor.hpp
+ * @author Aaryaman Sagar
+ *
+ * A timed executor backed by a hierarchical timing wheel on a single timer
+ * thread.  Adding a timer and firing one are constant time operations, so
+ * this scales to very large numbers of short lived timeouts where a heap of
+ * timers would spend most of its time rebalancing
+ */
+
+#pragma once
+
+#include <sharp/Executor/InlineExecutor.hpp>
+#include <sharp/Executor/TimedExecutor.hpp>
+#include <sharp/Executor/detail/MpscQueue.hpp>
+#include <sharp/Executor/detail/TimingWheel.hpp>
+#include <sharp/Functional/Functional.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace sharp {
+
+/**
+ * @class TimingWheelExecutor
+ *
+ * Time is divided into ticks of a fixed length and timers are kept in a
+ * timing wheel that only the timer thread touches.  Threads that add timers
+ * push them onto a lock free queue and only wake the timer thread if the new
+ * timer expires before the tick the timer thread is sleeping till, the timer
+ * thread moves them into the wheel when it wakes up.  When a timer expires
+ * its closure is added to the target executor, which by default is the
+ * inline executor so closures run on the timer thread itself
+ *
+ *      auto pool = sharp::ThreadPoolExecutor{4};
+ *      auto timer = sharp::TimingWheelExecutor{&pool};
+ *      timer.add_after(std::chrono::seconds{1}, []() {
+ *          // runs on the pool once a second has passed
+ *      });
+ *
+ * Deadlines are rounded up to the next tick, so a closure never runs before
+ * its deadline but can run up to a tick (plus scheduling delays) after it.
+ * The target executor has to outlive the timer executor
+ *
+ * On destruction the timer thread is stopped and joined, closures whose
+ * timers have not expired yet are destroyed without being run
+ */
+class TimingWheelExecutor : public TimedExecutor {
+public:
+
+    /**
+     * Starts the timer thread, expired closures are added to the target
+     * executor and deadlines are rounded up to multiples of the tick
+     */
+    explicit TimingWheelExecutor(
+            Executor* target = InlineExecutor::get(),
+            Clock::duration tick = std::chrono::milliseconds{1});
+
+    /**
+     * Stops and joins the timer thread
+     */
+    ~TimingWheelExecutor() override;
+
+    /**
+     * Non copyable and non movable, the timer thread refers to the executor
+     * by address
+     */
+    TimingWheelExecutor(const TimingWheelExecutor&) = delete;
+    TimingWheelExecutor& operator=(const TimingWheelExecutor&) = delete;
+
+    /**
+     * Adds the closure straight to the target executor
+     */
+    void add(sharp::UniqueFunction<void()> closure) override;
+
+    /**
+     * Schedules the closure to be added to the target executor once the
+     * deadline has passed
+     */
+    void add_at(Clock::time_point deadline,
+                sharp::UniqueFunction<void()> closure) override;
+
+    /**
+     * Returns the number of timers that have not expired yet
+     */
+    std::size_t num_pending_closures() const override;
+
+    /**
+     * Returns the process wide timer executor, which runs expired closures
+     * inline on its timer thread.  Closures run there should be short and
+     * should hand off anything expensive to another executor
+     */
+    static TimingWheelExecutor* get();
+
+private:
+
+    using Task = sharp::UniqueFunction<void()>;
+
+    struct Timer {
+        std::uint64_t tick;
+        Task closure;
+    };
+
+    /**
+     * The main loop of the timer thread
+     */
+    void run();
+
+    /**
+     * Conversions between points in time and ticks, a deadline goes to the
+     * first tick at or after it and the current time goes to the last tick
+     * at or before it
+     */
+    std::uint64_t deadline_tick(Clock::time_point deadline) const;
+    std::uint64_t current_tick() const;
+    Clock::time_point tick_time(std::uint64_t tick) const;
+
+    Executor* target;
+    Clock::duration tick;
+    Clock::time_point start;
+
+    /**
+     * Timers that have been added but not moved into the wheel yet, and the
+     * number of timers ever pushed onto the queue.  The timer thread checks
+     * the count after publishing the tick it is going to sleep till and
+     * adders check that tick after incrementing the count, so either the
+     * timer thread sees a new timer or the adder sees that it has to wake
+     * the timer thread up
+     */
+    detail::MpscQueue<Timer> incoming;
+    alignas(64) std::atomic<std::uint64_t> pushed{0};
+    alignas(64) std::atomic<std::uint64_t> wake_tick{0};
+    std::atomic<std::size_t> pending{0};
+    std::atomic<bool> stopping{false};
+
+    /**
+     * Only touched by the timer thread
+     */
+    detail::TimingWheel<Task> wheel;
+    std::thread timer;
+};
+
+} // namespace sharp
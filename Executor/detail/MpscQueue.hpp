@@ -0,0 +1,98 @@
+/**
+ * @file MpscQueue.hpp
+ * @author Aaryaman Sagar
+ *
+ * An unbounded intrusive multi producer single consumer queue as described by
+ * Dmitry Vyukov.  Producers push with a single exchange and never wait for
+ * each other or for the consumer, and the consumer pops without any
+ * read-modify-write operations
+ */
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace sharp {
+namespace detail {
+
+    /**
+     * @class MpscQueue
+     *
+     * The queue is a singly linked list from the oldest element to the
+     * newest, the consumer owns the head and producers swap themselves in as
+     * the tail and then link the previous tail to themselves.  The head is
+     * always a node whose element has already been consumed (or a stub for
+     * an empty queue), the first element is the one after it
+     *
+     * A producer that has swapped itself in as the tail but has not linked
+     * the previous tail to itself yet makes the queue look empty to the
+     * consumer from that node onwards, pop() returns false in that case.
+     * Callers that know that an element is in the queue, because they count
+     * elements separately, should retry
+     */
+    template <typename Type>
+    class MpscQueue {
+    public:
+
+        MpscQueue() : head{new Node{}}, tail{head} {}
+        ~MpscQueue() {
+            while (this->head) {
+                auto next = this->head->next.load(std::memory_order_relaxed);
+                delete this->head;
+                this->head = next;
+            }
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        /**
+         * Push an element to the back of the queue, this can be called from
+         * any thread
+         */
+        void push(Type item) {
+            auto node = new Node{std::move(item)};
+            auto previous = this->tail.exchange(node,
+                                                std::memory_order_acq_rel);
+            previous->next.store(node, std::memory_order_release);
+        }
+
+        /**
+         * Pop an element from the front of the queue, this can only be
+         * called from one thread at a time.  Returns false if the queue was
+         * empty or if the next element is still being linked in
+         */
+        bool pop(Type& item) {
+            auto next = this->head->next.load(std::memory_order_acquire);
+            if (!next) {
+                return false;
+            }
+
+            // the popped node becomes the new head, its element is moved out
+            // and the old head is freed
+            item = std::move(next->item);
+            delete this->head;
+            this->head = next;
+            return true;
+        }
+
+    private:
+        struct Node {
+            Node() = default;
+            explicit Node(Type item_in) : item{std::move(item_in)} {}
+
+            std::atomic<Node*> next{nullptr};
+            Type item;
+        };
+
+        /**
+         * The head is only touched by the consumer, and the tail is on a
+         * cache line of its own since every producer writes to it
+         */
+        Node* head;
+        alignas(64) std::atomic<Node*> tail;
+    };
+
+} // namespace detail
+} // namespace sharp
@@ -0,0 +1,236 @@
+/**
+ * @file TimingWheel.hpp
+ * @author Aaryaman Sagar
+ *
+ * A hierarchical timing wheel as described by Varghese and Lauck.  Time is
+ * measured in ticks, inserting an element and expiring one are both constant
+ * time no matter how many elements there are
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace sharp {
+namespace detail {
+
+    /**
+     * @class TimingWheel
+     *
+     * The wheel has a number of levels, each with a fixed number of slots.
+     * A slot on the first level covers one tick, a slot on the second level
+     * covers as many ticks as the whole first level and so on.  An element
+     * goes on the lowest level that can hold its deadline, and when the
+     * first level wraps around the next slot of the level above is emptied
+     * and its elements are inserted again one level closer to the first.  By
+     * the time an element's tick comes around it is on the first level in
+     * the slot for that tick
+     *
+     * Elements that are further away than the whole wheel covers go in the
+     * furthest slot on the last level and make their way back there till they
+     * are close enough
+     *
+     * The wheel is not thread safe, it is meant to be owned by one timer
+     * thread
+     */
+    template <typename Type>
+    class TimingWheel {
+    public:
+
+        /**
+         * The wheel starts at the given tick
+         */
+        explicit TimingWheel(std::uint64_t current_in = 0)
+            : current_tick{current_in} {}
+
+        /**
+         * Insert an element to expire at the given tick.  Ticks that have
+         * already been reached expire on the next tick
+         */
+        void insert(std::uint64_t tick, Type element);
+
+        /**
+         * Advances the wheel up to and including the given tick, calling the
+         * function with every element that expires in the order of the ticks
+         * they expire at
+         */
+        template <typename Func>
+        void advance(std::uint64_t tick, Func func);
+
+        /**
+         * Returns the earliest tick at which advance() has something to do,
+         * this is either the tick an element expires at or the tick at which
+         * elements have to be moved down from a higher level.  Returns the
+         * maximum tick if the wheel is empty
+         */
+        std::uint64_t next_tick() const;
+
+        /**
+         * The tick the wheel has been advanced to
+         */
+        std::uint64_t current() const {
+            return this->current_tick;
+        }
+
+        /**
+         * The number of elements in the wheel
+         */
+        std::size_t size() const {
+            return this->num_elements;
+        }
+
+    private:
+
+        static constexpr auto SLOT_BITS = 8;
+        static constexpr auto SLOTS = std::size_t{1} << SLOT_BITS;
+        static constexpr auto LEVELS = 4;
+
+        struct Entry {
+            std::uint64_t tick;
+            Type element;
+        };
+
+        /**
+         * Each slot is a vector so that firing and cascading a slot reuses
+         * the memory it already has instead of allocating per element
+         */
+        using Slot = std::vector<Entry>;
+
+        void insert(Entry entry);
+        void cascade(int level);
+
+        std::uint64_t current_tick;
+        std::size_t num_elements{0};
+        std::array<std::array<Slot, SLOTS>, LEVELS> levels;
+    };
+
+    template <typename Type>
+    void TimingWheel<Type>::insert(std::uint64_t tick, Type element) {
+        ++this->num_elements;
+        tick = std::max(tick, this->current_tick + 1);
+        this->insert(Entry{tick, std::move(element)});
+    }
+
+    template <typename Type>
+    void TimingWheel<Type>::insert(Entry entry) {
+        // find the lowest level that covers the distance to the tick, the
+        // slot on that level is picked by the absolute tick so slots line up
+        // with the moment the level below wraps around
+        auto distance = entry.tick - this->current_tick;
+        for (auto level = 0; level < LEVELS; ++level) {
+            auto span = std::uint64_t{1} << (SLOT_BITS * (level + 1));
+            if (distance < span) {
+                auto shift = SLOT_BITS * level;
+                auto slot = (entry.tick >> shift) & (SLOTS - 1);
+                this->levels[level][slot].push_back(std::move(entry));
+                return;
+            }
+        }
+
+        // too far out for the wheel, park it in the slot right behind the
+        // current one on the last level, which is the last to come around
+        auto shift = SLOT_BITS * (LEVELS - 1);
+        auto slot = ((this->current_tick >> shift) - 1) & (SLOTS - 1);
+        this->levels[LEVELS - 1][slot].push_back(std::move(entry));
+    }
+
+    template <typename Type>
+    void TimingWheel<Type>::cascade(int level) {
+        auto shift = SLOT_BITS * level;
+        auto slot = (this->current_tick >> shift) & (SLOTS - 1);
+        auto entries = Slot{};
+        std::swap(entries, this->levels[level][slot]);
+        for (auto& entry : entries) {
+            this->insert(std::move(entry));
+        }
+
+        // elements that expire on the current tick were moved to the slot on
+        // the first level that is about to fire, hand the memory back so the
+        // slot does not allocate next time
+        entries.clear();
+        if (this->levels[level][slot].empty()) {
+            std::swap(entries, this->levels[level][slot]);
+        }
+    }
+
+    template <typename Type>
+    template <typename Func>
+    void TimingWheel<Type>::advance(std::uint64_t tick, Func func) {
+        while (this->current_tick < tick) {
+
+            // skip straight to the next tick that has something to do, the
+            // ticks in between have nothing to expire or move down
+            auto next = this->next_tick();
+            if (next > tick) {
+                this->current_tick = tick;
+                return;
+            }
+            this->current_tick = next;
+
+            // when a level wraps around the next slot on the level above is
+            // moved down, highest level first so that elements moved down
+            // more than one level end up in the right place
+            auto wrapped = 0;
+            while (wrapped + 1 < LEVELS) {
+                auto shift = SLOT_BITS * (wrapped + 1);
+                if (this->current_tick & ((std::uint64_t{1} << shift) - 1)) {
+                    break;
+                }
+                ++wrapped;
+            }
+            for (auto level = wrapped; level > 0; --level) {
+                this->cascade(level);
+            }
+
+            auto& slot = this->levels[0][this->current_tick & (SLOTS - 1)];
+            if (slot.empty()) {
+                continue;
+            }
+            auto entries = Slot{};
+            std::swap(entries, slot);
+            this->num_elements -= entries.size();
+            for (auto& entry : entries) {
+                func(std::move(entry.element));
+            }
+            entries.clear();
+            if (slot.empty()) {
+                std::swap(entries, slot);
+            }
+        }
+    }
+
+    template <typename Type>
+    std::uint64_t TimingWheel<Type>::next_tick() const {
+        if (!this->num_elements) {
+            return std::numeric_limits<std::uint64_t>::max();
+        }
+
+        // the first non empty slot on each level is either the tick an
+        // element expires at on the first level or the tick a slot on a
+        // higher level is moved down.  Higher levels only need to be looked
+        // at if their next slot could come around before what has been found
+        auto next = std::numeric_limits<std::uint64_t>::max();
+        for (auto level = 0; level < LEVELS; ++level) {
+            auto shift = SLOT_BITS * level;
+            auto base = this->current_tick >> shift;
+            if (((base + 1) << shift) >= next) {
+                break;
+            }
+            for (auto i = std::uint64_t{1}; i <= SLOTS; ++i) {
+                if (!this->levels[level][(base + i) & (SLOTS - 1)].empty()) {
+                    next = std::min(next, (base + i) << shift);
+                    break;
+                }
+            }
+        }
+        return next;
+    }
+
+} // namespace detail
+} // namespace sharp
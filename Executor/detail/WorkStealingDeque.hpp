@@ -0,0 +1,224 @@
+/**
+ * @file WorkStealingDeque.hpp
+ * @author Aaryaman Sagar
+ *
+ * An implementation of the Chase-Lev work stealing deque as described in
+ * "Dynamic Circular Work-Stealing Deque" by David Chase and Yossi Lev, with
+ * the memory orderings from "Correct and Efficient Work-Stealing for Weak
+ * Memory Models" by Le, Pop, Cohen and Zappa Nardelli
+ *
+ * The owner thread pushes and pops from the bottom of the deque without any
+ * read-modify-write operations in the common case, and other threads steal
+ * from the top of the deque with a single compare and swap.  This is the
+ * building block of the work stealing executors in this module
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sharp {
+namespace detail {
+
+    /**
+     * @class WorkStealingDeque
+     *
+     * Elements are stored by value in a fixed size circular array, so the
+     * closures of an executor can go in the deque without a heap allocation
+     * each.  Classic implementations store pointers and have thieves read
+     * the element before their compare and swap, which does not work for
+     * types that cannot be copied bitwise.  Here the element is only moved
+     * out by whoever wins the race for it, and each slot has a sequence
+     * number that says when the element that was in it has been moved out,
+     * so the owner never constructs an element in a slot that a thief is
+     * still reading from
+     *
+     * The array does not grow, growing would mean moving elements that
+     * thieves might be in the middle of moving out.  push() returns false
+     * when the deque is full and the caller is expected to put the element
+     * somewhere else, like a shared queue
+     */
+    template <typename Type>
+    class WorkStealingDeque {
+    public:
+        static_assert(std::is_nothrow_move_constructible<Type>::value
+                && std::is_nothrow_move_assignable<Type>::value,
+                "WorkStealingDeque needs elements that move without throwing");
+
+        explicit WorkStealingDeque(std::size_t capacity = 256)
+                : mask{round_up(capacity) - 1},
+                  slots{new Slot[this->mask + 1]} {
+            for (auto i = std::size_t{0}; i <= this->mask; ++i) {
+                this->slots[i].sequence.store(static_cast<std::int64_t>(i),
+                        std::memory_order_relaxed);
+            }
+        }
+
+        ~WorkStealingDeque() {
+            auto b = this->bottom.load(std::memory_order_relaxed);
+            for (auto i = this->top.load(std::memory_order_relaxed); i < b;
+                    ++i) {
+                this->element(i).~Type();
+            }
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        /**
+         * Push an element to the bottom of the deque, this can only be
+         * called from the thread that owns the deque.  Returns false and
+         * leaves the element alone if the deque is full
+         */
+        bool push(Type&& item) {
+            auto b = this->bottom.load(std::memory_order_relaxed);
+
+            // the slot is free once the element from the previous lap has
+            // been moved out, which also covers the deque being full
+            auto& slot = this->slots[b & this->mask];
+            if (slot.sequence.load(std::memory_order_acquire) != b) {
+                return false;
+            }
+
+            // the release publishes the element to thieves that see the new
+            // bottom
+            new (&slot.storage) Type(std::move(item));
+            this->bottom.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Pop an element from the bottom of the deque, this can only be
+         * called from the thread that owns the deque.  Returns false if the
+         * deque was empty or if the last element was stolen from under us
+         */
+        bool pop(Type& item) {
+            auto b = this->bottom.load(std::memory_order_relaxed) - 1;
+            this->bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = this->top.load(std::memory_order_relaxed);
+
+            // the deque was empty, restore the bottom index
+            if (t > b) {
+                this->bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            // there is more than one element, no thief can get to this one.
+            // The next push goes to the same index
+            if (t < b) {
+                this->take(b, item, b);
+                return true;
+            }
+
+            // this is the last element, race against thieves for it, either
+            // way top and bottom end up past it and the slot is next used a
+            // lap later
+            auto won = this->top.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed);
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+            if (won) {
+                this->take(b, item, b + this->capacity());
+            }
+            return won;
+        }
+
+        /**
+         * Steal an element from the top of the deque, this can be called
+         * from any thread.  Returns false if the deque was empty or if
+         * another thread won the race for the top element
+         */
+        bool steal(Type& item) {
+            auto t = this->top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto b = this->bottom.load(std::memory_order_acquire);
+
+            if (t >= b) {
+                return false;
+            }
+
+            // the element is only read once it is ours, the owner does not
+            // reuse the slot till take() marks it free
+            if (!this->top.compare_exchange_strong(t, t + 1,
+                        std::memory_order_seq_cst,
+                        std::memory_order_relaxed)) {
+                return false;
+            }
+            this->take(t, item, t + this->capacity());
+            return true;
+        }
+
+        /**
+         * Returns an estimate of the number of elements in the deque, this
+         * is only exact when called from the owning thread with no thieves
+         * around
+         */
+        std::size_t size() const noexcept {
+            auto b = this->bottom.load(std::memory_order_relaxed);
+            auto t = this->top.load(std::memory_order_relaxed);
+            return (b > t) ? static_cast<std::size_t>(b - t) : 0;
+        }
+
+    private:
+
+        using Storage = std::aligned_storage_t<sizeof(Type), alignof(Type)>;
+
+        /**
+         * A slot in the array.  The sequence number is equal to the index
+         * the slot is next pushed to once the element that was in it has
+         * been moved out, that is the same index when the owner popped it
+         * and the index a lap later when it was taken from the top
+         */
+        struct Slot {
+            std::atomic<std::int64_t> sequence;
+            Storage storage;
+        };
+
+        Type& element(std::int64_t index) noexcept {
+            return reinterpret_cast<Type&>(this->slots[index & this->mask]
+                    .storage);
+        }
+
+        std::int64_t capacity() const noexcept {
+            return static_cast<std::int64_t>(this->mask + 1);
+        }
+
+        /**
+         * Move the element at an index that has been claimed out and free
+         * the slot for the index it is next pushed to
+         */
+        void take(std::int64_t index, Type& item, std::int64_t next) noexcept {
+            auto& value = this->element(index);
+            item = std::move(value);
+            value.~Type();
+            this->slots[index & this->mask].sequence.store(next,
+                    std::memory_order_release);
+        }
+
+        static std::size_t round_up(std::size_t capacity) {
+            auto rounded = std::size_t{1};
+            while (rounded < capacity) {
+                rounded *= 2;
+            }
+            return rounded;
+        }
+
+        /**
+         * The top and bottom indices are on different cache lines, top is
+         * written to by thieves and bottom is written to only by the owner
+         */
+        alignas(64) std::atomic<std::int64_t> top{0};
+        alignas(64) std::atomic<std::int64_t> bottom{0};
+        alignas(64) const std::size_t mask;
+        const std::unique_ptr<Slot[]> slots;
+    };
+
+} // namespace detail
+} // namespace sharp
@@ -0,0 +1,668 @@
+#include <sharp/Executor/Executor.hpp>
+#include <sharp/Executor/PriorityThreadPoolExecutor.hpp>
+#include <sharp/Executor/SerialExecutor.hpp>
+#include <sharp/Executor/ThreadPoolExecutor.hpp>
+#include <sharp/Executor/TimingWheelExecutor.hpp>
+#include <sharp/Executor/detail/MpscQueue.hpp>
+#include <sharp/Executor/detail/TimingWheel.hpp>
+#include <sharp/Executor/detail/WorkStealingDeque.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace {
+const auto STRESS = 1e4;
+} // namespace anonymous
+
+TEST(Executor, InlineExecutorBasic) {
+    auto executed = false;
+    sharp::InlineExecutor::get()->add([&]() { executed = true; });
+    EXPECT_TRUE(executed);
+    EXPECT_EQ(sharp::InlineExecutor::get()->num_pending_closures(), 0);
+}
+
+TEST(Executor, WorkStealingDequeOwner) {
+    sharp::detail::WorkStealingDeque<int*> deque{100};
+    auto values = std::vector<int>(100);
+    for (auto& value : values) {
+        EXPECT_TRUE(deque.push(&value));
+    }
+    EXPECT_EQ(deque.size(), 100);
+
+    // the owner pops in LIFO order and thieves steal in FIFO order
+    auto item = static_cast<int*>(nullptr);
+    EXPECT_TRUE(deque.pop(item));
+    EXPECT_EQ(item, &values.back());
+    EXPECT_TRUE(deque.steal(item));
+    EXPECT_EQ(item, &values.front());
+}
+
+TEST(Executor, WorkStealingDequeFull) {
+    // the deque holds elements by value and does not grow, a push to a full
+    // deque leaves the element alone
+    sharp::detail::WorkStealingDeque<std::unique_ptr<int>> deque{2};
+    EXPECT_TRUE(deque.push(std::make_unique<int>(1)));
+    EXPECT_TRUE(deque.push(std::make_unique<int>(2)));
+    auto three = std::make_unique<int>(3);
+    EXPECT_FALSE(deque.push(std::move(three)));
+    EXPECT_TRUE(three);
+
+    // a slot is free again once its element has been taken out
+    auto item = std::unique_ptr<int>{};
+    EXPECT_TRUE(deque.steal(item));
+    EXPECT_EQ(*item, 1);
+    EXPECT_TRUE(deque.push(std::move(three)));
+    EXPECT_TRUE(deque.pop(item));
+    EXPECT_EQ(*item, 3);
+
+    // elements left in the deque are destroyed with it
+    auto resource = std::make_shared<int>(0);
+    {
+        sharp::detail::WorkStealingDeque<std::shared_ptr<int>> other{4};
+        EXPECT_TRUE(other.push(std::shared_ptr<int>{resource}));
+        EXPECT_EQ(resource.use_count(), 2);
+    }
+    EXPECT_EQ(resource.use_count(), 1);
+}
+
+TEST(Executor, WorkStealingDequeConcurrentSteal) {
+    sharp::detail::WorkStealingDeque<int*> deque;
+    auto values = std::vector<int>(static_cast<int>(STRESS));
+    std::vector<std::atomic<int>> seen(values.size());
+    std::atomic<bool> done{false};
+
+    auto thieves = std::vector<std::thread>{};
+    for (auto i = 0; i < 3; ++i) {
+        thieves.emplace_back([&]() {
+            auto item = static_cast<int*>(nullptr);
+            while (!done.load() || deque.size()) {
+                if (deque.steal(item)) {
+                    ++seen[item - values.data()];
+                }
+            }
+        });
+    }
+
+    // interleave pushes and pops on the owner side, the thieves make room
+    // when the deque is full
+    for (auto i = std::size_t{0}; i < values.size(); ++i) {
+        while (!deque.push(&values[i])) {
+            std::this_thread::yield();
+        }
+        auto item = static_cast<int*>(nullptr);
+        if ((i % 3 == 0) && deque.pop(item)) {
+            ++seen[item - values.data()];
+        }
+    }
+    done.store(true);
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    // every element was taken exactly once
+    for (auto& count : seen) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
+TEST(Executor, ThreadPoolExecutorBasic) {
+    std::atomic<int> counter{0};
+    {
+        sharp::ThreadPoolExecutor executor{4};
+        EXPECT_EQ(executor.num_threads(), 4);
+        for (auto i = 0; i < STRESS; ++i) {
+            executor.add([&]() { ++counter; });
+        }
+    }
+    EXPECT_EQ(counter.load(), STRESS);
+}
+
+TEST(Executor, ThreadPoolExecutorNested) {
+    // closures that add closures go to the worker's local deque and get
+    // drained on shutdown along with everything else
+    std::atomic<int> counter{0};
+    auto threads = std::set<std::thread::id>{};
+    std::mutex mtx;
+    {
+        sharp::ThreadPoolExecutor executor{4};
+        for (auto i = 0; i < 100; ++i) {
+            executor.add([&]() {
+                for (auto j = 0; j < 100; ++j) {
+                    executor.add([&]() {
+                        ++counter;
+                        auto lck = std::unique_lock<std::mutex>{mtx};
+                        threads.insert(std::this_thread::get_id());
+                    });
+                }
+            });
+        }
+    }
+    EXPECT_EQ(counter.load(), 100 * 100);
+    EXPECT_LE(threads.size(), 4);
+}
+
+TEST(Executor, ThreadPoolExecutorPending) {
+    sharp::ThreadPoolExecutor executor{1};
+    std::atomic<bool> go{false};
+    executor.add([&]() {
+        while (!go.load()) {
+            std::this_thread::yield();
+        }
+    });
+    for (auto i = 0; i < 10; ++i) {
+        executor.add([]() {});
+    }
+    EXPECT_GE(executor.num_pending_closures(), 10);
+    go.store(true);
+    executor.shutdown();
+    EXPECT_EQ(executor.num_pending_closures(), 0);
+
+    try {
+        executor.add([]() {});
+        EXPECT_TRUE(false);
+    } catch (std::logic_error&) {}
+}
+
+TEST(Executor, MpscQueueConcurrentPush) {
+    sharp::detail::MpscQueue<int> queue;
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < 4; ++i) {
+        threads.emplace_back([&queue, i]() {
+            for (auto j = 0; j < STRESS; ++j) {
+                queue.push(i * STRESS + j);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // elements from one producer come out in the order they were pushed
+    auto last = std::vector<int>(4, -1);
+    auto element = 0;
+    for (auto i = 0; i < 4 * STRESS; ++i) {
+        EXPECT_TRUE(queue.pop(element));
+        auto producer = static_cast<int>(element / STRESS);
+        EXPECT_LT(last[producer], element);
+        last[producer] = element;
+    }
+    EXPECT_FALSE(queue.pop(element));
+}
+
+TEST(Executor, SerialExecutorOrder) {
+    auto order = std::vector<int>{};
+    std::atomic<int> running{0};
+    std::atomic<bool> overlapped{false};
+    {
+        sharp::ThreadPoolExecutor pool{4};
+        sharp::SerialExecutor serial{&pool};
+        for (auto i = 0; i < STRESS; ++i) {
+            serial.add([&, i]() {
+                if (running.fetch_add(1)) {
+                    overlapped.store(true);
+                }
+                order.push_back(i);
+                running.fetch_sub(1);
+            });
+        }
+    }
+
+    EXPECT_FALSE(overlapped.load());
+    ASSERT_EQ(order.size(), STRESS);
+    for (auto i = 0; i < STRESS; ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+}
+
+TEST(Executor, SerialExecutorNested) {
+    // closures that add to their own serial executor run after everything
+    // that was already queued, the first closure waits till the second one
+    // has been added so that it is queued before the nested one
+    auto order = std::vector<int>{};
+    std::atomic<bool> added{false};
+    {
+        sharp::ThreadPoolExecutor pool{2};
+        sharp::SerialExecutor serial{&pool};
+        serial.add([&]() {
+            while (!added.load()) {
+                std::this_thread::yield();
+            }
+            order.push_back(0);
+            serial.add([&]() { order.push_back(2); });
+        });
+        serial.add([&]() { order.push_back(1); });
+        added.store(true);
+    }
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2}));
+}
+
+namespace {
+
+    /**
+     * An executor that queues closures till they are run by hand, and
+     * rejects them while the flag is set
+     */
+    class RejectingExecutor : public sharp::Executor {
+    public:
+        void add(sharp::UniqueFunction<void()> closure) override {
+            if (this->reject) {
+                throw sharp::RejectedExecution{"rejected"};
+            }
+            this->closures.push_back(std::move(closure));
+        }
+
+        void run_all() {
+            while (!this->closures.empty()) {
+                auto closure = std::move(this->closures.front());
+                this->closures.erase(this->closures.begin());
+                closure();
+            }
+        }
+
+        bool reject{false};
+        std::vector<sharp::UniqueFunction<void()>> closures;
+    };
+
+} // namespace anonymous
+
+TEST(Executor, SerialExecutorRejectedByParent) {
+    auto order = std::vector<int>{};
+    auto parent = RejectingExecutor{};
+    sharp::SerialExecutor serial{&parent};
+
+    // a rejected closure is not counted and does not run, and the serial
+    // executor keeps working after that
+    parent.reject = true;
+    EXPECT_THROW(serial.add([&]() { order.push_back(-1); }),
+                 sharp::RejectedExecution);
+    EXPECT_EQ(serial.num_pending_closures(), 0);
+
+    parent.reject = false;
+    for (auto i = 0; i < 100; ++i) {
+        serial.add([&order, i]() { order.push_back(i); });
+    }
+    EXPECT_EQ(parent.closures.size(), 1);
+
+    // a drain task that cannot be handed back to the parent runs the rest
+    // of the burst itself
+    parent.reject = true;
+    parent.run_all();
+    EXPECT_EQ(serial.num_pending_closures(), 0);
+    ASSERT_EQ(order.size(), 100);
+    for (auto i = 0; i < 100; ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+}
+
+TEST(Executor, SerialExecutorOutlivesExecutor) {
+    std::atomic<int> counter{0};
+    std::atomic<bool> go{false};
+    sharp::ThreadPoolExecutor pool{1};
+    {
+        sharp::SerialExecutor serial{&pool};
+        serial.add([&]() {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+        });
+        for (auto i = 0; i < 10; ++i) {
+            serial.add([&]() { ++counter; });
+        }
+        EXPECT_EQ(serial.num_pending_closures(), 11);
+    }
+
+    // the serial executor is gone but its closures still run
+    go.store(true);
+    pool.shutdown();
+    EXPECT_EQ(counter.load(), 10);
+}
+
+TEST(Executor, TimingWheelOrder) {
+    // ticks spread over every level of the wheel and beyond, each element
+    // should come out exactly at its tick
+    auto ticks = std::vector<std::uint64_t>{1, 2, 255, 256, 257, 1000, 65535,
+        65536, 70000, 1u << 24, (1u << 24) + 3, std::uint64_t{1} << 40};
+    sharp::detail::TimingWheel<std::uint64_t> wheel{5};
+    for (auto tick : ticks) {
+        wheel.insert(tick, tick);
+    }
+    EXPECT_EQ(wheel.size(), ticks.size());
+
+    auto expired = std::vector<std::uint64_t>{};
+    while (wheel.size()) {
+        auto next = wheel.next_tick();
+        EXPECT_GT(next, wheel.current());
+        wheel.advance(next, [&](auto element) {
+            // the first two were in the past and expire on the next tick
+            EXPECT_EQ(std::max(element, std::uint64_t{6}), next);
+            expired.push_back(element);
+        });
+    }
+
+    EXPECT_EQ(expired.size(), ticks.size());
+    EXPECT_TRUE(std::is_sorted(expired.begin(), expired.end()));
+    EXPECT_EQ(wheel.next_tick(), std::numeric_limits<std::uint64_t>::max());
+}
+
+TEST(Executor, TimingWheelAdvanceInBulk) {
+    sharp::detail::TimingWheel<int> wheel;
+    for (auto i = 1; i <= 1000; ++i) {
+        wheel.insert(i * 97, i);
+    }
+
+    auto expired = 0;
+    wheel.advance(97 * 500, [&](auto element) {
+        EXPECT_EQ(element, ++expired);
+    });
+    EXPECT_EQ(expired, 500);
+    EXPECT_EQ(wheel.size(), 500);
+    wheel.advance(97 * 1000, [&](auto element) {
+        EXPECT_EQ(element, ++expired);
+    });
+    EXPECT_EQ(expired, 1000);
+    EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(Executor, TimingWheelExecutorBasic) {
+    // the closures run inline on the timer thread, so they run one at a time
+    // in the order of their deadlines.  The deadlines are all relative to
+    // one point a little in the future, so how long the adds take does not
+    // matter
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now() + std::chrono::milliseconds{20};
+    auto delays = std::vector<int>{50, 0, 20, 10, 30};
+    std::mutex mtx;
+    auto order = std::vector<int>{};
+    std::atomic<bool> early{false};
+    {
+        sharp::TimingWheelExecutor timer;
+        for (auto delay : delays) {
+            auto deadline = start + std::chrono::milliseconds{delay};
+            timer.add_at(deadline, [&, delay, deadline]() {
+                if (Clock::now() < deadline) {
+                    early.store(true);
+                }
+                auto lck = std::unique_lock<std::mutex>{mtx};
+                order.push_back(delay);
+            });
+        }
+        EXPECT_GE(timer.num_pending_closures(), 1);
+
+        while (timer.num_pending_closures()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+
+    EXPECT_FALSE(early.load());
+    EXPECT_EQ(order, (std::vector<int>{0, 10, 20, 30, 50}));
+}
+
+TEST(Executor, TimingWheelExecutorPool) {
+    // on a pool the closures can run in any order, but never early
+    using Clock = std::chrono::steady_clock;
+    sharp::ThreadPoolExecutor pool{2};
+    auto start = Clock::now();
+    std::atomic<int> fired{0};
+    std::atomic<bool> early{false};
+    {
+        sharp::TimingWheelExecutor timer{&pool};
+        for (auto delay : {50, 0, 20, 10, 30}) {
+            auto duration = std::chrono::milliseconds{delay};
+            timer.add_after(duration, [&, duration]() {
+                if (Clock::now() - start < duration) {
+                    early.store(true);
+                }
+                ++fired;
+            });
+        }
+        while (timer.num_pending_closures()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    }
+    pool.shutdown();
+
+    EXPECT_FALSE(early.load());
+    EXPECT_EQ(fired.load(), 5);
+}
+
+TEST(Executor, TimingWheelExecutorDestroysPending) {
+    std::atomic<bool> fired{false};
+    auto resource = std::make_shared<int>(0);
+    {
+        sharp::TimingWheelExecutor timer;
+        timer.add_after(std::chrono::hours{1}, [&, resource]() {
+            fired.store(true);
+        });
+        EXPECT_EQ(resource.use_count(), 2);
+        EXPECT_EQ(timer.num_pending_closures(), 1);
+    }
+    EXPECT_FALSE(fired.load());
+    EXPECT_EQ(resource.use_count(), 1);
+}
+
+TEST(Executor, PriorityThreadPoolExecutorOrder) {
+    // with one worker that is kept busy everything queues up, and then runs
+    // highest lane first and in order within a lane
+    auto order = std::vector<int>{};
+    std::atomic<bool> go{false};
+    {
+        sharp::PriorityThreadPoolExecutor executor{1, 3, std::chrono::hours{1}};
+        EXPECT_EQ(executor.num_priorities(), 3);
+        executor.add([&]() {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+        });
+        while (executor.num_pending_closures()) {
+            std::this_thread::yield();
+        }
+
+        auto priorities = std::vector<std::int8_t>{sharp::Executor::LO_PRI,
+            sharp::Executor::MID_PRI, sharp::Executor::HI_PRI};
+        for (auto i = 0; i < 9; ++i) {
+            executor.add_with_priority([&order, i]() { order.push_back(i); },
+                                       priorities[i % 3]);
+        }
+        EXPECT_EQ(executor.num_pending_closures(), 9);
+        go.store(true);
+    }
+    EXPECT_EQ(order, (std::vector<int>{2, 5, 8, 1, 4, 7, 0, 3, 6}));
+}
+
+TEST(Executor, PriorityThreadPoolExecutorAging) {
+    // a low priority closure that has waited long enough runs ahead of high
+    // priority closures that were added after it
+    auto order = std::vector<int>{};
+    std::atomic<bool> go{false};
+    {
+        sharp::PriorityThreadPoolExecutor executor{
+            1, 3, std::chrono::milliseconds{1}};
+        executor.add([&]() {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+        });
+        while (executor.num_pending_closures()) {
+            std::this_thread::yield();
+        }
+
+        executor.add_with_priority([&]() { order.push_back(0); },
+                                   sharp::Executor::LO_PRI);
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        for (auto i = 1; i < 4; ++i) {
+            executor.add_with_priority([&order, i]() { order.push_back(i); },
+                                       sharp::Executor::HI_PRI);
+        }
+        go.store(true);
+    }
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3}));
+}
+
+TEST(Executor, PriorityThreadPoolExecutorAgedBacklog) {
+    // a backlog of low priority closures that has waited several aging
+    // intervals gets one closure in, and then a high priority closure added
+    // after the backlog runs ahead of the rest of it
+    constexpr auto backlog = 1000;
+    auto order = std::vector<int>{};
+    std::atomic<bool> go{false};
+    {
+        sharp::PriorityThreadPoolExecutor executor{
+            1, 3, std::chrono::milliseconds{50}};
+        executor.add([&]() {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+        });
+        while (executor.num_pending_closures()) {
+            std::this_thread::yield();
+        }
+
+        for (auto i = 0; i < backlog; ++i) {
+            executor.add_with_priority([&order, i]() { order.push_back(i); },
+                                       sharp::Executor::LO_PRI);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{200});
+        executor.add_with_priority([&]() { order.push_back(-1); },
+                                   sharp::Executor::HI_PRI);
+        go.store(true);
+    }
+
+    auto position = std::find(order.begin(), order.end(), -1);
+    ASSERT_NE(position, order.end());
+    EXPECT_LT(std::distance(order.begin(), position), backlog / 10);
+}
+
+TEST(Executor, PriorityThreadPoolExecutorThreaded) {
+    std::atomic<int> counter{0};
+    {
+        sharp::PriorityThreadPoolExecutor executor{4, 5};
+        for (auto i = 0; i < STRESS; ++i) {
+            executor.add_with_priority([&]() {
+                ++counter;
+            }, static_cast<std::int8_t>(i % 256 - 128));
+        }
+    }
+    EXPECT_EQ(counter.load(), STRESS);
+
+    // executors without priorities just ignore them
+    auto executed = false;
+    sharp::InlineExecutor::get()->add_with_priority([&]() { executed = true; },
+                                                    sharp::Executor::HI_PRI);
+    EXPECT_TRUE(executed);
+    EXPECT_EQ(sharp::InlineExecutor::get()->num_priorities(), 1);
+}
+
+namespace {
+
+    /**
+     * Keeps the only worker of the pool busy till the flag is set, so that
+     * everything added after this stays in the queue
+     */
+    void block_worker(sharp::ThreadPoolExecutor& executor,
+                      std::atomic<bool>& go) {
+        executor.add([&go]() {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+        });
+        while (executor.num_pending_closures()) {
+            std::this_thread::yield();
+        }
+    }
+
+} // namespace anonymous
+
+TEST(Executor, ThreadPoolExecutorBoundedBlock) {
+    std::atomic<bool> go{false};
+    std::atomic<int> counter{0};
+    sharp::ThreadPoolExecutor executor{1, 2, sharp::OverflowPolicy::Block};
+    block_worker(executor, go);
+    executor.add([&]() { ++counter; });
+    executor.add([&]() { ++counter; });
+
+    auto producer = std::thread{[&]() {
+        executor.add([&]() { ++counter; });
+    }};
+    while (!executor.stats().blocked) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(executor.stats().queued, 2);
+    EXPECT_EQ(executor.stats().capacity, 2);
+
+    go.store(true);
+    producer.join();
+    executor.shutdown();
+    EXPECT_EQ(counter.load(), 3);
+    EXPECT_EQ(executor.stats().blocked, 1);
+}
+
+TEST(Executor, ThreadPoolExecutorBoundedCallerRuns) {
+    std::atomic<bool> go{false};
+    auto threads = std::vector<std::thread::id>{};
+    std::mutex mtx;
+    sharp::ThreadPoolExecutor executor{
+        1, 1, sharp::OverflowPolicy::CallerRuns};
+    block_worker(executor, go);
+    for (auto i = 0; i < 2; ++i) {
+        executor.add([&]() {
+            auto lck = std::unique_lock<std::mutex>{mtx};
+            threads.push_back(std::this_thread::get_id());
+        });
+    }
+
+    // the second one ran right here
+    EXPECT_EQ(threads, (std::vector<std::thread::id>{
+        std::this_thread::get_id()}));
+    EXPECT_EQ(executor.stats().ran_inline, 1);
+    EXPECT_EQ(executor.num_pending_closures(), 1);
+    go.store(true);
+    executor.shutdown();
+    EXPECT_EQ(threads.size(), 2);
+}
+
+TEST(Executor, ThreadPoolExecutorBoundedReject) {
+    std::atomic<bool> go{false};
+    auto resource = std::make_shared<int>(0);
+    sharp::ThreadPoolExecutor executor{1, 1, sharp::OverflowPolicy::Reject};
+    block_worker(executor, go);
+    executor.add([]() {});
+    try {
+        executor.add([resource]() {});
+        EXPECT_TRUE(false);
+    } catch (sharp::RejectedExecution&) {}
+
+    EXPECT_EQ(resource.use_count(), 1);
+    EXPECT_EQ(executor.stats().rejected, 1);
+    EXPECT_EQ(executor.num_pending_closures(), 1);
+    go.store(true);
+}
+
+TEST(Executor, ThreadPoolExecutorBoundedDropOldest) {
+    std::atomic<bool> go{false};
+    auto order = std::vector<int>{};
+    sharp::ThreadPoolExecutor executor{
+        1, 2, sharp::OverflowPolicy::DropOldest};
+    block_worker(executor, go);
+    for (auto i = 0; i < 5; ++i) {
+        executor.add([&order, i]() { order.push_back(i); });
+    }
+
+    auto stats = executor.stats();
+    EXPECT_EQ(stats.dropped, 3);
+    EXPECT_EQ(stats.queued, 2);
+    EXPECT_EQ(stats.pending, 2);
+    go.store(true);
+    executor.shutdown();
+    EXPECT_EQ(order, (std::vector<int>{3, 4}));
+}
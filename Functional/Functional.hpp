@@ -8,3 +8,4 @@
 #pragma once
 
 #include <sharp/Functional/detail/Function.hpp>
+#include <sharp/Functional/detail/UniqueFunction.hpp>
@@ -24,11 +24,20 @@
  *  2. std::function is about 2x slower than this on my computer (Apple LLVM
  *     version 8.0.0 (clang-800.0.42.1)), wow I know...  the test code for this
  *     claim is in the comments way at the bottom
+ *
+ * Functors that are small enough, copyable and nothrow move constructible
+ * are stored inline in a buffer within the function object, the size of the
+ * buffer can be changed with the second template parameter.  Everything else
+ * goes on the heap in one allocation that is shared among copies, which is
+ * what lets this hold move only functors while still being copyable.  If
+ * shared ownership is not needed then sharp::UniqueFunction is a strictly
+ * move only alternative that never shares its functor
  */
 
 #pragma once
 
 #include <cassert>
+#include <cstddef>
 #include <memory>
 #include <new>
 #include <type_traits>
@@ -36,10 +45,11 @@
 
 namespace sharp {
 
-template <typename T> class Function;
+template <typename T, ::std::size_t InlineSize = 4 * sizeof(void*)>
+class Function;
 
-template<class R, class ...A>
-class Function<R (A...)>
+template<class R, class ...A, ::std::size_t InlineSize>
+class Function<R (A...), InlineSize>
 {
   using stub_ptr_type = R (*)(void*, A&&...);
 
@@ -52,9 +62,35 @@ class Function<R (A...)>
 public:
   Function() = default;
 
-  Function(Function const&) = default;
+  Function(Function const& other) :
+    object_ptr_(other.object_ptr_),
+    stub_ptr_(other.stub_ptr_),
+    manager_(other.manager_),
+    store_(other.store_)
+  {
+    if (manager_)
+    {
+      manager_(operation::copy, &buffer_, other.object_ptr_);
+      object_ptr_ = &buffer_;
+    }
+  }
+
+  Function(Function&& other) noexcept :
+    object_ptr_(other.object_ptr_),
+    stub_ptr_(other.stub_ptr_),
+    manager_(other.manager_),
+    store_(::std::move(other.store_))
+  {
+    if (manager_)
+    {
+      manager_(operation::move, &buffer_, other.object_ptr_);
+      object_ptr_ = &buffer_;
+    }
+
+    other.reset();
+  }
 
-  Function(Function&&) = default;
+  ~Function() { destroy(); }
 
   Function(::std::nullptr_t const) noexcept : Function() { }
 
@@ -102,25 +138,43 @@ public:
       !::std::is_same<Function, typename ::std::decay<T>::type>{}
     >::type
   >
-  Function(T&& f) :
-    store_(operator new(sizeof(typename ::std::decay<T>::type)),
-      functor_deleter<typename ::std::decay<T>::type>),
-    store_size_(sizeof(typename ::std::decay<T>::type))
+  Function(T&& f)
   {
-    using functor_type = typename ::std::decay<T>::type;
+    emplace(::std::forward<T>(f));
+  }
 
-    new (store_.get()) functor_type(::std::forward<T>(f));
+  Function& operator=(Function const& rhs)
+  {
+    if (this != &rhs)
+    {
+      *this = Function(rhs);
+    }
+
+    return *this;
+  }
 
-    object_ptr_ = store_.get();
+  Function& operator=(Function&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      destroy();
 
-    stub_ptr_ = functor_stub<functor_type>;
+      object_ptr_ = rhs.object_ptr_;
+      stub_ptr_ = rhs.stub_ptr_;
+      manager_ = rhs.manager_;
+      store_ = ::std::move(rhs.store_);
 
-    deleter_ = deleter_stub<functor_type>;
-  }
+      if (manager_)
+      {
+        manager_(operation::move, &buffer_, rhs.object_ptr_);
+        object_ptr_ = &buffer_;
+      }
 
-  Function& operator=(Function const&) = default;
+      rhs.reset();
+    }
 
-  Function& operator=(Function&&) = default;
+    return *this;
+  }
 
   template <class C>
   Function& operator=(R (C::* const rhs)(A...))
@@ -142,29 +196,8 @@ public:
   >
   Function& operator=(T&& f)
   {
-    using functor_type = typename ::std::decay<T>::type;
-
-    if ((sizeof(functor_type) > store_size_) || !store_.unique())
-    {
-      store_.reset(operator new(sizeof(functor_type)),
-        functor_deleter<functor_type>);
-
-      store_size_ = sizeof(functor_type);
-    }
-    else
-    {
-      deleter_(store_.get());
-    }
-
-    new (store_.get()) functor_type(::std::forward<T>(f));
-
-    object_ptr_ = store_.get();
-
-    stub_ptr_ = functor_stub<functor_type>;
-
-    deleter_ = deleter_stub<functor_type>;
-
-    return *this;
+    // construct first so that this is left untouched if that throws
+    return *this = Function(::std::forward<T>(f));
   }
 
   template <R (* const function_ptr)(A...)>
@@ -243,12 +276,38 @@ public:
     return const_member_pair<C>(&object, method_ptr);
   }
 
-  void reset() { stub_ptr_ = nullptr; store_.reset(); }
+  void reset() noexcept
+  {
+    destroy();
+
+    object_ptr_ = nullptr;
+    stub_ptr_ = nullptr;
+  }
 
   void reset_stub() noexcept { stub_ptr_ = nullptr; }
 
-  void swap(Function& other) noexcept { ::std::swap(*this, other); }
+  void swap(Function& other) noexcept
+  {
+    auto tmp = Function(::std::move(other));
+
+    other = ::std::move(*this);
+    *this = ::std::move(tmp);
+  }
+
+  /**
+   * Returns true if the functor is stored in the inline buffer, mostly
+   * useful for tests
+   */
+  bool is_inline() const noexcept { return object_ptr_ == &buffer_; }
 
+  /**
+   * Two functions compare equal when they would call the same stub on the
+   * same object.  Copies of a function bound to an object or holding a heap
+   * stored functor share that object and compare equal.  A functor stored
+   * inline is copied along with the function, so the copies have their own
+   * state and do not compare equal, unlike before functors were stored
+   * inline
+   */
   bool operator==(Function const& rhs) const noexcept
   {
     return (object_ptr_ == rhs.object_ptr_) && (stub_ptr_ == rhs.stub_ptr_);
@@ -286,28 +345,89 @@ public:
 private:
   friend struct ::std::hash<Function>;
 
-  using deleter_type = void (*)(void*);
+  enum class operation { copy, move, destroy };
+
+  using manager_type = void (*)(operation, void*, void*);
+
+  /**
+   * Functors go in the inline buffer only if moving them cannot throw,
+   * otherwise moving the Function itself would be able to throw.  They also
+   * need to be copyable since the inline buffer is not shared between
+   * copies
+   */
+  template <typename T>
+  using fits_inline = ::std::integral_constant<bool,
+    (sizeof(T) <= InlineSize) &&
+    (alignof(T) <= alignof(::std::max_align_t)) &&
+    ::std::is_nothrow_move_constructible<T>{} &&
+    ::std::is_copy_constructible<T>{}>;
 
-  void* object_ptr_;
+  void* object_ptr_{};
   stub_ptr_type stub_ptr_{};
 
-  deleter_type deleter_;
+  // set only when the functor lives in the inline buffer
+  manager_type manager_{};
 
   ::std::shared_ptr<void> store_;
-  ::std::size_t store_size_;
 
-  template <class T>
-  static void functor_deleter(void* const p)
+  typename ::std::aligned_storage<
+    InlineSize, alignof(::std::max_align_t)>::type buffer_;
+
+  template <typename T>
+  void emplace(T&& f)
+  {
+    using functor_type = typename ::std::decay<T>::type;
+
+    emplace<functor_type>(::std::forward<T>(f), fits_inline<functor_type>{});
+
+    stub_ptr_ = functor_stub<functor_type>;
+  }
+
+  template <typename F, typename T>
+  void emplace(T&& f, ::std::true_type)
+  {
+    new (&buffer_) F(::std::forward<T>(f));
+
+    object_ptr_ = &buffer_;
+    manager_ = manager_stub<F>;
+  }
+
+  template <typename F, typename T>
+  void emplace(T&& f, ::std::false_type)
   {
-    static_cast<T*>(p)->~T();
+    auto store = ::std::make_shared<F>(::std::forward<T>(f));
 
-    operator delete(p);
+    object_ptr_ = store.get();
+    store_ = ::std::move(store);
+  }
+
+  void destroy() noexcept
+  {
+    if (manager_)
+    {
+      manager_(operation::destroy, nullptr, object_ptr_);
+      manager_ = nullptr;
+    }
+
+    store_.reset();
   }
 
   template <class T>
-  static void deleter_stub(void* const p)
+  static void manager_stub(operation const op, void* const to,
+    void* const from)
   {
-    static_cast<T*>(p)->~T();
+    switch (op)
+    {
+      case operation::copy:
+        new (to) T(*static_cast<T const*>(from));
+        break;
+      case operation::move:
+        new (to) T(::std::move(*static_cast<T*>(from)));
+        break;
+      case operation::destroy:
+        static_cast<T*>(from)->~T();
+        break;
+    }
   }
 
   template <R (*function_ptr)(A...)>
@@ -376,14 +496,16 @@ private:
 
 namespace std
 {
-  template <typename R, typename ...A>
-  struct hash<sharp::Function<R (A...)> >
+  template <typename R, typename ...A, size_t InlineSize>
+  struct hash<sharp::Function<R (A...), InlineSize> >
   {
-    size_t operator()(sharp::Function<R (A...)> const& d) const noexcept
+    size_t operator()(
+      sharp::Function<R (A...), InlineSize> const& d) const noexcept
     {
       auto const seed(hash<void*>()(d.object_ptr_));
 
-      return hash<typename sharp::Function<R (A...)>::stub_ptr_type>()(
+      return hash<typename sharp::Function<R (A...), InlineSize>
+        ::stub_ptr_type>()(
         d.stub_ptr_) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     }
   };
@@ -0,0 +1,200 @@
+/**
+ * @file UniqueFunction.hpp
+ * @author Aaryaman Sagar
+ *
+ * A move only type erased function object.  Unlike sharp::Function this
+ * never shares the stored functor between instances, so it does not need a
+ * reference counted control block and can hold functors that capture unique
+ * resources like promises without any shared ownership
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sharp {
+
+/**
+ * @class UniqueFunction
+ *
+ * Functors that fit in InlineSize bytes and are nothrow move constructible
+ * are stored inline in the function object itself, so type erasing a small
+ * lambda does not allocate.  Larger functors, or ones that can throw on a
+ * move, are allocated on the heap with a single allocation and the pointer
+ * to them is what gets moved around
+ *
+ *      auto promise = sharp::Promise<int>{};
+ *      auto f = sharp::UniqueFunction<void()>{
+ *          [promise = std::move(promise)]() mutable {
+ *              promise.set_value(1);
+ *          }};
+ *
+ * The default inline size is large enough to store the continuations that
+ * futures pass to executors without allocating
+ */
+template <typename Signature, std::size_t InlineSize = 8 * sizeof(void*)>
+class UniqueFunction;
+
+template <typename ReturnType, typename... Args, std::size_t InlineSize>
+class UniqueFunction<ReturnType(Args...), InlineSize> {
+public:
+
+    /**
+     * Default constructs an empty function object, calling an empty function
+     * object is undefined
+     */
+    UniqueFunction() noexcept = default;
+    UniqueFunction(std::nullptr_t) noexcept {}
+
+    /**
+     * Type erase the passed functor, the functor is either stored inline or
+     * on the heap as described above
+     */
+    template <typename Func, typename = std::enable_if_t<!std::is_same<
+        std::decay_t<Func>, UniqueFunction>::value>>
+    UniqueFunction(Func&& func) {
+        this->emplace<std::decay_t<Func>>(std::forward<Func>(func),
+                FitsInline<std::decay_t<Func>>{});
+    }
+
+    /**
+     * Move only, moving a function object with an inline functor moves the
+     * functor, moving one with a heap allocated functor just moves a pointer
+     */
+    UniqueFunction(UniqueFunction&& other) noexcept {
+        this->take(other);
+    }
+    UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+        if (this != &other) {
+            this->destroy();
+            this->take(other);
+        }
+        return *this;
+    }
+    UniqueFunction(const UniqueFunction&) = delete;
+    UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+    UniqueFunction& operator=(std::nullptr_t) noexcept {
+        this->destroy();
+        return *this;
+    }
+
+    ~UniqueFunction() {
+        this->destroy();
+    }
+
+    /**
+     * Invoke the stored functor, this is const to be consistent with
+     * std::function and sharp::Function, the stored functor itself is not
+     * treated as const
+     */
+    ReturnType operator()(Args... args) const {
+        return this->invoker(this->object, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept {
+        return this->invoker;
+    }
+    bool operator==(std::nullptr_t) const noexcept {
+        return !this->invoker;
+    }
+    bool operator!=(std::nullptr_t) const noexcept {
+        return this->invoker;
+    }
+
+    /**
+     * Returns true if the functor is stored in the inline buffer, mostly
+     * useful for tests
+     */
+    bool is_inline() const noexcept {
+        return this->object == static_cast<const void*>(&this->buffer);
+    }
+
+private:
+
+    enum class Operation { Move, Destroy };
+
+    using Invoker = ReturnType (*)(void*, Args&&...);
+    using Manager = void (*)(Operation, void*, void*);
+
+    template <typename Func>
+    using FitsInline = std::integral_constant<bool,
+          (sizeof(Func) <= InlineSize)
+          && (alignof(Func) <= alignof(std::max_align_t))
+          && std::is_nothrow_move_constructible<Func>::value>;
+
+    template <typename Func, typename F>
+    void emplace(F&& func, std::true_type) {
+        new (&this->buffer) Func(std::forward<F>(func));
+        this->object = &this->buffer;
+        this->invoker = &invoke<Func>;
+        this->manager = &manage_inline<Func>;
+    }
+    template <typename Func, typename F>
+    void emplace(F&& func, std::false_type) {
+        this->object = new Func(std::forward<F>(func));
+        this->invoker = &invoke<Func>;
+        this->manager = &manage_heap<Func>;
+    }
+
+    /**
+     * Steal the functor from the other function object and leave it empty
+     */
+    void take(UniqueFunction& other) noexcept {
+        this->object = other.object;
+        this->invoker = other.invoker;
+        this->manager = other.manager;
+        if (other.is_inline()) {
+            this->manager(Operation::Move, &this->buffer, other.object);
+            this->object = &this->buffer;
+        }
+
+        other.object = nullptr;
+        other.invoker = nullptr;
+        other.manager = nullptr;
+    }
+
+    void destroy() noexcept {
+        if (this->manager) {
+            this->manager(Operation::Destroy, nullptr, this->object);
+        }
+
+        this->object = nullptr;
+        this->invoker = nullptr;
+        this->manager = nullptr;
+    }
+
+    template <typename Func>
+    static ReturnType invoke(void* object, Args&&... args) {
+        return (*static_cast<Func*>(object))(std::forward<Args>(args)...);
+    }
+
+    /**
+     * A move for inline functors move constructs into the destination and
+     * destroys the source, heap functors are never moved
+     */
+    template <typename Func>
+    static void manage_inline(Operation op, void* to, void* from) {
+        auto func = static_cast<Func*>(from);
+        if (op == Operation::Move) {
+            new (to) Func(std::move(*func));
+        }
+        func->~Func();
+    }
+    template <typename Func>
+    static void manage_heap(Operation op, void*, void* from) {
+        if (op == Operation::Destroy) {
+            delete static_cast<Func*>(from);
+        }
+    }
+
+    void* object{nullptr};
+    Invoker invoker{nullptr};
+    Manager manager{nullptr};
+    std::aligned_storage_t<InlineSize, alignof(std::max_align_t)> buffer;
+};
+
+} // namespace sharp
@@ -2,7 +2,9 @@
 
 #include <gtest/gtest.h>
 
+#include <array>
 #include <memory>
+#include <stdexcept>
 
 TEST(Functional, BasicFunctional) {
     // move only lambda that would otherwise not be compatible with
@@ -14,6 +16,129 @@ TEST(Functional, BasicFunctional) {
     EXPECT_EQ(f(), 4);
 }
 
+TEST(Functional, FunctionInlineStorage) {
+    // small copyable lambdas are stored inline and copies do not share them
+    auto count = 0;
+    auto f = sharp::Function<int()>{[&count, local = 0]() mutable {
+        ++count;
+        return ++local;
+    }};
+    EXPECT_TRUE(f.is_inline());
+    EXPECT_EQ(f(), 1);
+
+    auto g = f;
+    EXPECT_TRUE(g.is_inline());
+    EXPECT_EQ(g(), 2);
+    EXPECT_EQ(f(), 2);
+    EXPECT_EQ(count, 3);
+
+    auto h = std::move(f);
+    EXPECT_TRUE(h.is_inline());
+    EXPECT_EQ(h(), 3);
+    EXPECT_FALSE(f);
+}
+
+TEST(Functional, FunctionHeapStorage) {
+    // move only and oversized functors go on the heap
+    auto int_uptr = std::make_unique<int>(2);
+    auto f = sharp::Function<int()>{[int_uptr = std::move(int_uptr)]() {
+        return *int_uptr;
+    }};
+    EXPECT_FALSE(f.is_inline());
+
+    auto big = std::array<char, 128>{};
+    big[0] = 1;
+    auto g = sharp::Function<int()>{[big]() { return big[0]; }};
+    EXPECT_FALSE(g.is_inline());
+    EXPECT_EQ(g(), 1);
+
+    // a larger inline buffer can be asked for
+    auto h = sharp::Function<int(), 256>{[big]() { return big[0]; }};
+    EXPECT_TRUE(h.is_inline());
+    EXPECT_EQ(h(), 1);
+}
+
+TEST(Functional, FunctionEquality) {
+    // copies of a heap stored functor share it and compare equal
+    auto int_uptr = std::make_unique<int>(2);
+    auto heap = sharp::Function<int()>{[int_uptr = std::move(int_uptr)]() {
+        return *int_uptr;
+    }};
+    auto big = std::array<char, 128>{};
+    auto f = sharp::Function<int()>{[big]() { return big[0]; }};
+    auto g = f;
+    EXPECT_TRUE(f == g);
+    EXPECT_FALSE(f != g);
+    EXPECT_FALSE(f == heap);
+
+    // copies of an inline functor have their own state and do not
+    auto h = sharp::Function<int()>{[local = 0]() mutable { return ++local; }};
+    auto i = h;
+    EXPECT_TRUE(h.is_inline());
+    EXPECT_FALSE(h == i);
+    EXPECT_TRUE(h != i);
+    EXPECT_TRUE(h == h);
+
+    // an empty function compares equal to nullptr
+    auto empty = sharp::Function<int()>{};
+    EXPECT_TRUE(empty == nullptr);
+    EXPECT_FALSE(h == nullptr);
+}
+
+TEST(Functional, FunctionAssignThrows) {
+    struct ThrowsOnCopy {
+        ThrowsOnCopy() = default;
+        ThrowsOnCopy(const ThrowsOnCopy&) {
+            throw std::runtime_error{"copy"};
+        }
+        int operator()() const { return 2; }
+    };
+
+    // a functor that fails to copy leaves the assigned to function as it was
+    auto shared = std::make_shared<int>(1);
+    auto f = sharp::Function<int()>{[shared]() { return *shared; }};
+    auto throws = ThrowsOnCopy{};
+    EXPECT_THROW(f = throws, std::runtime_error);
+    EXPECT_EQ(shared.use_count(), 2);
+    EXPECT_TRUE(f);
+    EXPECT_EQ(f(), 1);
+}
+
+TEST(Functional, UniqueFunctionBasic) {
+    auto int_uptr = std::make_unique<int>(2);
+    auto f = sharp::UniqueFunction<int(int)>{
+        [int_uptr = std::move(int_uptr)](int i) { return *int_uptr * i; }};
+    EXPECT_TRUE(f.is_inline());
+    EXPECT_EQ(f(3), 6);
+
+    auto g = std::move(f);
+    EXPECT_FALSE(f);
+    EXPECT_TRUE(g.is_inline());
+    EXPECT_EQ(g(4), 8);
+
+    g = nullptr;
+    EXPECT_FALSE(g);
+}
+
+TEST(Functional, UniqueFunctionDestroysFunctor) {
+    auto shared = std::make_shared<int>(1);
+    {
+        auto big = std::array<char, 128>{};
+        auto inline_function = sharp::UniqueFunction<void()>{
+            [shared]() {}};
+        auto heap_function = sharp::UniqueFunction<void()>{
+            [shared, big]() {}};
+        EXPECT_TRUE(inline_function.is_inline());
+        EXPECT_FALSE(heap_function.is_inline());
+        EXPECT_EQ(shared.use_count(), 3);
+
+        auto moved = std::move(heap_function);
+        EXPECT_FALSE(moved.is_inline());
+        EXPECT_EQ(shared.use_count(), 3);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
 // #include <iostream>
 // #include <cstdlib>
 // #include <memory>
@@ -0,0 +1,12 @@
+#include <sharp/Future/Future.hpp>
+#include <sharp/Executor/TimingWheelExecutor.hpp>
+
+namespace sharp {
+namespace detail {
+
+    TimedExecutor* default_timekeeper() {
+        return TimingWheelExecutor::get();
+    }
+
+} // namespace detail
+} // namespace sharp
@@ -15,11 +15,13 @@
 #include <sharp/Traits/Traits.hpp>
 #include <sharp/Utility/Utility.hpp>
 #include <sharp/Executor/Executor.hpp>
+#include <sharp/Executor/TimedExecutor.hpp>
 #include <sharp/Future/detail/Future-pre.hpp>
 
 #include <memory>
 #include <functional>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 
 namespace sharp {
@@ -64,6 +66,16 @@ namespace detail {
     class ExecutableFuture : public sharp::Crtp<ExecutableFuture<FutureType>> {
     public:
 
+        /**
+         * The executor and priority go along with the shared state when a
+         * future is moved, copied or converted into another kind of future
+         */
+        ExecutableFuture() = default;
+        template <typename OtherFutureType>
+        explicit ExecutableFuture(ExecutableFuture<OtherFutureType>& other)
+            : executor{other.get_executor()},
+              priority{other.get_priority()} {}
+
         /**
          * The via() function, further documentation is in the definition of
          * the Future class, this is not atomic beacause it does not need to
@@ -71,20 +83,32 @@ namespace detail {
          * and therefore should only be changed in one thread (it is not a
          * const method)
          */
-        FutureType via(Executor* executor);
+        FutureType via(Executor* executor,
+                       std::int8_t priority = Executor::MID_PRI);
 
         /**
-         * Getter for the executor member variable, via() acts like the setter
+         * Getters for the executor and priority member variables, via() acts
+         * like the setter
          */
         Executor* get_executor();
+        std::int8_t get_priority();
 
     private:
         /**
-         * The executor member
+         * The executor member and the priority continuations are added to it
+         * with
          */
         Executor* executor{sharp::InlineExecutor::get()};
+        std::int8_t priority{Executor::MID_PRI};
     };
 
+    /**
+     * The timekeeper used by within() and on_timeout() when none is passed,
+     * the process wide timing wheel.  This is defined in Future.cpp so that
+     * including futures does not include the timing wheel
+     */
+    TimedExecutor* default_timekeeper();
+
 } // namespace detail
 
 /**
@@ -326,8 +350,60 @@ public:
      * This will cause the first callback `one` to be executed when the future
      * completes on whatever executor was already set in `future`, and then
      * `two` will be executed on the other side of `exe`
+     *
+     * A priority can be given along with the executor, continuations are
+     * then added to the executor with add_with_priority().  Executors that
+     * do not support priorities ignore it, and continuations chained off of
+     * the future returned by .then() inherit the priority along with the
+     * executor
+     *
+     *      future.via(&pool, sharp::Executor::HI_PRI).then(respond);
      */
     Future<Type> via(Executor* executor);
+    Future<Type> via(Executor* executor, std::int8_t priority);
+
+    /**
+     * Returns a future that completes with the result of this one if that
+     * arrives within the given duration, and with a FutureError with the
+     * error code FutureErrorCode::timeout otherwise
+     *
+     *      auto response = make_request().within(100ms, &timer);
+     *      try {
+     *          use(response.get());
+     *      } catch (sharp::FutureError& err) {
+     *          // err.code() == sharp::FutureErrorCode::timeout
+     *      }
+     *
+     * The timeout is scheduled on the timekeeper, which defaults to the
+     * process wide timing wheel.  When the timeout wins, the callback that
+     * was registered on this future's shared state is destroyed and the
+     * reference to that shared state is dropped right away, so nothing that
+     * hangs off the returned future is kept alive till the slow producer
+     * finally gets around to setting a result, which is then just discarded
+     *
+     * Like .then() this releases the shared state of the current future and
+     * the returned future inherits its executor
+     */
+    Future<Type> within(
+            TimedExecutor::Clock::duration duration,
+            TimedExecutor* timekeeper = detail::default_timekeeper());
+
+    /**
+     * Returns a future that completes with the result of this one if that
+     * arrives within the given duration, and with the value returned by the
+     * fallback otherwise.  The fallback should be callable with no arguments
+     * and return something a Type can be constructed from, it runs as a
+     * continuation on the future's executor
+     *
+     *      auto config = fetch_config().on_timeout(50ms, []() {
+     *          return Config::defaults();
+     *      });
+     */
+    template <typename Func>
+    Future<Type> on_timeout(
+            TimedExecutor::Clock::duration duration,
+            Func fallback,
+            TimedExecutor* timekeeper = detail::default_timekeeper());
 
     /**
      * Make friends with the promise class
@@ -20,6 +20,8 @@
 #include <iterator>
 #include <cassert>
 #include <vector>
+#include <atomic>
+#include <cstdint>
 
 namespace sharp {
 
@@ -56,6 +58,19 @@ namespace detail {
         future = promise.get_future();
     }
 
+    /**
+     * The state shared between the callback on the source future and the
+     * timer in Future::within(), whichever sets the finished flag first
+     * fulfills the promise.  The timer only holds a weak reference, so the
+     * state goes away as soon as the callback has run
+     */
+    template <typename Type>
+    struct TimeoutRace {
+        std::atomic<bool> finished{false};
+        sharp::Promise<Type> promise;
+        std::shared_ptr<FutureImpl<Type>> source;
+    };
+
 } // namespace detail
 
 template <typename Type>
@@ -69,7 +84,8 @@ Future<Type>::Future(const std::shared_ptr<detail::FutureImpl<Type>>& state)
 
 template <typename Type>
 Future<Type>::Future(Future&& other) noexcept
-        : shared_state{std::move(other.shared_state)} {}
+        : detail::ExecutableFuture<Future<Type>>{other},
+          shared_state{std::move(other.shared_state)} {}
 
 template <typename Type>
 Future<Type>::Future(Future<Future<Type>>&& other) : Future{} {
@@ -79,9 +95,8 @@ Future<Type>::Future(Future<Future<Type>>&& other) : Future{} {
     other.check_shared_state();
 
     // create a promise for *this and assign the resulting future to *this,
-    // creating a shared_ptr to a promise because the add_callback function
-    // requires a lambda that is copyable, and this is because it stores the
-    // lambda in a std::function object
+    // the promise is moved into the callback since callbacks are stored in a
+    // move only function object
     auto promise = sharp::Promise<Type>();
     *this = promise.get_future();
 
@@ -127,6 +142,7 @@ Future<Type>::Future(Future<Future<Type>>&& other) : Future{} {
 
 template <typename Type>
 Future<Type>& Future<Type>::operator=(Future&& other) noexcept {
+    this->detail::ExecutableFuture<Future<Type>>::operator=(other);
     this->shared_state = std::move(other.shared_state);
     return *this;
 }
@@ -173,7 +189,8 @@ template <typename Func,
 auto Future<Type>::then(Func&& func)
         -> Future<decltype(func(std::move(*this)))> {
     return this->detail::ComposableFuture<Future<Type>>::then(
-            std::forward<Func>(func)).via(this->get_executor());
+            std::forward<Func>(func))
+        .via(this->get_executor(), this->get_priority());
 }
 
 template <typename Type>
@@ -186,7 +203,7 @@ auto Future<Type>::then(Func&& func) -> decltype(func(std::move(*this))) {
         = typename std::decay_t<decltype(func(std::move(*this)))>::value_type;
     return Future<T>{this->
         detail::ComposableFuture<Future<Type>>::then(std::forward<Func>(func))}
-            .via(this->get_executor());
+            .via(this->get_executor(), this->get_priority());
 }
 
 template <typename Type>
@@ -197,13 +214,84 @@ Future<Type> Future<Type>::via(Executor* executor) {
     return this->template ExecutableFuture<Future<Type>>::via(executor);
 }
 
+template <typename Type>
+Future<Type> Future<Type>::via(Executor* executor, std::int8_t priority) {
+    return this->template ExecutableFuture<Future<Type>>::via(executor,
+                                                               priority);
+}
+
+template <typename Type>
+Future<Type> Future<Type>::within(TimedExecutor::Clock::duration duration,
+                                  TimedExecutor* timekeeper) {
+    this->check_shared_state();
+    assert(timekeeper);
+
+    auto executor = this->get_executor();
+    auto priority = this->get_priority();
+    auto source = std::move(this->shared_state);
+    auto race = std::make_shared<detail::TimeoutRace<Type>>();
+    race->source = source;
+    auto future = race->promise.get_future();
+
+    source->add_callback([race](auto& state) {
+        if (race->finished.exchange(true)) {
+            return;
+        }
+        if (state.contains_exception()) {
+            race->promise.set_exception(state.get_exception_ptr());
+        } else {
+            race->promise.set_value(state.get());
+        }
+    });
+
+    // no need for a timer if the result was already there
+    if (!race->finished.load()) {
+        timekeeper->add_after(duration, [weak = std::weak_ptr<
+                detail::TimeoutRace<Type>>{race}]() {
+            auto race = weak.lock();
+            if (!race || race->finished.exchange(true)) {
+                return;
+            }
+
+            // take the callback off the source so it does not keep anything
+            // alive till the producer sets a result, if the result raced in
+            // then the callback sees the finished flag and does nothing
+            race->source->remove_callback();
+            race->source.reset();
+            auto exc = FutureError{FutureErrorCode::timeout};
+            race->promise.set_exception(std::make_exception_ptr(exc));
+        });
+    }
+
+    return future.via(executor, priority);
+}
+
+template <typename Type>
+template <typename Func>
+Future<Type> Future<Type>::on_timeout(TimedExecutor::Clock::duration duration,
+                                      Func fallback,
+                                      TimedExecutor* timekeeper) {
+    return this->within(duration, timekeeper).then(
+            [fallback = std::move(fallback)](auto future) mutable -> Type {
+        try {
+            return future.get();
+        } catch (FutureError& err) {
+            if (err.code()
+                    != std::make_error_code(FutureErrorCode::timeout)) {
+                throw;
+            }
+        }
+        return fallback();
+    });
+}
+
 template <typename Type>
 Future<std::decay_t<Type>> make_ready_future(Type&& object) {
     // make a promise with the value and then return the corresponding future
     auto promise = sharp::Promise<std::decay_t<Type>>{};
     auto future = promise.get_future();
     assert(future.shared_state);
-    future.shared_state->set_value_no_lock(std::forward<Type>(object));
+    future.shared_state->set_value(std::forward<Type>(object));
     return future;
 }
 
@@ -212,7 +300,7 @@ Future<std::decay_t<Type>> make_exceptional_future(std::exception_ptr ptr) {
     auto promise = sharp::Promise<Type>{};
     auto future = promise.get_future();
     assert(future.shared_state);
-    future.shared_state->set_exception_no_lock(ptr);
+    future.shared_state->set_exception(ptr);
     return future;
 }
 
@@ -221,7 +309,7 @@ Future<std::decay_t<Type>> make_exceptional_future(Exception exception) {
     auto promise = sharp::Promise<Type>{};
     auto future = promise.get_future();
     assert(future.shared_state);
-    future.shared_state->set_exception_no_lock(
+    future.shared_state->set_exception(
             std::make_exception_ptr(exception));
     return future;
 }
@@ -310,6 +398,7 @@ namespace detail {
 
         this->instance().shared_state->add_callback(
                 [executor = this->instance().get_executor(),
+                 priority = this->instance().get_priority(),
                  promise = std::move(promise),
                  func = std::forward<Func>(func),
                  shared_state = this->instance().shared_state]
@@ -326,7 +415,7 @@ namespace detail {
             // try and get the value from the callback, if an exception was
             // thrown, propagate that
             assert(executor);
-            executor->add(
+            executor->add_with_priority(
                     [func = std::forward<Func>(func),
                      fut = std::move(fut),
                      promise = std::move(promise)]() mutable {
@@ -337,15 +426,17 @@ namespace detail {
                     promise.set_exception(std::current_exception());
                     return;
                 }
-            });
+            }, priority);
         });
 
         return future;
     }
 
     template <typename FutureType>
-    FutureType ExecutableFuture<FutureType>::via(Executor* executor) {
+    FutureType ExecutableFuture<FutureType>::via(Executor* executor,
+                                                 std::int8_t priority) {
         this->executor = executor;
+        this->priority = priority;
         return std::move(this->instance());
     }
 
@@ -354,6 +445,11 @@ namespace detail {
         return this->executor;
     }
 
+    template <typename FutureType>
+    std::int8_t ExecutableFuture<FutureType>::get_priority() {
+        return this->priority;
+    }
+
     // helper trait
     template <typename F>
     struct PromiseFor {
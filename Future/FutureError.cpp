@@ -11,6 +11,7 @@ namespace detail {
     const std::string FUTURE_ALREADY_RETRIEVED{"future already retrieved"};
     const std::string PROMISE_ALREADY_SATISFIED{"promise already satisfied"};
     const std::string NO_STATE{"no state"};
+    const std::string TIMEOUT{"future timed out"};
 } // namespace detail
 
 /**
@@ -34,7 +35,7 @@ std::string FutureErrorCategory::message(int value) const {
 
     // assert that the integer passed to FutureErrorCategory is within the
     // range of the enumeration, otherwise there will be undefined behavior
-    assert(value <= static_cast<int>(FutureErrorCode::no_state));
+    assert(value <= static_cast<int>(FutureErrorCode::timeout));
     switch (static_cast<FutureErrorCode>(value)) {
         case FutureErrorCode::broken_promise:
             return detail::BROKEN_PROMISE;
@@ -48,6 +49,9 @@ std::string FutureErrorCategory::message(int value) const {
         case FutureErrorCode::no_state:
             return detail::NO_STATE;
             break;
+        case FutureErrorCode::timeout:
+            return detail::TIMEOUT;
+            break;
     }
 }
 
@@ -28,12 +28,15 @@ namespace sharp {
  *                           promise that already has one of those stored
  * no_state attempt to access future or promise methods when there is no
  *          shared state
+ * timeout the future was not fulfilled within the time it was given with
+ *         Future::within()
  */
 enum class FutureErrorCode : int {
     broken_promise,
     future_already_retrieved,
     promise_already_satisfied,
-    no_state
+    no_state,
+    timeout
 };
 
 /**
@@ -25,15 +25,18 @@ SharedFuture<Type>::SharedFuture() noexcept {};
 
 template <typename Type>
 SharedFuture<Type>::SharedFuture(SharedFuture&& other) noexcept
-        : shared_state{std::move(other.shared_state)} {}
+        : detail::ExecutableFuture<SharedFuture<Type>>{other},
+          shared_state{std::move(other.shared_state)} {}
 
 template <typename Type>
 SharedFuture<Type>::SharedFuture(const SharedFuture& other)
-        : shared_state{other.shared_state} {}
+        : detail::ExecutableFuture<SharedFuture<Type>>{other},
+          shared_state{other.shared_state} {}
 
 template <typename Type>
 SharedFuture<Type>::SharedFuture(Future<Type>&& other) noexcept
-        : shared_state{std::move(other.shared_state)} {}
+        : detail::ExecutableFuture<SharedFuture<Type>>{other},
+          shared_state{std::move(other.shared_state)} {}
 
 template <typename Type>
 SharedFuture<Type>::SharedFuture(Future<SharedFuture<Type>>&& other) {
@@ -120,7 +123,7 @@ auto SharedFuture<Type>::then(Func&& func)
         -> Future<decltype(func(*this))> {
     return this->detail::ComposableFuture<SharedFuture<Type>>::then(
             std::forward<Func>(func))
-        .via(this->get_executor());
+        .via(this->get_executor(), this->get_priority());
 }
 
 template <typename Type>
@@ -131,7 +134,7 @@ auto SharedFuture<Type>::then(Func&& func)
     using T = typename std::decay_t<decltype(func(*this))>::value_type;
     return Future<T>{this->detail::ComposableFuture<SharedFuture<Type>>::then(
             std::forward<Func>(func))}
-        .via(this->get_executor());
+        .via(this->get_executor(), this->get_priority());
 }
 
 template <typename Type>
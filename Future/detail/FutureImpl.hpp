@@ -4,7 +4,10 @@
  *
  * This file contains the main code for the FutureImpl class.  Which is the
  * implementation of the futures code, this contains all the synchronization
- * for when a value is set and stuff like that
+ * for when a value is set and stuff like that.  None of the operations take
+ * a lock, the only time a lock is touched is when a thread has to block in
+ * wait() because the result is not ready yet, and then it is the lock on a
+ * bucket of the process wide parking lot
  *
  * The Promise and Future classes are simply wrappers around this.  Both hook
  * into methods in this when one wants to set state and when the other waits
@@ -19,10 +22,11 @@
 
 #include <sharp/Traits/Traits.hpp>
 #include <sharp/Functional/Functional.hpp>
+#include <sharp/Threads/ParkingLot.hpp>
 
+#include <atomic>
+#include <cstdint>
 #include <exception>
-#include <condition_variable>
-#include <mutex>
 #include <initializer_list>
 #include <system_error>
 #include <functional>
@@ -41,16 +45,19 @@ namespace detail {
     public:
 
         /**
-         * Destructor just asserts that there is no callback registered on the
-         * shared state, because if there is a callback then it should already
-         * have been ran before the shared state is destroyed, either through
-         * a call to set_value(), set_exception() or .then()
+         * Destroys the value or exception in the shared state if there is
+         * one, and asserts that there is no callback registered on the shared
+         * state, because if there is a callback then it should already have
+         * been ran before the shared state is destroyed, either through a
+         * call to set_value(), set_exception() or .then()
          */
         ~FutureImpl();
 
         /**
          * The wait function blocks until there is a value or an exception in
-         * the shared state, this uses a condition variable to wait internally
+         * the shared state.  If the result is already there this is a single
+         * load, otherwise the thread parks on the address of the shared state
+         * in the parking lot
          */
         void wait() const;
 
@@ -100,10 +107,10 @@ namespace detail {
          *
          * The continuation closure will be executed inline and will either be
          * executed immediately if there is a value present in the shared
-         * state or will be packed up and stored in a std::function<> object
-         * to be executed later when the need arises, this way this function
-         * presents reusable code without causing unnecesary allocation if not
-         * needed
+         * state or will be packed up and stored in a function object to be
+         * executed later by the thread that sets the result, this way this
+         * function presents reusable code without causing unnecesary
+         * allocation if not needed
          *
          * The continuation functor must accept a FutureImpl<Type> object by
          * reference
@@ -111,6 +118,14 @@ namespace detail {
         template <typename Func>
         void add_callback(Func&& func);
 
+        /**
+         * Destroys the callback that was added if the result has not been
+         * set yet, and returns true if it did.  If this returns false the
+         * result raced in first and the callback has been or is about to be
+         * executed by whoever set the result
+         */
+        bool remove_callback();
+
         /**
          * Returns the current exception_ptr or value assuming there is an
          * exception or value in this
@@ -127,67 +142,85 @@ namespace detail {
         /**
          * Returns true if the shared state contains an exception
          *
-         * In order to be thread safe, this function first acquires a lock and
-         * then makes the check
-         */
-        bool contains_exception() const;
-
-        /**
-         * Sets the value or exception without locking anything, useful for
-         * when calling from public future functions for example
-         * make_ready_future and make_exceptional_future
+         * This is a single acquire load on the state word, if it returns
+         * true then the exception_ptr in the storage is safe to read
          */
-        template <typename... Args>
-        void set_value_no_lock(Args&&... args);
-        template <typename U, typename... Args>
-        void set_value_no_lock(std::initializer_list<U> il, Args&&... args);
-        void set_exception_no_lock(std::exception_ptr ptr);
+        bool contains_exception() const noexcept;
 
     private:
 
         /**
-         * The states the future can have, these should be self explanatory
-         */
-        enum class FutureState : int {
-            NotFulfilled,
-            ContainsValue,
-            ContainsException,
+         * The state of the future, all of the synchronization between the
+         * producer (the promise) and the consumer (the future and its
+         * continuation) goes through this one atomic word
+         *
+         * The low two bits form the state machine
+         *
+         *      Start        - neither a result nor a callback has been set
+         *      OnlyResult   - a value or exception has been set
+         *      OnlyCallback - a callback has been set
+         *      Done         - both have been set, whichever thread set the
+         *                     second one runs the callback
+         *
+         * Start moves to either OnlyResult or OnlyCallback and both of those
+         * move to Done.  The producer and the consumer each only ever set
+         * their own bit, so each transition is a single fetch_or and whoever
+         * sees the other bit already set in the previous value knows that it
+         * was second
+         *
+         * Exception is set along with OnlyResult when the result is an
+         * exception, and Waiting is set by threads that are about to park in
+         * wait(), so the producer only goes to the parking lot when there is
+         * someone to unpark
+         *
+         * Setting is claimed by the producer before it constructs the result
+         * in the storage, so that only one of two racing calls to set a
+         * result gets to touch the storage
+         */
+        enum FutureState : std::uint32_t {
+            Start = 0,
+            OnlyResult = 1 << 0,
+            OnlyCallback = 1 << 1,
+            Done = OnlyResult | OnlyCallback,
+            Exception = 1 << 2,
+            Waiting = 1 << 3,
+            Setting = 1 << 4,
         };
 
         /**
-         * fixes the internal bookkeeping for the future, including setting
-         * the state variable to the appropriate value and signalling any
-         * waiting threads to wake up
+         * Publishes the result that has already been constructed in the
+         * storage, wakes up any parked waiters and executes the callback if
+         * one was set before the result
+         */
+        void publish_result(std::uint32_t bits);
+
+        /**
+         * Constructs the result in the storage with the given function and
+         * publishes it.  The storage is claimed first, and if a result has
+         * already been set or is being set a FutureError with the error code
+         * promise_already_satisfied is thrown
          */
-        void after_set_value();
-        void after_set_exception();
+        template <typename Func>
+        void set_result(Func construct, std::uint32_t bits);
 
         /**
-         * Checking functions that make sure everything is okay in the future
-         * and if something is wrong they throw the appropriate exception
+         * Checking function that makes sure everything is okay in the future
+         * and if something is wrong throws the appropriate exception
          */
         void check_get() const;
-        void check_set_value() const;
 
         /**
-         * Executes the callback on this if there is a callback to execute
-         *
-         * The callback is executed inline within the scope of the function
-         * that called execute_callback, i.e. execution is not forwarded to
-         * another thread or something similar
-         *
-         * Locks are assumed to be held before this function is called and the
-         * lock is released right before the callback is executed
+         * Executes the callback inline and then resets it, this is only
+         * called by the thread that moved the state to Done
          */
-        void execute_callback(std::unique_lock<std::mutex>& lck);
+        void execute_callback();
 
         /**
-         * Synchronizy locking things
+         * The state word described above and a flag to mark that a future
+         * has been retrieved from the promise
          */
+        mutable std::atomic<std::uint32_t> state{Start};
         std::atomic_flag retrieved = ATOMIC_FLAG_INIT;
-        std::atomic<FutureState> state{FutureState::NotFulfilled};
-        mutable std::mutex mtx;
-        mutable std::condition_variable cv;
 
         /**
          * A union containing either an exception_ptr or a value, this should
@@ -199,7 +232,7 @@ namespace detail {
         /**
          * A callback functor to be called when the shared state has a value
          */
-        sharp::Function<void(FutureImpl<Type>&)> callback;
+        sharp::UniqueFunction<void(FutureImpl<Type>&)> callback;
     };
 
 } // namespace detail
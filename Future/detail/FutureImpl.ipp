@@ -4,8 +4,6 @@
 #include <sharp/Future/detail/FutureImpl.ipp>
 
 #include <exception>
-#include <condition_variable>
-#include <mutex>
 #include <initializer_list>
 #include <utility>
 #include <cassert>
@@ -19,92 +17,119 @@ namespace detail {
     template <typename Type>
     FutureImpl<Type>::~FutureImpl() {
         assert(!this->callback);
+
+        // nobody else can be looking at the state anymore, so a relaxed load
+        // is enough to know what is in the storage
+        auto state = this->state.load(std::memory_order_relaxed);
+        if (state & FutureState::Exception) {
+            this->get_exception_ptr().~exception_ptr();
+        } else if (state & FutureState::OnlyResult) {
+            this->get_value().~Type();
+        }
     }
 
     template <typename Type>
     void FutureImpl<Type>::wait() const {
 
-        // double checked locking, if the value has been set then just return
-        // because the value has been set; if not then wait on a mutex the
-        // regular way until the value has been set
-        if (this->state.load() != FutureState::NotFulfilled) {
+        // if the value has been set then just return, this is the fast path
+        // and involves no locking at all
+        if (this->state.load(std::memory_order_acquire)
+                & FutureState::OnlyResult) {
             return;
         }
 
-        // if the check above failed then the value has not been set, so sleep
-        // until the value is set
-        auto lck = std::unique_lock<std::mutex>{this->mtx};
-        while (this->state.load() == FutureState::NotFulfilled) {
-            this->cv.wait(lck);
+        // otherwise announce that there is a waiter and check the state one
+        // last time with the parking lot bucket locked, the producer checks
+        // the waiting bit after publishing the result and unparks with the
+        // same lock held, so the wakeup cannot be missed
+        auto state = this->state.fetch_or(FutureState::Waiting,
+                                          std::memory_order_acq_rel);
+        while (!(state & FutureState::OnlyResult)) {
+            sharp::park(this, [this]() {
+                return !(this->state.load(std::memory_order_acquire)
+                         & FutureState::OnlyResult);
+            });
+            state = this->state.load(std::memory_order_acquire);
         }
     }
 
     template <typename Type>
     template <typename... Args>
-    void FutureImpl<Type>::set_value_no_lock(Args&&... args) {
-        this->check_set_value();
-        new (&this->get_value()) Type{std::forward<Args>(args)...};
-        this->after_set_value();
+    void FutureImpl<Type>::set_value(Args&&... args) {
+        this->set_result([&]() {
+            new (&this->get_value()) Type{std::forward<Args>(args)...};
+        }, FutureState::OnlyResult);
     }
 
     template <typename Type>
     template <typename U, typename... Args>
-    void FutureImpl<Type>::set_value_no_lock(std::initializer_list<U> il,
-                                             Args&&... args) {
-        this->check_set_value();
-        new (&this->get_value()) Type{il, std::forward<Args>(args)...};
-        this->after_set_value();
+    void FutureImpl<Type>::set_value(std::initializer_list<U> il,
+                                     Args&&... args) {
+        this->set_result([&]() {
+            new (&this->get_value()) Type{il, std::forward<Args>(args)...};
+        }, FutureState::OnlyResult);
     }
 
     template <typename Type>
-    void FutureImpl<Type>::set_exception_no_lock(std::exception_ptr ptr) {
-        this->check_set_value();
-        new (&this->get_exception_ptr()) std::exception_ptr{ptr};
-        this->after_set_exception();
+    void FutureImpl<Type>::set_exception(std::exception_ptr ptr) {
+        this->set_result([&]() {
+            new (&this->get_exception_ptr()) std::exception_ptr{std::move(ptr)};
+        }, FutureState::OnlyResult | FutureState::Exception);
     }
 
     template <typename Type>
-    template <typename... Args>
-    void FutureImpl<Type>::set_value(Args&&... args) {
-
-        // acquire the lock and then construct the data item in the storage
-        // and execute the callback if there is one set
-        auto lck = std::unique_lock<std::mutex>{this->mtx};
-        this->set_value_no_lock(std::forward<Args>(args)...);
-        this->execute_callback(lck);
-    }
+    template <typename Func>
+    void FutureImpl<Type>::set_result(Func construct, std::uint32_t bits) {
 
-    template <typename Type>
-    template <typename U, typename... Args>
-    void FutureImpl<Type>::set_value(std::initializer_list<U> il,
-                                     Args&&... args) {
+        // claim the storage, the bit is never cleared once a result has been
+        // published so it alone tells whether someone else got here first
+        auto previous = this->state.fetch_or(FutureState::Setting,
+                                             std::memory_order_relaxed);
+        if (previous & FutureState::Setting) {
+            throw FutureError{FutureErrorCode::promise_already_satisfied};
+        }
 
-        // acquire the lock and then construct the data item in the storage
-        // and execute the callback if there is one set
-        auto lck = std::unique_lock<std::mutex>{this->mtx};
-        this->set_value_no_lock(il, std::forward<Args>(args)...);
-        this->execute_callback(lck);
+        // if constructing the result throws then nothing has been set, give
+        // the claim back so that the promise can still be fulfilled
+        try {
+            construct();
+        } catch (...) {
+            this->state.fetch_and(~FutureState::Setting,
+                                  std::memory_order_relaxed);
+            throw;
+        }
+        this->publish_result(bits);
     }
 
     template <typename Type>
-    void FutureImpl<Type>::set_exception(std::exception_ptr ptr) {
+    void FutureImpl<Type>::publish_result(std::uint32_t bits) {
+
+        // the release half of this publishes the storage to whoever sees the
+        // result bit and the acquire half makes the callback visible to us if
+        // it was set before
+        auto previous = this->state.fetch_or(bits, std::memory_order_acq_rel);
+
+        // wake up any parked threads, this only uses the address of the
+        // shared state so it is fine even if a woken thread has already
+        // destroyed it
+        if (previous & FutureState::Waiting) {
+            sharp::unpark_all(this);
+        }
 
-        // acquire the lock and then set the exception and execute the
-        // callback if there is one set
-        auto lck = std::unique_lock<std::mutex>{this->mtx};
-        this->set_exception_no_lock(ptr);
-        this->execute_callback(lck);
+        // if a callback was set before the result then this thread moved the
+        // state to Done and is responsible for running it
+        if (previous & FutureState::OnlyCallback) {
+            this->execute_callback();
+        }
     }
 
     template <typename Type>
     Type FutureImpl<Type>::get() {
 
-        // first wait for the result to be ready
+        // first wait for the result to be ready, after this the storage is
+        // visible to this thread
         this->wait();
 
-        // grab a lock and then do stuff
-        std::lock_guard<std::mutex> lck(this->mtx);
-
         // check and throw an exception if the future has already been
         // fulfilled, and then if not store state and return the moved value
         this->check_get();
@@ -116,9 +141,6 @@ namespace detail {
         // first wait for the result to be ready
         this->wait();
 
-        // grab a lock
-        std::lock_guard<std::mutex> lck(this->mtx);
-
         // check and throw an exception if the future has already been
         // fulfilled, and then if not store state and return the moved value
         this->check_get();
@@ -136,58 +158,58 @@ namespace detail {
     template <typename Func>
     void FutureImpl<Type>::add_callback(Func&& func) {
 
-        auto lck = std::unique_lock<std::mutex>{this->mtx};
-
         // this should not be called twice, and will only be called internally
         // so assert
         assert(!this->callback);
 
         // if the value or exception has already been set then call the
-        // functor now
-        if (this->state.load() != FutureState::NotFulfilled) {
-            lck.unlock();
+        // functor now without packing it up in a function object
+        if (this->state.load(std::memory_order_acquire)
+                & FutureState::OnlyResult) {
             std::forward<Func>(func)(*this);
-        } else {
-            // otherwise pack it up into a callback and store the callback
-            this->callback = std::forward<Func>(func);
+            return;
         }
-    }
 
-    template <typename Type>
-    void FutureImpl<Type>::check_get() const {
-        if (this->state.load() == FutureState::ContainsException) {
-            std::rethrow_exception(this->get_exception_ptr());
+        // otherwise store the callback and then publish it, if the result
+        // raced in between then this thread moved the state to Done and has
+        // to run the callback itself
+        this->callback = std::forward<Func>(func);
+        auto previous = this->state.fetch_or(FutureState::OnlyCallback,
+                std::memory_order_acq_rel);
+        if (previous & FutureState::OnlyResult) {
+            this->execute_callback();
         }
     }
 
     template <typename Type>
-    void FutureImpl<Type>::check_set_value() const {
-        auto state = this->state.load();
-        if (state == FutureState::ContainsException
-                || state == FutureState::ContainsValue) {
-            throw FutureError{FutureErrorCode::promise_already_satisfied};
+    bool FutureImpl<Type>::remove_callback() {
+
+        // take the callback bit back before the producer sets the result
+        // bit, the producer then never sees the callback.  If the result is
+        // already there then the callback belongs to whoever set it
+        auto state = this->state.load(std::memory_order_acquire);
+        while (!(state & FutureState::OnlyResult)) {
+            assert(state & FutureState::OnlyCallback);
+            if (this->state.compare_exchange_weak(
+                        state, state & ~FutureState::OnlyCallback,
+                        std::memory_order_acq_rel)) {
+                this->callback = std::decay_t<decltype(this->callback)>{};
+                return true;
+            }
         }
+        return false;
     }
 
     template <typename Type>
-    void FutureImpl<Type>::after_set_value() {
-        this->state.store(FutureState::ContainsValue);
-        this->cv.notify_one();
-    }
-
-    template <typename Type>
-    void FutureImpl<Type>::after_set_exception() {
-        this->state.store(FutureState::ContainsException);
-        this->cv.notify_one();
+    void FutureImpl<Type>::check_get() const {
+        if (this->contains_exception()) {
+            std::rethrow_exception(this->get_exception_ptr());
+        }
     }
 
     template <typename Type>
-    void FutureImpl<Type>::execute_callback(std::unique_lock<std::mutex>& lck) {
-        assert(lck.owns_lock());
-        if (!this->callback) {
-            return;
-        }
-        lck.unlock();
+    void FutureImpl<Type>::execute_callback() {
+        assert(this->callback);
 
         // execute the callback and then hard reset the function object
         this->callback(*this);
@@ -196,13 +218,14 @@ namespace detail {
 
     template <typename Type>
     bool FutureImpl<Type>::is_ready() const noexcept {
-        return (this->state.load() != FutureState::NotFulfilled);
+        return this->state.load(std::memory_order_acquire)
+            & FutureState::OnlyResult;
     }
 
     template <typename Type>
-    bool FutureImpl<Type>::contains_exception() const {
-        std::lock_guard<std::mutex> lck{this->mtx};
-        return (this->state.load() == FutureState::ContainsException);
+    bool FutureImpl<Type>::contains_exception() const noexcept {
+        return this->state.load(std::memory_order_acquire)
+            & FutureState::Exception;
     }
 
     template <typename Type>
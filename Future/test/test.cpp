@@ -1,4 +1,5 @@
 #include <sharp/Future/Future.hpp>
+#include <sharp/Executor/TimingWheelExecutor.hpp>
 #include <sharp/Threads/Threads.hpp>
 
 #include <gtest/gtest.h>
@@ -8,6 +9,10 @@
 #include <utility>
 #include <iostream>
 #include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
 
 TEST(Future, Basic) {
     auto promise = sharp::Promise<int>{};
@@ -680,3 +685,160 @@ TEST(Future, MakeExceptionalFutureWithExceptionPtr) {
         EXPECT_EQ(value, 1.0);
     }
 }
+
+TEST(Future, ThenRacesWithSetValue) {
+    // the callback and the result race to be set second, whichever wins has
+    // to run the callback exactly once
+    for (auto i = 0; i < 1e3; ++i) {
+        auto promise = sharp::Promise<int>{};
+        auto future = promise.get_future();
+        auto counter = std::make_shared<std::atomic<int>>(0);
+
+        auto th = std::thread{[&]() {
+            promise.set_value(i);
+        }};
+        auto next = future.then([counter](auto future) {
+            ++(*counter);
+            return future.get();
+        });
+        th.join();
+
+        EXPECT_EQ(next.get(), i);
+        EXPECT_EQ(counter->load(), 1);
+    }
+}
+
+TEST(Future, SetValueRacesWithSetValue) {
+    // exactly one of two racing results makes it into the shared state and
+    // the other one gets promise_already_satisfied
+    for (auto i = 0; i < 1e3; ++i) {
+        auto promise = sharp::Promise<std::vector<int>>{};
+        auto future = promise.get_future();
+        std::atomic<int> failed{0};
+
+        auto set = [&](int value) {
+            try {
+                promise.set_value(std::vector<int>(10, value));
+            } catch (sharp::FutureError& err) {
+                EXPECT_EQ(err.code().value(), static_cast<int>(
+                    sharp::FutureErrorCode::promise_already_satisfied));
+                ++failed;
+            }
+        };
+        auto th = std::thread{[&]() { set(1); }};
+        set(2);
+        th.join();
+
+        EXPECT_EQ(failed.load(), 1);
+        auto value = future.get();
+        EXPECT_EQ(value.size(), 10);
+        EXPECT_TRUE(value == std::vector<int>(10, value.front()));
+    }
+}
+
+TEST(Future, WaitFromManyThreads) {
+    auto promise = sharp::Promise<int>{};
+    auto future = promise.get_future().share();
+
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < 10; ++i) {
+        threads.push_back(std::thread{[future]() {
+            future.wait();
+            EXPECT_EQ(future.get(), 1);
+        }});
+    }
+    promise.set_value(1);
+    for (auto& th : threads) {
+        th.join();
+    }
+}
+
+TEST(Future, WithinValue) {
+    auto promise = sharp::Promise<int>{};
+    auto future = promise.get_future().within(std::chrono::hours{1});
+    EXPECT_FALSE(future.is_ready());
+    promise.set_value(1);
+    EXPECT_EQ(future.get(), 1);
+
+    // already ready futures do not need a timer at all
+    auto ready = sharp::make_ready_future(2).within(std::chrono::hours{1});
+    EXPECT_EQ(ready.get(), 2);
+}
+
+TEST(Future, WithinException) {
+    auto promise = sharp::Promise<int>{};
+    auto future = promise.get_future().within(std::chrono::hours{1});
+    promise.set_exception(std::make_exception_ptr(std::runtime_error{""}));
+    try {
+        future.get();
+        EXPECT_TRUE(false);
+    } catch (std::runtime_error&) {}
+}
+
+TEST(Future, WithinTimeout) {
+    // the timed out future completes without the producer and the state
+    // hanging off of it is released before the producer gets to it
+    auto promise = sharp::Promise<int>{};
+    auto resource = std::make_shared<int>(0);
+    auto future = promise.get_future().within(std::chrono::milliseconds{10})
+        .then([resource](auto future) {
+            try {
+                future.get();
+            } catch (sharp::FutureError& err) {
+                EXPECT_EQ(err.code(), std::make_error_code(
+                            sharp::FutureErrorCode::timeout));
+                return 1;
+            }
+            return 0;
+        });
+    EXPECT_EQ(future.get(), 1);
+    EXPECT_EQ(resource.use_count(), 1);
+
+    // the late result goes nowhere
+    promise.set_value(2);
+}
+
+TEST(Future, OnTimeout) {
+    auto promise = sharp::Promise<int>{};
+    sharp::TimingWheelExecutor timer;
+    auto future = promise.get_future().on_timeout(
+            std::chrono::milliseconds{10}, []() { return 3; }, &timer);
+    EXPECT_EQ(future.get(), 3);
+
+    auto promise_two = sharp::Promise<int>{};
+    auto future_two = promise_two.get_future().on_timeout(
+            std::chrono::hours{1}, []() { return 3; }, &timer);
+    promise_two.set_value(4);
+    EXPECT_EQ(future_two.get(), 4);
+}
+
+TEST(Future, ViaPriority) {
+    class RecordingExecutor : public sharp::Executor {
+    public:
+        void add(sharp::UniqueFunction<void()> closure) override {
+            this->add_with_priority(std::move(closure),
+                                    sharp::Executor::MID_PRI);
+        }
+        void add_with_priority(sharp::UniqueFunction<void()> closure,
+                               std::int8_t priority) override {
+            this->priorities.push_back(priority);
+            closure();
+        }
+        std::vector<std::int8_t> priorities;
+    };
+
+    // the priority sticks to the chain till it is changed with via()
+    RecordingExecutor executor;
+    auto promise = sharp::Promise<int>{};
+    auto future = promise.get_future()
+        .via(&executor, sharp::Executor::HI_PRI)
+        .then([](auto future) { return future.get() + 1; })
+        .then([](auto future) { return future.get() + 1; })
+        .via(&executor)
+        .then([](auto future) { return future.get() + 1; });
+    promise.set_value(0);
+    EXPECT_EQ(future.get(), 3);
+    EXPECT_EQ(executor.priorities, (std::vector<std::int8_t>{
+        sharp::Executor::HI_PRI, sharp::Executor::HI_PRI,
+        sharp::Executor::MID_PRI}));
+}
@@ -0,0 +1,122 @@
+/**
+ * @file DistributedSharedMutex.hpp
+ * @author Aaryaman Sagar
+ *
+ * A reader writer lock that spreads readers over many cache lines, so that
+ * read locking scales with the number of cores instead of serializing on the
+ * one cache line a regular shared mutex keeps its reader count in
+ *
+ *      sharp::Concurrent<Config, sharp::DistributedSharedMutex> config;
+ *
+ *      // readers on different cores do not contend with each other
+ *      auto port = sharp::as_const(config).lock()->port;
+ */
+
+#pragma once
+
+#include <sharp/Mutex/Mutex.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace sharp {
+
+namespace mutex_detail {
+
+    /**
+     * The number of reader slots, threads are assigned a slot round robin
+     * the first time they read lock any distributed shared mutex
+     */
+    constexpr auto READER_SLOTS = std::size_t{64};
+
+    /**
+     * Returns the slot the calling thread counts itself in
+     */
+    inline std::size_t reader_slot();
+
+} // namespace mutex_detail
+
+/**
+ * @class DistributedSharedMutex
+ *
+ * Every thread is assigned one of a fixed number of reader slots, each on a
+ * cache line of its own, and a reader announces itself by incrementing the
+ * count in its slot and then checking that no writer is around.  Readers on
+ * different slots never write to the same cache line, and all they share is
+ * a read of the writer word, which every core can keep in its cache as long
+ * as no writer comes along
+ *
+ * A writer takes a mutex to keep other writers out, sets the writer word
+ * and then waits for the count in every slot to drop to zero.  Readers that
+ * see the writer word set back out and wait till it is cleared.  So writes
+ * are much more expensive than with a regular shared mutex, this is only a
+ * good trade when reads vastly outnumber writes
+ *
+ * Threads that have to wait park in the parking lot.  The lock is not
+ * recursive, a thread that holds a read lock must not read lock again while
+ * a writer might be waiting, as is the case for other shared mutexes that
+ * prefer writers
+ *
+ * This meets the SharedLockable requirements so it can be used as the mutex
+ * of a Concurrent, where const lock() calls acquire it in shared mode
+ */
+class DistributedSharedMutex {
+public:
+
+    DistributedSharedMutex() = default;
+    DistributedSharedMutex(const DistributedSharedMutex&) = delete;
+    DistributedSharedMutex& operator=(const DistributedSharedMutex&) = delete;
+
+    /**
+     * Exclusive locking
+     */
+    void lock();
+    bool try_lock();
+    void unlock();
+
+    /**
+     * Shared locking, these have to be called from the same thread for a
+     * given lock since the slot a reader counts itself in is picked by
+     * thread
+     */
+    void lock_shared();
+    bool try_lock_shared();
+    void unlock_shared();
+
+private:
+
+    /**
+     * The bits of the writer word.  WRITER is set while a writer holds or is
+     * acquiring the lock, READERS_PARKED is set by readers that are about to
+     * park waiting for the writer and WRITER_PARKED is set by a writer that
+     * is about to park waiting for readers to leave
+     */
+    static constexpr auto WRITER = std::uint32_t{1};
+    static constexpr auto READERS_PARKED = std::uint32_t{1} << 1;
+    static constexpr auto WRITER_PARKED = std::uint32_t{1} << 2;
+
+    /**
+     * Announce a reader in the slot and return whether no writer was seen,
+     * if a writer was seen the announcement is withdrawn
+     */
+    bool try_lock_shared(std::atomic<std::uint32_t>& slot);
+
+    /**
+     * Waits till every slot is empty, called by a writer that has set the
+     * writer bit
+     */
+    void wait_for_readers();
+
+    struct alignas(64) Slot {
+        std::atomic<std::uint32_t> readers{0};
+    };
+
+    Slot slots[mutex_detail::READER_SLOTS];
+    alignas(64) std::atomic<std::uint32_t> writer{0};
+    sharp::Mutex<> writers;
+};
+
+} // namespace sharp
+
+#include <sharp/Mutex/DistributedSharedMutex.ipp>
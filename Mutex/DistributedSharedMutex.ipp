@@ -0,0 +1,129 @@
+#include <sharp/Mutex/DistributedSharedMutex.hpp>
+#include <sharp/Threads/ParkingLot.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace sharp {
+
+namespace mutex_detail {
+
+    /**
+     * The number of times a writer yields while waiting for a slot to empty
+     * before it parks
+     */
+    constexpr auto READER_WAIT_YIELDS = 16;
+
+    inline std::size_t reader_slot() {
+        static std::atomic<std::size_t> next{0};
+        thread_local auto slot
+            = next.fetch_add(1, std::memory_order_relaxed) % READER_SLOTS;
+        return slot;
+    }
+
+} // namespace mutex_detail
+
+inline void DistributedSharedMutex::lock() {
+    // the writer bit and the reader counts are written and read with
+    // sequentially consistent operations, so either the writer sees a
+    // reader's count or the reader sees the writer bit and backs out
+    this->writers.lock();
+    this->writer.fetch_or(WRITER, std::memory_order_seq_cst);
+    this->wait_for_readers();
+}
+
+inline bool DistributedSharedMutex::try_lock() {
+    if (!this->writers.try_lock()) {
+        return false;
+    }
+    this->writer.fetch_or(WRITER, std::memory_order_seq_cst);
+    for (auto& slot : this->slots) {
+        if (slot.readers.load(std::memory_order_seq_cst)) {
+            this->unlock();
+            return false;
+        }
+    }
+    return true;
+}
+
+inline void DistributedSharedMutex::unlock() {
+    auto state = this->writer.exchange(0, std::memory_order_seq_cst);
+    this->writers.unlock();
+    if (state & READERS_PARKED) {
+        sharp::unpark_all(&this->writer);
+    }
+}
+
+inline void DistributedSharedMutex::lock_shared() {
+    auto& slot = this->slots[mutex_detail::reader_slot()].readers;
+    while (!this->try_lock_shared(slot)) {
+
+        // a writer that sees the readers parked bit unparks everyone when it
+        // unlocks, the bit is set before checking the word one last time
+        // with the parking lot bucket locked so the wakeup cannot be missed.
+        // Both bits have to still be set, an unlock clears the parked bit
+        // and the next writer only sets its own, so that writer would not
+        // know to wake this reader
+        auto state = this->writer.fetch_or(READERS_PARKED,
+                                           std::memory_order_seq_cst);
+        if (state & WRITER) {
+            sharp::park(&this->writer, [this]() {
+                auto both = WRITER | READERS_PARKED;
+                return (this->writer.load(std::memory_order_seq_cst) & both)
+                    == both;
+            });
+        }
+    }
+}
+
+inline bool DistributedSharedMutex::try_lock_shared() {
+    return this->try_lock_shared(
+        this->slots[mutex_detail::reader_slot()].readers);
+}
+
+inline void DistributedSharedMutex::unlock_shared() {
+    // a writer that parks waiting for readers sets its bit before checking
+    // the counts one last time, so either this sees the bit or the writer
+    // sees the decremented count
+    auto& slot = this->slots[mutex_detail::reader_slot()].readers;
+    slot.fetch_sub(1, std::memory_order_seq_cst);
+    if (this->writer.load(std::memory_order_seq_cst) & WRITER_PARKED) {
+        sharp::unpark_one(&this->slots);
+    }
+}
+
+inline bool DistributedSharedMutex::try_lock_shared(
+        std::atomic<std::uint32_t>& slot) {
+    slot.fetch_add(1, std::memory_order_seq_cst);
+    if (!(this->writer.load(std::memory_order_seq_cst) & WRITER)) {
+        return true;
+    }
+
+    // back out, this might be holding up a writer that is waiting for the
+    // slot to empty
+    slot.fetch_sub(1, std::memory_order_seq_cst);
+    if (this->writer.load(std::memory_order_seq_cst) & WRITER_PARKED) {
+        sharp::unpark_one(&this->slots);
+    }
+    return false;
+}
+
+inline void DistributedSharedMutex::wait_for_readers() {
+    for (auto& slot : this->slots) {
+        for (auto i = 0; i < mutex_detail::READER_WAIT_YIELDS
+                && slot.readers.load(std::memory_order_seq_cst); ++i) {
+            std::this_thread::yield();
+        }
+
+        while (slot.readers.load(std::memory_order_seq_cst)) {
+            this->writer.fetch_or(WRITER_PARKED, std::memory_order_seq_cst);
+            sharp::park(&this->slots, [&slot]() {
+                return slot.readers.load(std::memory_order_seq_cst) != 0;
+            });
+        }
+    }
+}
+
+} // namespace sharp
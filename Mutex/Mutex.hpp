@@ -0,0 +1,227 @@
+/**
+ * @file Mutex.hpp
+ * @author Aaryaman Sagar
+ *
+ * Locks that fit in a single byte or less, for when there are so many of
+ * them that the 40 bytes of a std::mutex adds up.  The bits of the storage
+ * that the lock does not use are handed back to the user as a small integer
+ *
+ *      sharp::Mutex<std::uint8_t> mutex;
+ *
+ *      auto data = mutex.lock_fetch();
+ *      ++(*data);
+ *      data.unlock();
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace sharp {
+
+namespace mutex_detail {
+
+    /**
+     * @class ValueProxy
+     *
+     * Returned by lock_fetch(), holds the lock along with a copy of the
+     * integer embedded in the lock.  The copy is written back into the lock
+     * on unlock, and the unlock throws a std::overflow_error if the value
+     * has spilled into the bits used by the lock.  In that case the lock is
+     * released with the old value, and since this happens in a destructor
+     * when the proxy is not unlocked explicitly, the program terminates with
+     * the error
+     */
+    template <typename Lock>
+    class ValueProxy {
+    public:
+
+        using value_type = typename Lock::value_type;
+
+        ValueProxy(ValueProxy&&) noexcept;
+        ~ValueProxy();
+
+        void unlock();
+
+        value_type* operator->();
+        value_type& operator*();
+
+        friend Lock;
+    private:
+        explicit ValueProxy(Lock&);
+
+        ValueProxy(const ValueProxy&) = delete;
+        ValueProxy& operator=(const ValueProxy&) = delete;
+        ValueProxy& operator=(ValueProxy&&) = delete;
+
+        Lock* lock_ptr{nullptr};
+        value_type value;
+    };
+
+    /**
+     * Unsigned integers are the only ones that have a sensible notion of
+     * which bits are the most significant
+     */
+    template <typename Int>
+    constexpr auto IsUnsignedInteger = std::is_integral<Int>::value
+        && std::is_unsigned<Int>::value && !std::is_same<Int, bool>::value;
+
+    /**
+     * The deadline for lock acquisitions that do not time out
+     */
+    class NoDeadline {};
+
+} // namespace mutex_detail
+
+/**
+ * @class Spinlock
+ *
+ * A test and test and set spinlock that takes up the most significant bit of
+ * the integer it is instantiated with.  Waiting threads back off
+ * exponentially while the lock is held and yield the processor once they
+ * have spun for long enough, but never sleep.  Use this when the critical
+ * sections are a handful of instructions
+ */
+template <typename Int = std::uint8_t>
+class Spinlock {
+public:
+
+    static_assert(mutex_detail::IsUnsignedInteger<Int>,
+            "sharp::Spinlock can only embed an unsigned integer");
+
+    using value_type = Int;
+
+    /**
+     * The largest value that can be stored in the embedded integer
+     */
+    static constexpr Int max_value = std::numeric_limits<Int>::max() >> 1;
+
+    /**
+     * Initializes the lock unlocked, with the value of the embedded integer
+     * set to the one passed.  The value has to fit, otherwise the
+     * constructor throws a std::overflow_error
+     */
+    Spinlock() = default;
+    explicit Spinlock(Int value);
+
+    Spinlock(const Spinlock&) = delete;
+    Spinlock& operator=(const Spinlock&) = delete;
+
+    /**
+     * The Lockable interface
+     */
+    void lock() noexcept;
+    bool try_lock() noexcept;
+    void unlock() noexcept;
+
+    /**
+     * Locks and returns a proxy through which the embedded integer can be
+     * read and modified, see mutex_detail::ValueProxy
+     */
+    mutex_detail::ValueProxy<Spinlock> lock_fetch() noexcept;
+
+    template <typename> friend class mutex_detail::ValueProxy;
+private:
+    static constexpr Int LOCKED = static_cast<Int>(max_value + 1);
+
+    void unlock_store(Int value) noexcept;
+    Int load_value() const noexcept;
+
+    std::atomic<Int> state{0};
+};
+
+/**
+ * @class Mutex
+ *
+ * A sleeping mutex that takes up the two most significant bits of the
+ * integer it is instantiated with, one bit to mark the lock as held and one
+ * to mark that there might be threads asleep waiting for it
+ *
+ * Locking is a single atomic fetch_or when the mutex is free.  When it is
+ * not, the thread spins with exponential backoff for a bounded amount of
+ * time and goes to sleep if the lock is still held after that.  The spin is
+ * skipped when there are threads asleep on the mutex already, since then the
+ * holder has held the lock long enough to make spinning a waste.  Unlocking
+ * is a single atomic and when there are sleepers, waking one of them up
+ *
+ * Sleeping threads are parked on the address of the mutex in the process
+ * wide parking lot, see sharp::park(), so the mutex does not need any space
+ * of its own for them
+ */
+template <typename Int = std::uint8_t>
+class Mutex {
+public:
+
+    static_assert(mutex_detail::IsUnsignedInteger<Int>,
+            "sharp::Mutex can only embed an unsigned integer");
+
+    using value_type = Int;
+
+    /**
+     * The largest value that can be stored in the embedded integer
+     */
+    static constexpr Int max_value = std::numeric_limits<Int>::max() >> 2;
+
+    /**
+     * Initializes the mutex unlocked, with the value of the embedded integer
+     * set to the one passed.  The value has to fit, otherwise the
+     * constructor throws a std::overflow_error
+     */
+    Mutex() = default;
+    explicit Mutex(Int value);
+
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    /**
+     * The TimedLockable interface
+     */
+    void lock() noexcept;
+    bool try_lock() noexcept;
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& duration);
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& tp);
+    void unlock() noexcept;
+
+    /**
+     * Locks and returns a proxy through which the embedded integer can be
+     * read and modified, see mutex_detail::ValueProxy
+     */
+    mutex_detail::ValueProxy<Mutex> lock_fetch() noexcept;
+
+    template <typename> friend class mutex_detail::ValueProxy;
+private:
+    static constexpr Int LOCKED = static_cast<Int>((max_value + 1) << 1);
+    static constexpr Int CONTENDED = static_cast<Int>(max_value + 1);
+
+    /**
+     * Spins for a while and returns whether the lock was acquired
+     */
+    bool spin() noexcept;
+
+    /**
+     * Parks till the lock is acquired or the deadline passes
+     */
+    template <typename Deadline>
+    bool lock_slow(const Deadline& deadline);
+
+    /**
+     * Wakes up a thread sleeping on the mutex if the state from before
+     * the unlock says there might be one
+     */
+    void wake(Int state) noexcept;
+
+    void unlock_store(Int value) noexcept;
+    Int load_value() const noexcept;
+
+    std::atomic<Int> state{0};
+};
+
+} // namespace sharp
+
+#include <sharp/Mutex/Mutex.ipp>
@@ -0,0 +1,255 @@
+#include <sharp/Mutex/Mutex.hpp>
+#include <sharp/Mutex/detail/Backoff.hpp>
+#include <sharp/Threads/ParkingLot.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace sharp {
+
+namespace mutex_detail {
+
+    template <typename Int>
+    Int check_value(Int value, Int max_value) {
+        if (value > max_value) {
+            throw std::overflow_error{"The value " + std::to_string(value)
+                + " does not fit in the bits of the lock available to it, "
+                + "the largest value that can be stored is "
+                + std::to_string(max_value)};
+        }
+        return value;
+    }
+
+    template <typename Validate>
+    ParkResult park(const void* address, Validate validate,
+                    const NoDeadline&) {
+        return sharp::park(address, validate);
+    }
+    template <typename Validate, typename Clock, typename Duration>
+    ParkResult park(const void* address, Validate validate,
+                    const std::chrono::time_point<Clock, Duration>& tp) {
+        return sharp::park_until(address, validate, tp);
+    }
+
+    /**
+     * Implementations for the value proxy
+     */
+    template <typename Lock>
+    ValueProxy<Lock>::ValueProxy(Lock& lock)
+            : lock_ptr{&lock}, value{lock.load_value()} {}
+
+    template <typename Lock>
+    ValueProxy<Lock>::ValueProxy(ValueProxy&& other) noexcept
+            : lock_ptr{other.lock_ptr}, value{other.value} {
+        other.lock_ptr = nullptr;
+    }
+
+    template <typename Lock>
+    ValueProxy<Lock>::~ValueProxy() {
+        this->unlock();
+    }
+
+    template <typename Lock>
+    void ValueProxy<Lock>::unlock() {
+        if (!this->lock_ptr) {
+            return;
+        }
+
+        // release the lock before throwing so the lock is not held forever,
+        // the value the lock had before it was locked stays as is
+        auto lock_ptr = this->lock_ptr;
+        this->lock_ptr = nullptr;
+        if (this->value > Lock::max_value) {
+            lock_ptr->unlock();
+            check_value(this->value, Lock::max_value);
+        }
+        lock_ptr->unlock_store(this->value);
+    }
+
+    template <typename Lock>
+    auto ValueProxy<Lock>::operator->() -> value_type* {
+        return &this->value;
+    }
+
+    template <typename Lock>
+    auto ValueProxy<Lock>::operator*() -> value_type& {
+        return this->value;
+    }
+
+} // namespace mutex_detail
+
+/**
+ * Implementations for the spinlock
+ */
+template <typename Int>
+constexpr Int Spinlock<Int>::max_value;
+template <typename Int>
+constexpr Int Spinlock<Int>::LOCKED;
+
+template <typename Int>
+Spinlock<Int>::Spinlock(Int value)
+        : state{mutex_detail::check_value(value, max_value)} {}
+
+template <typename Int>
+void Spinlock<Int>::lock() noexcept {
+    // spin on a load so that waiting threads share the cache line instead
+    // of bouncing it between each other with atomic writes
+    auto backoff = mutex_detail::Backoff{};
+    while (!this->try_lock()) {
+        do {
+            backoff.pause();
+        } while (this->state.load(std::memory_order_relaxed) & LOCKED);
+    }
+}
+
+template <typename Int>
+bool Spinlock<Int>::try_lock() noexcept {
+    return !(this->state.fetch_or(LOCKED, std::memory_order_acquire)
+             & LOCKED);
+}
+
+template <typename Int>
+void Spinlock<Int>::unlock() noexcept {
+    this->state.fetch_and(max_value, std::memory_order_release);
+}
+
+template <typename Int>
+mutex_detail::ValueProxy<Spinlock<Int>> Spinlock<Int>::lock_fetch()
+        noexcept {
+    this->lock();
+    return mutex_detail::ValueProxy<Spinlock>{*this};
+}
+
+template <typename Int>
+void Spinlock<Int>::unlock_store(Int value) noexcept {
+    // the value bits only change with the lock held, so a plain store is
+    // enough here
+    this->state.store(value, std::memory_order_release);
+}
+
+template <typename Int>
+Int Spinlock<Int>::load_value() const noexcept {
+    return this->state.load(std::memory_order_relaxed) & max_value;
+}
+
+/**
+ * Implementations for the mutex
+ */
+template <typename Int>
+constexpr Int Mutex<Int>::max_value;
+template <typename Int>
+constexpr Int Mutex<Int>::LOCKED;
+template <typename Int>
+constexpr Int Mutex<Int>::CONTENDED;
+
+template <typename Int>
+Mutex<Int>::Mutex(Int value)
+        : state{mutex_detail::check_value(value, max_value)} {}
+
+template <typename Int>
+void Mutex<Int>::lock() noexcept {
+    if (this->try_lock() || this->spin()) {
+        return;
+    }
+    this->lock_slow(mutex_detail::NoDeadline{});
+}
+
+template <typename Int>
+bool Mutex<Int>::try_lock() noexcept {
+    return !(this->state.fetch_or(LOCKED, std::memory_order_acquire)
+             & LOCKED);
+}
+
+template <typename Int>
+template <typename Rep, typename Period>
+bool Mutex<Int>::try_lock_for(
+        const std::chrono::duration<Rep, Period>& duration) {
+    return this->try_lock_until(std::chrono::steady_clock::now() + duration);
+}
+
+template <typename Int>
+template <typename Clock, typename Duration>
+bool Mutex<Int>::try_lock_until(
+        const std::chrono::time_point<Clock, Duration>& tp) {
+    if (this->try_lock() || this->spin()) {
+        return true;
+    }
+    return this->lock_slow(tp);
+}
+
+template <typename Int>
+void Mutex<Int>::unlock() noexcept {
+    this->wake(this->state.fetch_and(max_value, std::memory_order_release));
+}
+
+template <typename Int>
+mutex_detail::ValueProxy<Mutex<Int>> Mutex<Int>::lock_fetch() noexcept {
+    this->lock();
+    return mutex_detail::ValueProxy<Mutex>{*this};
+}
+
+template <typename Int>
+bool Mutex<Int>::spin() noexcept {
+    // once a thread has gone to sleep the lock is being held for longer than
+    // the spin, so spinning would only burn cycles
+    auto backoff = mutex_detail::Backoff{};
+    while (backoff.spin()) {
+        auto state = this->state.load(std::memory_order_relaxed);
+        if (state & CONTENDED) {
+            return false;
+        }
+        if (!(state & LOCKED) && this->try_lock()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename Int>
+template <typename Deadline>
+bool Mutex<Int>::lock_slow(const Deadline& deadline) {
+    // a thread that acquires the lock here does not know whether there are
+    // other threads parked, so it leaves the contended bit set and the
+    // unlock goes through the wake path.  The state is checked again with
+    // the lock on the parking lot bucket held, and the unlock unparks with
+    // the same lock held after it clears the state, so the wakeup cannot be
+    // missed
+    while (this->state.fetch_or(LOCKED | CONTENDED, std::memory_order_acquire)
+            & LOCKED) {
+        auto result = mutex_detail::park(this, [this]() {
+            auto state = this->state.load(std::memory_order_relaxed);
+            return (state & (LOCKED | CONTENDED)) == (LOCKED | CONTENDED);
+        }, deadline);
+        if (result == ParkResult::Timeout) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Int>
+void Mutex<Int>::unlock_store(Int value) noexcept {
+    // the value bits only change with the lock held, so they can be
+    // overwritten as a whole, but the contended bit can be set concurrently
+    // so this has to read the old state atomically with the write
+    this->wake(this->state.exchange(value, std::memory_order_release));
+}
+
+template <typename Int>
+void Mutex<Int>::wake(Int state) noexcept {
+    // only one thread is woken up, when it gets the lock it sets the
+    // contended bit again so its unlock wakes up the next one
+    if (state & CONTENDED) {
+        sharp::unpark_one(this);
+    }
+}
+
+template <typename Int>
+Int Mutex<Int>::load_value() const noexcept {
+    return this->state.load(std::memory_order_relaxed) & max_value;
+}
+
+} // namespace sharp
@@ -0,0 +1,78 @@
+/**
+ * @file Backoff.hpp
+ * @author Aaryaman Sagar
+ *
+ * The spinning helpers shared by the locks in this module
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace sharp {
+namespace mutex_detail {
+
+    /**
+     * The longest a single backoff round pauses for, in pause instructions.
+     * The delay doubles every round so this bounds the total spin to a bit
+     * under twice this many pauses
+     */
+    constexpr auto MAX_BACKOFF = std::uint32_t{256};
+
+    /**
+     * Tells the processor that this is a spin wait loop, this frees up
+     * resources for the other hyperthread on the core and avoids the memory
+     * order mis-speculation penalty when the loop exits
+     */
+    inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield" ::: "memory");
+#else
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+    /**
+     * @class Backoff
+     *
+     * Exponential backoff for spin loops.  Each round pauses twice as long as
+     * the previous one till MAX_BACKOFF is crossed, after which spin()
+     * returns false to tell the caller to stop spinning
+     */
+    class Backoff {
+    public:
+        bool spin() {
+            if (this->delay > MAX_BACKOFF) {
+                return false;
+            }
+            for (auto i = std::uint32_t{0}; i < this->delay; ++i) {
+                cpu_relax();
+            }
+            this->delay <<= 1;
+            return true;
+        }
+
+        /**
+         * Spins if there is budget left and yields the processor otherwise,
+         * for locks that never sleep
+         */
+        void pause() {
+            if (!this->spin()) {
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+        std::uint32_t delay{1};
+    };
+
+} // namespace mutex_detail
+} // namespace sharp
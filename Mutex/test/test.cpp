@@ -0,0 +1,238 @@
+#include <sharp/Mutex/Mutex.hpp>
+#include <sharp/Mutex/DistributedSharedMutex.hpp>
+#include <sharp/Concurrent/Concurrent.hpp>
+#include <sharp/Threads/UniqueLock.hpp>
+#include <sharp/Utility/Utility.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    template <typename Lock>
+    void test_counter() {
+        constexpr auto THREADS = 4;
+        constexpr auto ITERATIONS = 5000;
+
+        Lock lock;
+        auto counter = 0;
+        auto threads = std::vector<std::thread>{};
+        for (auto i = 0; i < THREADS; ++i) {
+            threads.emplace_back([&]() {
+                for (auto j = 0; j < ITERATIONS; ++j) {
+                    auto lck = std::unique_lock<Lock>{lock};
+                    ++counter;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        EXPECT_EQ(counter, THREADS * ITERATIONS);
+    }
+
+} // namespace <anonymous>
+
+TEST(Mutex, Size) {
+    EXPECT_EQ(sizeof(sharp::Spinlock<>), 1);
+    EXPECT_EQ(sizeof(sharp::Mutex<>), 1);
+    EXPECT_EQ(sizeof(sharp::Mutex<std::uint32_t>), 4);
+    EXPECT_EQ(sharp::Spinlock<>::max_value, 0b01111111);
+    EXPECT_EQ(sharp::Mutex<>::max_value, 0b00111111);
+}
+
+TEST(Mutex, SpinlockBasic) {
+    sharp::Spinlock<> lock;
+    lock.lock();
+    EXPECT_FALSE(lock.try_lock());
+    lock.unlock();
+    EXPECT_TRUE(lock.try_lock());
+    lock.unlock();
+}
+
+TEST(Mutex, MutexBasic) {
+    sharp::Mutex<> mutex;
+    mutex.lock();
+    EXPECT_FALSE(mutex.try_lock());
+    EXPECT_FALSE(mutex.try_lock_for(std::chrono::milliseconds{1}));
+    mutex.unlock();
+    EXPECT_TRUE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST(Mutex, LockFetch) {
+    sharp::Mutex<std::uint8_t> mutex{3};
+    {
+        auto data = mutex.lock_fetch();
+        EXPECT_EQ(*data, 3);
+        EXPECT_FALSE(mutex.try_lock());
+        *data = sharp::Mutex<std::uint8_t>::max_value;
+    }
+    {
+        auto data = mutex.lock_fetch();
+        EXPECT_EQ(*data, sharp::Mutex<std::uint8_t>::max_value);
+    }
+
+    // the value is preserved across a plain lock and unlock
+    mutex.lock();
+    mutex.unlock();
+    sharp::Spinlock<std::uint16_t> spinlock{1000};
+    spinlock.lock();
+    spinlock.unlock();
+    EXPECT_EQ(*mutex.lock_fetch(), sharp::Mutex<std::uint8_t>::max_value);
+    EXPECT_EQ(*spinlock.lock_fetch(), 1000);
+}
+
+TEST(Mutex, Overflow) {
+    EXPECT_THROW(sharp::Mutex<std::uint8_t>{0b01000000}, std::overflow_error);
+    EXPECT_THROW(sharp::Spinlock<std::uint8_t>{0b10000000},
+                 std::overflow_error);
+
+    // the write does not go through and the lock is released
+    sharp::Mutex<std::uint8_t> mutex{1};
+    auto data = mutex.lock_fetch();
+    *data = 0b11000000;
+    EXPECT_THROW(data.unlock(), std::overflow_error);
+    EXPECT_TRUE(mutex.try_lock());
+    mutex.unlock();
+    EXPECT_EQ(*mutex.lock_fetch(), 1);
+}
+
+TEST(Mutex, SpinlockThreaded) {
+    test_counter<sharp::Spinlock<>>();
+}
+
+TEST(Mutex, MutexThreaded) {
+    test_counter<sharp::Mutex<>>();
+}
+
+TEST(Mutex, MutexSleeps) {
+    sharp::Mutex<> mutex;
+    mutex.lock();
+
+    // the thread spins past its budget and goes to sleep, and the unlock has
+    // to wake it up
+    std::atomic<bool> acquired{false};
+    auto th = std::thread{[&]() {
+        mutex.lock();
+        acquired.store(true);
+        mutex.unlock();
+    }};
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    EXPECT_FALSE(acquired.load());
+    mutex.unlock();
+    th.join();
+    EXPECT_TRUE(acquired.load());
+}
+
+TEST(Mutex, UniqueLock) {
+    sharp::Mutex<> mutex;
+    {
+        auto lck = sharp::UniqueLock<sharp::Mutex<>>{mutex};
+        EXPECT_TRUE(lck.owns_lock());
+        EXPECT_FALSE(mutex.try_lock());
+    }
+    auto lck = sharp::UniqueLock<sharp::Mutex<>>{mutex, std::try_to_lock};
+    EXPECT_TRUE(lck.owns_lock());
+}
+
+TEST(Mutex, ConcurrentWait) {
+    auto data = sharp::Concurrent<int, sharp::Mutex<>>{0};
+    auto th = std::thread{[&]() {
+        auto lock = data.lock();
+        lock.wait([](auto& value) { return value == 2; });
+        *lock = 3;
+    }};
+
+    data.synchronized([](auto& value) { value = 1; });
+    data.synchronized([](auto& value) { value = 2; });
+    th.join();
+    EXPECT_EQ(*data.lock(), 3);
+}
+
+TEST(Mutex, DistributedSharedMutexBasic) {
+    sharp::DistributedSharedMutex mutex;
+    mutex.lock_shared();
+    EXPECT_TRUE(mutex.try_lock_shared());
+    EXPECT_FALSE(mutex.try_lock());
+    mutex.unlock_shared();
+    mutex.unlock_shared();
+
+    mutex.lock();
+    auto th = std::thread{[&]() {
+        EXPECT_FALSE(mutex.try_lock_shared());
+        EXPECT_FALSE(mutex.try_lock());
+    }};
+    th.join();
+    mutex.unlock();
+    EXPECT_TRUE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST(Mutex, DistributedSharedMutexBackToBackWriters) {
+    // a reader that blocks on one writer must be woken up even if a second
+    // writer takes the lock right after the first one releases it
+    for (auto i = 0; i < 200; ++i) {
+        sharp::DistributedSharedMutex mutex;
+        std::atomic<bool> locked{false};
+
+        mutex.lock();
+        auto reader = std::thread{[&]() {
+            mutex.lock_shared();
+            locked.store(true);
+            mutex.unlock_shared();
+        }};
+        for (auto j = 0; j < i % 20; ++j) {
+            std::this_thread::yield();
+        }
+        mutex.unlock();
+        mutex.lock();
+        mutex.unlock();
+
+        reader.join();
+        EXPECT_TRUE(locked.load());
+    }
+}
+
+TEST(Mutex, DistributedSharedMutexThreaded) {
+    constexpr auto READERS = 4;
+    constexpr auto WRITES = 200;
+
+    // the writers keep the two values equal, readers should never see them
+    // differ
+    auto data = sharp::Concurrent<std::pair<int, int>,
+                                  sharp::DistributedSharedMutex>{};
+    std::atomic<bool> done{false};
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < READERS; ++i) {
+        threads.emplace_back([&]() {
+            while (!done.load()) {
+                auto lock = sharp::as_const(data).lock();
+                EXPECT_EQ(lock->first, lock->second);
+            }
+        });
+    }
+    for (auto i = 0; i < WRITES; ++i) {
+        auto lock = data.lock();
+        ++lock->first;
+        std::this_thread::yield();
+        ++lock->second;
+    }
+    done.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto lock = sharp::as_const(data).lock();
+    EXPECT_EQ(lock->first, WRITES);
+    EXPECT_EQ(lock->second, WRITES);
+}
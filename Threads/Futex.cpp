@@ -0,0 +1,110 @@
+#include <sharp/Threads/Futex.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#if defined(__linux__)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace sharp {
+
+#if defined(__linux__)
+
+namespace {
+
+    int* address(std::atomic<std::uint32_t>& word) {
+        static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(int),
+                "futex words have to be 32 bits wide");
+        return reinterpret_cast<int*>(&word);
+    }
+
+} // namespace anonymous
+
+void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) {
+    // the kernel does the compare and sleep atomically, an error here is
+    // either EAGAIN (the value changed) or EINTR both of which look like a
+    // spurious wakeup to the caller
+    syscall(SYS_futex, address(word), FUTEX_WAIT_PRIVATE,
+            static_cast<int>(expected), nullptr, nullptr, 0);
+}
+
+bool futex_wait_for(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                    std::chrono::nanoseconds timeout) {
+    // the timeout for FUTEX_WAIT is relative and measured against the
+    // monotonic clock
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    auto spec = timespec{};
+    spec.tv_sec = static_cast<time_t>(seconds.count());
+    spec.tv_nsec = static_cast<long>((timeout - seconds).count());
+    auto result = syscall(SYS_futex, address(word), FUTEX_WAIT_PRIVATE,
+            static_cast<int>(expected), &spec, nullptr, 0);
+    return !((result == -1) && (errno == ETIMEDOUT));
+}
+
+void futex_wake(std::atomic<std::uint32_t>& word, int count) {
+    syscall(SYS_futex, address(word), FUTEX_WAKE_PRIVATE, count, nullptr,
+            nullptr, 0);
+}
+
+#else
+
+namespace {
+
+    /**
+     * A bucket of the parking table, padded to avoid false sharing between
+     * threads sleeping on unrelated words
+     */
+    struct alignas(64) Bucket {
+        std::mutex mtx;
+        std::condition_variable cv;
+    };
+
+    Bucket& bucket(std::atomic<std::uint32_t>& word) {
+        static Bucket buckets[64];
+        auto hash = std::hash<void*>{}(static_cast<void*>(&word));
+        return buckets[hash % 64];
+    }
+
+} // namespace anonymous
+
+void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) {
+    auto& b = bucket(word);
+    auto lck = std::unique_lock<std::mutex>{b.mtx};
+    if (word.load() != expected) {
+        return;
+    }
+    b.cv.wait(lck);
+}
+
+bool futex_wait_for(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                    std::chrono::nanoseconds timeout) {
+    auto& b = bucket(word);
+    auto lck = std::unique_lock<std::mutex>{b.mtx};
+    if (word.load() != expected) {
+        return true;
+    }
+    return b.cv.wait_for(lck, timeout) == std::cv_status::no_timeout;
+}
+
+void futex_wake(std::atomic<std::uint32_t>& word, int) {
+    // acquiring the lock orders this wake after a waiter that saw the old
+    // value has gone to sleep on the condition variable, and since unrelated
+    // words can share a bucket everyone is woken up
+    auto& b = bucket(word);
+    { auto lck = std::unique_lock<std::mutex>{b.mtx}; }
+    b.cv.notify_all();
+}
+
+#endif
+
+} // namespace sharp
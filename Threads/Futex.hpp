@@ -0,0 +1,53 @@
+/**
+ * @file Futex.hpp
+ * @author Aaryaman Sagar
+ *
+ * Futex style waiting and waking on 32 bit atomic words.  On Linux these
+ * map directly to the futex system call, on other platforms they fall back
+ * to a fixed size table of mutexes and condition variables that is indexed
+ * by the address of the word
+ *
+ * This is meant to be used as the slow path of synchronization primitives
+ * that do all of their fast path work with atomic operations, and only need
+ * to put a thread to sleep once there is nothing else to do
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace sharp {
+
+/**
+ * Puts the calling thread to sleep as long as the word contains the expected
+ * value.  The check and the going to sleep happen atomically with respect to
+ * futex_wake(), so a thread that changes the value of the word and then calls
+ * futex_wake() will never be missed
+ *
+ * This can return spuriously, so callers should always recheck their
+ * condition in a loop
+ *
+ *      while (word.load() == expected) {
+ *          sharp::futex_wait(word, expected);
+ *      }
+ */
+void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected);
+
+/**
+ * Same as futex_wait() but gives up after the timeout, returns false if the
+ * timeout expired.  This too can return spuriously before the timeout
+ */
+bool futex_wait_for(std::atomic<std::uint32_t>& word, std::uint32_t expected,
+                    std::chrono::nanoseconds timeout);
+
+/**
+ * Wakes up at most count threads that are sleeping on the word in a call to
+ * futex_wait()
+ */
+void futex_wake(std::atomic<std::uint32_t>& word,
+                int count = std::numeric_limits<int>::max());
+
+} // namespace sharp
@@ -0,0 +1,168 @@
+#include <sharp/Threads/ParkingLot.hpp>
+#include <sharp/Threads/Futex.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace sharp {
+
+namespace {
+
+    /**
+     * The number of buckets in the table, addresses that hash to the same
+     * bucket share a mutex and a queue but are otherwise independent
+     */
+    constexpr auto NUMBER_BUCKETS = std::size_t{1024};
+
+    /**
+     * A parked thread, this lives in the frame of the thread that is parked
+     * and is linked into the queue of its bucket for as long as it is parked
+     */
+    struct WaitNode {
+        explicit WaitNode(const void* address_in) : address{address_in} {}
+
+        const void* address;
+        std::atomic<std::uint32_t> signalled{0};
+        WaitNode* next{nullptr};
+        WaitNode* prev{nullptr};
+    };
+
+    /**
+     * A bucket of the table, padded so that threads parking on unrelated
+     * addresses do not share a cache line
+     */
+    struct alignas(64) Bucket {
+        void push_back(WaitNode* node) {
+            node->prev = this->tail;
+            if (this->tail) {
+                this->tail->next = node;
+            } else {
+                this->head = node;
+            }
+            this->tail = node;
+        }
+
+        void erase(WaitNode* node) {
+            if (node->prev) {
+                node->prev->next = node->next;
+            } else {
+                this->head = node->next;
+            }
+            if (node->next) {
+                node->next->prev = node->prev;
+            } else {
+                this->tail = node->prev;
+            }
+            node->next = nullptr;
+            node->prev = nullptr;
+        }
+
+        std::mutex mtx;
+        WaitNode* head{nullptr};
+        WaitNode* tail{nullptr};
+    };
+
+    Bucket& bucket(const void* address) {
+        static Bucket buckets[NUMBER_BUCKETS];
+
+        // addresses of aligned objects have their low bits all zero, a
+        // multiplicative hash spreads them over the whole table
+        auto hash = static_cast<std::uint64_t>(
+            std::hash<const void*>{}(address)) * 0x9e3779b97f4a7c15;
+        return buckets[(hash >> 32) % NUMBER_BUCKETS];
+    }
+
+    /**
+     * Wakes up a node that has been taken off its queue, this is called
+     * with the lock on the bucket held.  The parked thread acquires the same
+     * lock before it returns, so the node stays alive till this is done
+     */
+    void signal(WaitNode* node) {
+        node->signalled.store(1, std::memory_order_release);
+        sharp::futex_wake(node->signalled, 1);
+    }
+
+} // namespace anonymous
+
+namespace parking_lot_detail {
+
+    ParkResult park(const void* address,
+                    bool (*validate)(void*), void* validate_object,
+                    const std::chrono::steady_clock::time_point* deadline) {
+        auto& b = bucket(address);
+        WaitNode node{address};
+
+        {
+            auto lck = std::unique_lock<std::mutex>{b.mtx};
+            if (!validate(validate_object)) {
+                return ParkResult::Invalid;
+            }
+            b.push_back(&node);
+        }
+
+        // sleep till signalled, futex_wait() can return spuriously so this
+        // loops on the word
+        auto timed_out = false;
+        while (!node.signalled.load(std::memory_order_acquire)) {
+            if (!deadline) {
+                sharp::futex_wait(node.signalled, 0);
+                continue;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (now >= *deadline) {
+                timed_out = true;
+                break;
+            }
+            sharp::futex_wait_for(node.signalled, 0, *deadline - now);
+        }
+
+        // either wait for the thread that signalled this node to be done
+        // with it, or take the node off the queue if nobody has signalled it
+        // yet.  A node that was signalled right as the deadline passed
+        // counts as unparked, since the thread that unparked it expects the
+        // wakeup to be consumed
+        auto lck = std::unique_lock<std::mutex>{b.mtx};
+        if (timed_out && !node.signalled.load(std::memory_order_relaxed)) {
+            b.erase(&node);
+            return ParkResult::Timeout;
+        }
+        return ParkResult::Unparked;
+    }
+
+} // namespace parking_lot_detail
+
+bool unpark_one(const void* address) {
+    auto& b = bucket(address);
+    auto lck = std::unique_lock<std::mutex>{b.mtx};
+    for (auto node = b.head; node; node = node->next) {
+        if (node->address == address) {
+            b.erase(node);
+            signal(node);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t unpark_all(const void* address) {
+    auto& b = bucket(address);
+    auto lck = std::unique_lock<std::mutex>{b.mtx};
+    auto woken = std::size_t{0};
+    for (auto node = b.head; node;) {
+        auto next = node->next;
+        if (node->address == address) {
+            b.erase(node);
+            signal(node);
+            ++woken;
+        }
+        node = next;
+    }
+    return woken;
+}
+
+} // namespace sharp
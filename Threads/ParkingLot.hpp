@@ -0,0 +1,88 @@
+/**
+ * @file ParkingLot.hpp
+ * @author Aaryaman Sagar
+ *
+ * A process wide table of sleeping threads keyed by address.  This lets any
+ * object put threads to sleep on itself without having to carry a mutex and
+ * a condition variable around, a lock can be a couple of bits and still
+ * support blocking
+ *
+ * The table is split into buckets by a hash of the address, each bucket has
+ * a mutex and a queue of the threads parked on addresses that hash to it.
+ * Each parked thread sleeps on a futex word in its own stack frame, so
+ * waking one thread up never disturbs the others
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace sharp {
+
+/**
+ * The outcome of a call to park()
+ *
+ *      Unparked - the thread was woken up by unpark_one() or unpark_all()
+ *      Invalid  - the validation function returned false, the thread never
+ *                 went to sleep
+ *      Timeout  - the deadline passed before the thread was unparked
+ */
+enum class ParkResult {
+    Unparked,
+    Invalid,
+    Timeout,
+};
+
+/**
+ * Parks the calling thread on the address till another thread unparks it.
+ * The validation function is run with the lock on the bucket for the
+ * address held, and the thread only goes to sleep if it returns true.
+ * Since unpark_one() and unpark_all() acquire the same lock, a thread that
+ * changes some state and then unparks the address can never miss a thread
+ * that saw the old state in its validation function
+ *
+ *      // waiter
+ *      while (!ready.load()) {
+ *          sharp::park(&ready, [&]() { return !ready.load(); });
+ *      }
+ *
+ *      // waker
+ *      ready.store(true);
+ *      sharp::unpark_all(&ready);
+ *
+ * A thread only returns Unparked when another thread unparked its address.
+ * Unparking only uses the address though, and an address can be reused by a
+ * new object once the old one is destroyed, so callers should recheck their
+ * condition in a loop as above.  The validation function should be short
+ * and must not park or unpark anything, since it runs with the bucket locked
+ */
+template <typename Validate>
+ParkResult park(const void* address, Validate validate);
+
+/**
+ * Same as park() but gives up and returns ParkResult::Timeout once the
+ * deadline has passed or the duration has elapsed
+ */
+template <typename Validate, typename Clock, typename Duration>
+ParkResult park_until(const void* address, Validate validate,
+                      const std::chrono::time_point<Clock, Duration>& tp);
+template <typename Validate, typename Rep, typename Period>
+ParkResult park_for(const void* address, Validate validate,
+                    const std::chrono::duration<Rep, Period>& duration);
+
+/**
+ * Wakes up the thread that has been parked on the address the longest, and
+ * returns whether there was one
+ */
+bool unpark_one(const void* address);
+
+/**
+ * Wakes up all the threads that are parked on the address and returns how
+ * many there were
+ */
+std::size_t unpark_all(const void* address);
+
+} // namespace sharp
+
+#include <sharp/Threads/ParkingLot.ipp>
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <sharp/Threads/ParkingLot.hpp>
+
+#include <chrono>
+#include <utility>
+
+namespace sharp {
+namespace parking_lot_detail {
+
+    /**
+     * The type erased implementation of park(), the validation function is
+     * passed as a function pointer and a pointer to the callable.  A null
+     * deadline means that the thread does not time out
+     */
+    ParkResult park(const void* address,
+                    bool (*validate)(void*), void* validate_object,
+                    const std::chrono::steady_clock::time_point* deadline);
+
+    template <typename Validate>
+    bool validate_stub(void* validate) {
+        return (*static_cast<Validate*>(validate))();
+    }
+
+} // namespace parking_lot_detail
+
+template <typename Validate>
+ParkResult park(const void* address, Validate validate) {
+    return parking_lot_detail::park(address,
+            &parking_lot_detail::validate_stub<Validate>,
+            static_cast<void*>(&validate), nullptr);
+}
+
+template <typename Validate, typename Clock, typename Duration>
+ParkResult park_until(const void* address, Validate validate,
+                      const std::chrono::time_point<Clock, Duration>& tp) {
+    // the implementation sleeps against the steady clock, so translate the
+    // deadline into it
+    auto deadline = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                tp - Clock::now());
+    return parking_lot_detail::park(address,
+            &parking_lot_detail::validate_stub<Validate>,
+            static_cast<void*>(&validate), &deadline);
+}
+
+template <typename Validate, typename Rep, typename Period>
+ParkResult park_for(const void* address, Validate validate,
+                    const std::chrono::duration<Rep, Period>& duration) {
+    return park_until(address, std::move(validate),
+            std::chrono::steady_clock::now() + duration);
+}
+
+} // namespace sharp
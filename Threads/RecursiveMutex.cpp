@@ -1,76 +1,97 @@
 #include <sharp/Threads/RecursiveMutex.hpp>
+#include <sharp/Threads/ParkingLot.hpp>
 
-#include <thread>
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <stdexcept>
 
 namespace sharp {
 
 void RecursiveMutex::lock() {
-    // acquire the mutex, increment the counter and then wait on the
-    // condition_variable if this is not the thread that has the lock
-    auto lck = std::unique_lock<std::mutex>{this->mtx};
-
-    // dont block if this is the thread that has the lock, or if the value of
-    // counter is 0 meaning that no thread is holding the lock
-    if (this->is_lock_acquirable()) {
-        this->acquire_lock();
+    // dont block if this is the thread that has the lock, or if no thread is
+    // holding the lock
+    if (this->try_lock()) {
         return;
     }
-
-    // else block on the condition_variable
-    while (counter) {
-        this->cv.wait(lck);
-    }
-
-    this->acquire_lock();
+    this->lock_slow(nullptr);
 }
 
 void RecursiveMutex::unlock() {
-    auto lck = std::unique_lock<std::mutex>{this->mtx};
-
     // check if the thread that releases the lock is the current thread, if it
     // is not then do not risk undefined POSIX behavior and throw an
     // exception, this is justified becasue the mutex already knows which
     // thread has the lock
-    if (!counter) {
+    auto owner = this->owner.load(std::memory_order_relaxed);
+    if (!owner) {
         throw std::runtime_error{"sharp::RecursiveMutex::unlock() called when "
             "the mutex is already unlocked"};
     }
-    if (std::this_thread::get_id() != this->thread_holding_lock) {
+    if (owner != current_thread()) {
         throw std::runtime_error{"sharp::RecursiveMutex::unlock() called from "
             "a thread that does not hold the lock"};
     }
 
-    // decrement the counter and then notify on the condtion variable if the
-    // counter has reached 0
-    --counter;
-    if (!counter) {
-        this->cv.notify_one();
+    // decrement the counter and then release the lock and unpark a waiter if
+    // the counter has reached 0.  The store and the load of the number of
+    // waiters are sequentially consistent, so either this sees a thread that
+    // is about to park, or that thread sees the lock free when it validates
+    if (--this->counter) {
+        return;
+    }
+    this->owner.store(0, std::memory_order_seq_cst);
+    if (this->waiters.load(std::memory_order_seq_cst)) {
+        sharp::unpark_one(this);
     }
 }
 
 bool RecursiveMutex::try_lock() {
-    auto lck = std::unique_lock<std::mutex>{this->mtx};
-
-    // either acquire the lock if the current thread is holding the lock
-    // already or if the lock is free
-    if (this->is_lock_acquirable()) {
-        this->acquire_lock();
+    // only the owning thread can ever store its own identifier in the owner
+    // word, so if it is there this thread holds the lock and nobody else can
+    // touch the counter
+    auto id = current_thread();
+    if (this->owner.load(std::memory_order_relaxed) == id) {
+        ++this->counter;
         return true;
     }
+    return this->try_lock_fast(id);
+}
 
+bool RecursiveMutex::try_lock_fast(std::uintptr_t id) {
+    auto expected = std::uintptr_t{0};
+    if (this->owner.compare_exchange_strong(expected, id,
+                std::memory_order_acquire, std::memory_order_relaxed)) {
+        this->counter = 1;
+        return true;
+    }
     return false;
 }
 
-bool RecursiveMutex::is_lock_acquirable() const {
-    return this->thread_holding_lock == std::this_thread::get_id() || !counter;
+bool RecursiveMutex::lock_slow(
+        const std::chrono::steady_clock::time_point* deadline) {
+    auto id = current_thread();
+    while (!this->try_lock_fast(id)) {
+        this->waiters.fetch_add(1, std::memory_order_seq_cst);
+        auto validate = [this]() {
+            return this->owner.load(std::memory_order_seq_cst) != 0;
+        };
+        auto result = deadline
+            ? sharp::park_until(this, validate, *deadline)
+            : sharp::park(this, validate);
+        this->waiters.fetch_sub(1, std::memory_order_relaxed);
+
+        if (result == ParkResult::Timeout) {
+            return this->try_lock_fast(id);
+        }
+    }
+    return true;
 }
 
-void RecursiveMutex::acquire_lock() {
-    ++counter;
-    this->thread_holding_lock = std::this_thread::get_id();
+std::uintptr_t RecursiveMutex::current_thread() {
+    // the address of a thread local is unique among running threads and
+    // never null
+    thread_local auto tag = char{};
+    return reinterpret_cast<std::uintptr_t>(&tag);
 }
 
 } // namespace sharp
@@ -2,13 +2,17 @@
  * @file RecursiveMutex.hpp
  * @author Aaryaman Sagar (rmn100@gmail.com)
  *
- * Contains a simple implementation of a recursive mutex implemented around
- * the C++ standard library monitors
+ * Contains a simple implementation of a recursive mutex around an atomic
+ * word that holds the owning thread, threads that have to wait for the lock
+ * park in the parking lot
  */
 
 #pragma once
 
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <mutex>
 #include <thread>
 
@@ -19,11 +23,15 @@ public:
     /**
      * Acquire the lock held internally recursively, so if the same thread
      * that has the lock requests the lock, then this will not block
+     *
+     * Acquiring a free lock is a single compare and swap and acquiring the
+     * lock again from the thread that holds it is a plain increment
      */
     void lock();
 
     /**
-     * release the lock
+     * release the lock, this throws a std::runtime_error if the calling
+     * thread does not hold the lock
      */
     void unlock();
 
@@ -33,29 +41,48 @@ public:
      */
     bool try_lock();
 
+    /**
+     * Timed versions of lock(), these return false if the lock could not be
+     * acquired before the timeout
+     */
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& duration);
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& tp);
+
 private:
     /**
-     * Private functions.  These are not gated with a mutex and should only be
-     * called from within locked contexts
+     * Private functions.  The slow path parks till the lock is free, a null
+     * deadline means that it does not time out
      */
-    void acquire_lock();
-    bool is_lock_acquirable() const;
+    bool lock_slow(const std::chrono::steady_clock::time_point* deadline);
+    bool try_lock_fast(std::uintptr_t id);
 
     /**
-     * private monitor
+     * Returns a non zero identifier for the calling thread, unique among the
+     * threads that are running
      */
-    std::condition_variable cv;
-    std::mutex mtx;
+    static std::uintptr_t current_thread();
 
     /**
-     * The thread id for the thread holding the lock currently
+     * The identifier of the thread holding the lock currently, or 0 if the
+     * lock is free
      */
-    std::thread::id thread_holding_lock;
+    std::atomic<std::uintptr_t> owner{0};
 
     /**
-     * A counter to keep track of whether the lock has been released or not
+     * The number of times the owner has acquired the lock, this is only ever
+     * touched by the owner
      */
-    int counter{0};
+    std::size_t counter{0};
+
+    /**
+     * The number of threads that are parked or about to park, unlock() only
+     * goes to the parking lot when this is not zero
+     */
+    std::atomic<std::uint32_t> waiters{0};
 };
 
 } // namespace sharp
+
+#include <sharp/Threads/RecursiveMutex.ipp>
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <sharp/Threads/RecursiveMutex.hpp>
+
+#include <chrono>
+
+namespace sharp {
+
+template <typename Rep, typename Period>
+bool RecursiveMutex::try_lock_for(
+        const std::chrono::duration<Rep, Period>& duration) {
+    return this->try_lock_until(std::chrono::steady_clock::now() + duration);
+}
+
+template <typename Clock, typename Duration>
+bool RecursiveMutex::try_lock_until(
+        const std::chrono::time_point<Clock, Duration>& tp) {
+    if (this->try_lock()) {
+        return true;
+    }
+
+    // the slow path sleeps against the steady clock, so translate the
+    // deadline into it
+    auto deadline = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                tp - Clock::now());
+    return this->lock_slow(&deadline);
+}
+
+} // namespace sharp
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <sharp/Threads/Futex.hpp>
+#include <sharp/Threads/ParkingLot.hpp>
 #include <sharp/Threads/RecursiveMutex.hpp>
 #include <sharp/Threads/ThreadTest.hpp>
 #include <sharp/Threads/UniqueLock.hpp>
@@ -11,6 +11,9 @@
 #include <iostream>
 #include <string>
 #include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
 auto mark_execution_sequence_point(int);
 
@@ -127,6 +130,49 @@ TEST(RecursiveMutex, exceptions_test_2) {
     } catch (...) {}
 }
 
+TEST(RecursiveMutex, try_lock_for_test) {
+    sharp::RecursiveMutex recursive_mtx;
+    recursive_mtx.lock();
+    EXPECT_TRUE(recursive_mtx.try_lock_for(std::chrono::milliseconds{1}));
+    recursive_mtx.unlock();
+
+    auto th = std::thread{[&]() {
+        EXPECT_FALSE(recursive_mtx.try_lock_for(std::chrono::milliseconds{10}));
+        EXPECT_TRUE(recursive_mtx.try_lock_until(
+                std::chrono::steady_clock::now() + std::chrono::seconds{10}));
+        recursive_mtx.unlock();
+    }};
+
+    // hold the lock past the first timeout and then let the thread have it
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    recursive_mtx.unlock();
+    th.join();
+}
+
+TEST(RecursiveMutex, contended_test) {
+    constexpr auto THREADS = 4;
+    constexpr auto ITERATIONS = 2000;
+
+    sharp::RecursiveMutex recursive_mtx;
+    auto counter = 0;
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < THREADS; ++i) {
+        threads.emplace_back([&]() {
+            for (auto j = 0; j < ITERATIONS; ++j) {
+                auto lck = std::unique_lock<sharp::RecursiveMutex>{
+                    recursive_mtx};
+                auto inner = std::unique_lock<sharp::RecursiveMutex>{
+                    recursive_mtx};
+                ++counter;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(counter, THREADS * ITERATIONS);
+}
+
 TEST(ThreadTest, simple_thread_test_test) {
     for (auto i = 0; i < 100; ++i) {
 
@@ -160,3 +206,98 @@ TEST(ThreadTest, simple_thread_test_test) {
         EXPECT_EQ(str, "ba");
     }
 }
+
+TEST(Threads, FutexWaitWake) {
+    std::atomic<std::uint32_t> word{0};
+
+    // a wait on a stale value returns right away
+    sharp::futex_wait(word, 1);
+
+    for (auto i = 0; i < 100; ++i) {
+        auto th = std::thread{[&]() {
+            while (word.load() == static_cast<std::uint32_t>(i)) {
+                sharp::futex_wait(word, i);
+            }
+        }};
+
+        word.fetch_add(1);
+        sharp::futex_wake(word);
+        th.join();
+    }
+    EXPECT_EQ(word.load(), 100);
+}
+
+TEST(Threads, FutexWaitFor) {
+    std::atomic<std::uint32_t> word{0};
+    EXPECT_TRUE(sharp::futex_wait_for(word, 1, std::chrono::seconds{1}));
+
+    auto start = std::chrono::steady_clock::now();
+    while (sharp::futex_wait_for(word, 0, std::chrono::milliseconds{10})) {}
+    EXPECT_GE(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds{10});
+
+    auto th = std::thread{[&]() {
+        while (!word.load()) {
+            sharp::futex_wait_for(word, 0, std::chrono::seconds{10});
+        }
+    }};
+    word.store(1);
+    sharp::futex_wake(word);
+    th.join();
+}
+
+TEST(Threads, ParkInvalid) {
+    auto address = 0;
+    EXPECT_EQ(sharp::park(&address, []() { return false; }),
+              sharp::ParkResult::Invalid);
+    EXPECT_FALSE(sharp::unpark_one(&address));
+    EXPECT_EQ(sharp::unpark_all(&address), 0);
+}
+
+TEST(Threads, ParkTimeout) {
+    auto address = 0;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(sharp::park_for(&address, []() { return true; },
+                              std::chrono::milliseconds{10}),
+              sharp::ParkResult::Timeout);
+    EXPECT_GE(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds{10});
+
+    // the timed out thread is no longer in the parking lot
+    EXPECT_FALSE(sharp::unpark_one(&address));
+}
+
+TEST(Threads, ParkUnpark) {
+    constexpr auto THREADS = 4;
+
+    // threads parked on another address are not woken up
+    std::atomic<int> ready{0};
+    std::atomic<int> unparked{0};
+    auto address = 0;
+    auto other = 0;
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < THREADS; ++i) {
+        threads.emplace_back([&]() {
+            auto result = sharp::park(&address, [&]() {
+                ready.fetch_add(1);
+                return true;
+            });
+            EXPECT_EQ(result, sharp::ParkResult::Unparked);
+            unparked.fetch_add(1);
+        });
+    }
+    while (ready.load() != THREADS) {
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(sharp::unpark_one(&other));
+
+    EXPECT_TRUE(sharp::unpark_one(&address));
+    while (unparked.load() != 1) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(sharp::unpark_all(&address), THREADS - 1);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(unparked.load(), THREADS);
+}
@@ -23,6 +23,7 @@
 #include <sharp/Portability/cpp17.hpp>
 
 #include <utility>
+#include <cstddef>
 #include <cassert>
 #include <iterator>
 #include <initializer_list>
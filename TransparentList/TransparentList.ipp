@@ -264,19 +264,15 @@ TransparentList<Type>::erase(TransparentList<Type>::NodeIterator iterator)
         iterator.node_ptr->prev->next = iterator.node_ptr->next;
     }
 
-    // if this was the only node in the list then erase it and set the head
-    // and tail pointers to null
+    // move the head and tail pointers off the node if it was at either end,
+    // if this was the only node in the list then both end up null
     if (this->head == iterator.node_ptr) {
-        this->head = this->head->next;
-
-        // if the tail was equal to the head then there was only one element
-        if (this->tail == iterator.node_ptr) {
-            assert(!this->head);
-            this->tail = nullptr;
-        }
-        return iterator_to_return;
+        this->head = iterator.node_ptr->next;
+    }
+    if (this->tail == iterator.node_ptr) {
+        this->tail = iterator.node_ptr->prev;
     }
-    assert(this->tail != this->head);
+    assert(!this->head == !this->tail);
     return iterator_to_return;
 }
 
@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <iostream>
@@ -170,6 +171,28 @@ TEST(TransparentList, test_erase) {
     }));
 }
 
+TEST(TransparentList, test_erase_tail) {
+    auto list = sharp::TransparentList<int>{};
+    auto one = TransparentNode<int>{std::in_place, 1};
+    auto two = TransparentNode<int>{std::in_place, 2};
+    auto three = TransparentNode<int>{std::in_place, 3};
+    list.push_back(&one);
+    list.push_back(&two);
+
+    // erasing the last node should make the one before it the tail
+    list.erase(std::find_if(list.begin(), list.end(), [](auto node) {
+        return node->datum == 2;
+    }));
+    list.push_back(&three);
+    list.push_back(&two);
+
+    auto values = std::vector<int>{};
+    for (auto node : list) {
+        values.push_back(node->datum);
+    }
+    EXPECT_EQ(values, (std::vector<int>{1, 3, 2}));
+}
+
 TEST(TransparentList, test_increment_decrement_iterators) {
     auto list = sharp::TransparentList<int>{};
     auto vec = vector<unique_ptr<TransparentNode<int>>>{};
@@ -146,6 +146,20 @@ public:
  */
 class LessPtr;
 
+/**
+ * @class Unit
+ *
+ * A type with exactly one value, used in place of void where a type that
+ * can be stored and passed around is needed.  For example a Future<Unit> is
+ * a future that only signals completion
+ *
+ *      auto future = channel.async_send(1);
+ *      future.get();
+ */
+class Unit {};
+inline constexpr bool operator==(Unit, Unit) noexcept { return true; }
+inline constexpr bool operator!=(Unit, Unit) noexcept { return false; }
+
 /**
  * @class VariantMonad
  *